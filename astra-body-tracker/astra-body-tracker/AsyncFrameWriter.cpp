@@ -0,0 +1,138 @@
+#include "AsyncFrameWriter.h"
+#include <chrono>
+#include <iostream>
+
+AsyncFrameWriter::AsyncFrameWriter(size_t capacity)
+	: ring_(capacity),
+	  batchTiming_(ring_.capacity()),
+	  batchFrames_(ring_.capacity())
+{
+}
+
+AsyncFrameWriter::~AsyncFrameWriter()
+{
+	stop();
+}
+
+void AsyncFrameWriter::add_sink(FrameSink& sink)
+{
+	sinks_.push_back(&sink);
+}
+
+void AsyncFrameWriter::set_metrics(PipelineMetrics* metrics)
+{
+	metrics_ = metrics;
+}
+
+void AsyncFrameWriter::start()
+{
+	if (running_.exchange(true))
+		return;
+	thread_ = std::thread(&AsyncFrameWriter::run, this);
+}
+
+void AsyncFrameWriter::stop()
+{
+	if (!running_.exchange(false))
+		return;
+	wake_.notify_one();
+	thread_.join();
+}
+
+FrameRecord* AsyncFrameWriter::begin_frame(bool wait)
+{
+	FrameRecord* slot = ring_.begin_push();
+	while (!slot && wait && running_.load()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		slot = ring_.begin_push();
+	}
+
+	if (!slot)
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+	return slot;
+}
+
+void AsyncFrameWriter::commit_frame()
+{
+	ring_.end_push();
+	wake_.notify_one();
+}
+
+void AsyncFrameWriter::run()
+{
+	auto lastReport = std::chrono::steady_clock::now();
+
+	while (running_.load()) {
+		if (drain() == 0) {
+			// The producer notifies without taking the lock, so a wakeup can be
+			// missed; the timeout bounds how long that frame waits.
+			std::unique_lock<std::mutex> lock(wakeMutex_);
+			wake_.wait_for(lock, std::chrono::milliseconds(5));
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		if (now - lastReport >= std::chrono::seconds(5)) {
+			report_overflow();
+			lastReport = now;
+		}
+		if (metrics_)
+			metrics_->maybe_report(pipeline_clock_us());
+	}
+
+	drain();
+	report_overflow();
+}
+
+size_t AsyncFrameWriter::drain()
+{
+	size_t count = 0;
+
+	// A batch is at most one ring's worth, so a fast producer cannot postpone the flush forever
+	while (count < ring_.capacity()) {
+		FrameRecord* record = ring_.front();
+		if (!record)
+			break;
+
+		if (metrics_) {
+			batchFrames_[count] = record->timing;
+			batchTiming_[count].dequeuedUs = pipeline_clock_us();
+		}
+		for (FrameSink* sink : sinks_)
+			sink->consume(*record);
+		if (metrics_)
+			batchTiming_[count].encodedUs = pipeline_clock_us();
+
+		ring_.pop();
+		count++;
+	}
+
+	if (count == 0)
+		return 0;
+
+	uint64_t flushStartUs = metrics_ ? pipeline_clock_us() : 0;
+	for (FrameSink* sink : sinks_)
+		sink->flush();
+
+	if (metrics_) {
+		uint64_t writtenUs = pipeline_clock_us();
+		for (size_t i = 0; i < count; i++) {
+			batchTiming_[i].flushStartUs = flushStartUs;
+			batchTiming_[i].writtenUs = writtenUs;
+			metrics_->add(batchFrames_[i], batchTiming_[i]);
+		}
+	}
+
+	written_.fetch_add(count, std::memory_order_relaxed);
+	return count;
+}
+
+void AsyncFrameWriter::report_overflow()
+{
+	uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+	if (dropped == reportedDropped_)
+		return;
+
+	std::cerr << "output ring overflow: " << (dropped - reportedDropped_)
+		<< " frames dropped (" << dropped << " total)" << std::endl;
+	reportedDropped_ = dropped;
+}
@@ -0,0 +1,75 @@
+#ifndef ASYNCFRAMEWRITER_H
+#define ASYNCFRAMEWRITER_H
+
+#include "FrameRecord.h"
+#include "FrameSink.h"
+#include "PipelineMetrics.h"
+#include "SpscRing.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	Moves encoding and writing off the SDK callback.
+
+	The callback fills a preallocated FrameRecord slot and returns; a writer thread
+	drains every frame that is ready into each sink and flushes the sinks once per
+	batch. When the consumer falls behind the ring fills up and new frames are
+	dropped and counted instead of stalling astra_update().
+*/
+class AsyncFrameWriter
+{
+public:
+	explicit AsyncFrameWriter(size_t capacity = 64);
+	~AsyncFrameWriter();
+
+	AsyncFrameWriter(const AsyncFrameWriter&) = delete;
+	AsyncFrameWriter& operator=(const AsyncFrameWriter&) = delete;
+
+	// Sinks must be added before start() and outlive the writer thread
+	void add_sink(FrameSink& sink);
+
+	// Optional, same rules as sinks. Fed from the writer thread only; the
+	// owner writes the final report once the writer and its channels stop.
+	void set_metrics(PipelineMetrics* metrics);
+
+	void start();
+
+	// Writes whatever is still queued, then joins the writer thread
+	void stop();
+
+	// Producer side, called from on_frame_ready. Returns nullptr and counts an
+	// overflow when the ring is full. With wait set it instead waits for the writer
+	// to catch up, which only offline producers such as replay should do.
+	FrameRecord* begin_frame(bool wait = false);
+	void commit_frame();
+
+	uint64_t written_frames() const { return written_.load(std::memory_order_relaxed); }
+	uint64_t dropped_frames() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	void run();
+	size_t drain();
+	void report_overflow();
+
+	SpscRing<FrameRecord> ring_;
+	std::vector<FrameSink*> sinks_;
+
+	PipelineMetrics* metrics_ = nullptr;
+	std::vector<WriterTiming> batchTiming_;
+	std::vector<FrameTiming> batchFrames_;
+
+	std::thread thread_;
+	std::atomic<bool> running_{ false };
+	std::mutex wakeMutex_;
+	std::condition_variable wake_;
+
+	std::atomic<uint64_t> written_{ 0 };
+	std::atomic<uint64_t> dropped_{ 0 };
+	uint64_t reportedDropped_ = 0;
+};
+
+#endif /* ASYNCFRAMEWRITER_H */
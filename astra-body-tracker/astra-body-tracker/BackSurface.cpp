@@ -0,0 +1,361 @@
+#include "BackSurface.h"
+#include <algorithm>
+#include <emmintrin.h>
+#include <fstream>
+#include <math.h>
+
+static const uint32_t SPINE_JOINTS = (1u << ASTRA_JOINT_BASE_SPINE) | (1u << ASTRA_JOINT_MID_SPINE)
+	| (1u << ASTRA_JOINT_SHOULDER_SPINE);
+
+// Shorter spines are a tracking glitch, not a person
+static const float MIN_SPINE_LENGTH = 100.0f;
+
+// Points projected per block, which keeps the projection buffers in L1
+static const size_t PROJECTION_BLOCK = 1024;
+
+static float dot(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void write_number(std::ostream& out, double value)
+{
+	if (isfinite(value))
+		out << value;
+	else
+		out << "null";
+}
+
+BackSurfaceAnalyzer::BackSurfaceAnalyzer(const BackSurfaceSettings& settings, const std::string& outputPath,
+	std::ostream& report)
+	: settings_(settings),
+	columns_(2 * settings.halfColumns),
+	outputPath_(outputPath),
+	report_(report),
+	centreRight_(settings.rows),
+	centreToward_(settings.rows),
+	along_(PROJECTION_BLOCK),
+	across_(PROJECTION_BLOCK),
+	height_(PROJECTION_BLOCK),
+	frameSum_(static_cast<size_t>(settings.rows) * columns_),
+	frameCount_(frameSum_.size()),
+	heightSum_(frameSum_.size(), 0.0),
+	heightFrames_(frameSum_.size(), 0)
+{
+}
+
+void BackSurfaceAnalyzer::consume(const SegmentedFrame& frame)
+{
+	const BodyRecord* patient = choose_patient(frame);
+	if (!patient)
+		return;
+
+	for (uint32_t i = 0; i < frame.segmentCount; i++) {
+		if (frame.segments[i].bodyId == patient->id) {
+			add_frame(frame.segments[i], *patient);
+			return;
+		}
+	}
+}
+
+const BodyRecord* BackSurfaceAnalyzer::choose_patient(const SegmentedFrame& frame)
+{
+	if (!frame.depth)
+		return nullptr;
+
+	const BodyRecord* bodies = frame.depth.bodies();
+	uint32_t count = frame.depth.body_count();
+
+	const BodyRecord* nearest = nullptr;
+	for (uint32_t i = 0; i < count; i++) {
+		const BodyRecord& body = bodies[i];
+		if (body.status != ASTRA_BODY_STATUS_TRACKING || (body.jointMask & SPINE_JOINTS) != SPINE_JOINTS)
+			continue;
+
+		bool segmented = false;
+		for (uint32_t s = 0; s < frame.segmentCount; s++)
+			segmented = segmented || frame.segments[s].bodyId == body.id;
+		if (!segmented)
+			continue;
+
+		if (body.id == patientId_)
+			return &body;
+		if (!nearest || body.joints[ASTRA_JOINT_BASE_SPINE][2] < nearest->joints[ASTRA_JOINT_BASE_SPINE][2])
+			nearest = &body;
+	}
+
+	if (nearest)
+		patientId_ = nearest->id;
+	return nearest;
+}
+
+bool BackSurfaceAnalyzer::add_frame(const BodySegment& segment, const BodyRecord& body)
+{
+	if ((body.jointMask & SPINE_JOINTS) != SPINE_JOINTS)
+		return false;
+
+	const float* base = body.joints[ASTRA_JOINT_BASE_SPINE];
+	const float* mid = body.joints[ASTRA_JOINT_MID_SPINE];
+	const float* shoulder = body.joints[ASTRA_JOINT_SHOULDER_SPINE];
+
+	float up[3] = { shoulder[0] - base[0], shoulder[1] - base[1], shoulder[2] - base[2] };
+	float length = sqrtf(dot(up, up));
+	if (length < MIN_SPINE_LENGTH)
+		return false;
+
+	// Across is horizontal in the image: up x (0, 0, 1), which points to the
+	// patient's right when their back faces the sensor
+	float right[3] = { up[1], -up[0], 0 };
+	float rightLength = sqrtf(dot(right, right));
+	if (rightLength < 0.5f * length)
+		return false;
+
+	for (int k = 0; k < 3; k++) {
+		base_[k] = base[k];
+		up_[k] = up[k] / length;
+		right_[k] = right[k] / rightLength;
+	}
+	toward_[0] = up_[1] * right_[2] - up_[2] * right_[1];
+	toward_[1] = up_[2] * right_[0] - up_[0] * right_[2];
+	toward_[2] = up_[0] * right_[1] - up_[1] * right_[0];
+	rowsPerMm_ = settings_.rows / length;
+
+	// The spine line bends at MidSpine; a MidSpine outside the segment is
+	// ignored and the line runs straight
+	float midOffset[3] = { mid[0] - base[0], mid[1] - base[1], mid[2] - base[2] };
+	float midAlong = dot(midOffset, up_);
+	bool bent = midAlong > 0 && midAlong < length;
+
+	for (int r = 0; r < settings_.rows; r++) {
+		float along = (r + 0.5f) * length / settings_.rows;
+		float centre[3];
+		for (int k = 0; k < 3; k++) {
+			if (!bent)
+				centre[k] = base[k] + up_[k] * along;
+			else if (along < midAlong)
+				centre[k] = base[k] + (mid[k] - base[k]) * (along / midAlong);
+			else
+				centre[k] = mid[k] + (shoulder[k] - mid[k]) * ((along - midAlong) / (length - midAlong));
+		}
+		centreRight_[r] = dot(centre, right_);
+		centreToward_[r] = dot(centre, toward_);
+	}
+
+	std::fill(frameSum_.begin(), frameSum_.end(), 0.0f);
+	std::fill(frameCount_.begin(), frameCount_.end(), 0);
+
+	const float halfColumns = static_cast<float>(settings_.halfColumns);
+	const float cellsPerMm = 1.0f / settings_.cellWidth;
+	for (size_t begin = 0; begin < segment.pointCount; begin += PROJECTION_BLOCK) {
+		size_t count = segment.pointCount - begin < PROJECTION_BLOCK ? segment.pointCount - begin : PROJECTION_BLOCK;
+		project(segment, begin, count);
+
+		for (size_t i = 0; i < count; i++) {
+			// Written so NaN fails the range checks too
+			float row = along_[i] * rowsPerMm_;
+			if (!(row >= 0 && row < settings_.rows))
+				continue;
+			int r = static_cast<int>(row);
+
+			float column = (across_[i] - centreRight_[r]) * cellsPerMm + halfColumns;
+			if (!(column >= 0 && column < columns_))
+				continue;
+
+			float height = height_[i] - centreToward_[r];
+			if (fabsf(height) > settings_.maxHeight)
+				continue;
+
+			size_t cell = static_cast<size_t>(r) * columns_ + static_cast<int>(column);
+			frameSum_[cell] += height;
+			frameCount_[cell]++;
+		}
+	}
+
+	for (size_t cell = 0; cell < frameSum_.size(); cell++) {
+		if (frameCount_[cell] < static_cast<uint32_t>(settings_.minCellPoints))
+			continue;
+		heightSum_[cell] += frameSum_[cell] / frameCount_[cell];
+		heightFrames_[cell]++;
+	}
+
+	frames_++;
+	spineLengthSum_ += length;
+	return true;
+}
+
+// Coordinates of count points from begin on the spine frame: distance along
+// the spine from BaseSpine, and absolute position on the right and toward axes
+void BackSurfaceAnalyzer::project(const BodySegment& segment, size_t begin, size_t count)
+{
+	const float* x = segment.x.data() + begin;
+	const float* y = segment.y.data() + begin;
+	const float* z = segment.z.data() + begin;
+
+	const __m128 bx = _mm_set1_ps(base_[0]), by = _mm_set1_ps(base_[1]), bz = _mm_set1_ps(base_[2]);
+	const __m128 ux = _mm_set1_ps(up_[0]), uy = _mm_set1_ps(up_[1]), uz = _mm_set1_ps(up_[2]);
+	const __m128 rx = _mm_set1_ps(right_[0]), ry = _mm_set1_ps(right_[1]), rz = _mm_set1_ps(right_[2]);
+	const __m128 tx = _mm_set1_ps(toward_[0]), ty = _mm_set1_ps(toward_[1]), tz = _mm_set1_ps(toward_[2]);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+		__m128 dx = _mm_sub_ps(px, bx), dy = _mm_sub_ps(py, by), dz = _mm_sub_ps(pz, bz);
+
+		__m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ux), _mm_mul_ps(dy, uy)), _mm_mul_ps(dz, uz));
+		__m128 across = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, rx), _mm_mul_ps(py, ry)), _mm_mul_ps(pz, rz));
+		__m128 height = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, tx), _mm_mul_ps(py, ty)), _mm_mul_ps(pz, tz));
+
+		_mm_storeu_ps(&along_[i], along);
+		_mm_storeu_ps(&across_[i], across);
+		_mm_storeu_ps(&height_[i], height);
+	}
+
+	for (; i < count; i++) {
+		float p[3] = { x[i], y[i], z[i] };
+		float d[3] = { x[i] - base_[0], y[i] - base_[1], z[i] - base_[2] };
+		along_[i] = dot(d, up_);
+		across_[i] = dot(p, right_);
+		height_[i] = dot(p, toward_);
+	}
+}
+
+float BackSurfaceAnalyzer::height(int row, int column) const
+{
+	size_t cell = static_cast<size_t>(row) * columns_ + column;
+	return heightFrames_[cell] ? static_cast<float>(heightSum_[cell] / heightFrames_[cell]) : NAN;
+}
+
+void BackSurfaceAnalyzer::asymmetry(std::vector<RowAsymmetry>& rows) const
+{
+	rows.resize(settings_.rows);
+	std::vector<float> cells(columns_);
+	for (int r = 0; r < settings_.rows; r++) {
+		for (int c = 0; c < columns_; c++)
+			cells[c] = height(r, c);
+		row_asymmetry(cells.data(), columns_, rows[r]);
+	}
+}
+
+void BackSurfaceAnalyzer::write_json(std::ostream& out) const
+{
+	std::vector<RowAsymmetry> rows;
+	asymmetry(rows);
+
+	// Over the rows where any pair of cells was seen
+	double meanAbs = 0, maxAbs = NAN;
+	int measuredRows = 0, maxRow = -1;
+	for (int r = 0; r < settings_.rows; r++) {
+		if (rows[r].pairs == 0)
+			continue;
+		meanAbs += rows[r].meanAbs;
+		measuredRows++;
+		if (maxRow < 0 || rows[r].maxAbs > maxAbs) {
+			maxAbs = rows[r].maxAbs;
+			maxRow = r;
+		}
+	}
+	meanAbs = measuredRows ? meanAbs / measuredRows : NAN;
+
+	out << "{\"frames\": " << frames_ << ",\"rows\": " << settings_.rows << ",\"columns\": " << columns_
+		<< ",\"cell_mm\": " << settings_.cellWidth << ",\"spine_length_mm\": ";
+	write_number(out, frames_ ? spineLengthSum_ / frames_ : NAN);
+	out << ",\"mean_abs_asymmetry\": ";
+	write_number(out, meanAbs);
+	out << ",\"max_abs_asymmetry\": ";
+	write_number(out, maxAbs);
+	out << ",\"max_row\": ";
+	write_number(out, maxRow >= 0 ? maxRow : NAN);
+
+	out << ",\"row_asymmetry\": [";
+	for (int r = 0; r < settings_.rows; r++) {
+		if (r > 0)
+			out << ",";
+		write_number(out, rows[r].mean);
+	}
+
+	out << "],\"height_map\": [";
+	for (int r = 0; r < settings_.rows; r++) {
+		out << (r > 0 ? ",[" : "[");
+		for (int c = 0; c < columns_; c++) {
+			if (c > 0)
+				out << ",";
+			write_number(out, height(r, c));
+		}
+		out << "]";
+	}
+	out << "]}" << std::endl;
+}
+
+void BackSurfaceAnalyzer::finish()
+{
+	if (outputPath_.empty()) {
+		write_json(report_);
+		return;
+	}
+
+	std::ofstream file(outputPath_);
+	if (file)
+		write_json(file);
+	if (!file)
+		report_ << "cannot write " << outputPath_ << std::endl;
+}
+
+static inline float horizontal_sum(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+static inline float horizontal_max(__m128 v)
+{
+	v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+void row_asymmetry(const float* cells, int columns, RowAsymmetry& out)
+{
+	const int half = columns / 2;
+	const float* right = cells + half;
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	__m128 sum = _mm_setzero_ps(), sumAbs = _mm_setzero_ps(), maxAbs = _mm_setzero_ps(), pairs = _mm_setzero_ps();
+
+	int c = 0;
+	for (; c + 4 <= half; c += 4) {
+		// Left cells half - 1 - c down to half - 4 - c, reversed to line up with right cells half + c up
+		__m128 left = _mm_loadu_ps(cells + half - 4 - c);
+		left = _mm_shuffle_ps(left, left, _MM_SHUFFLE(0, 1, 2, 3));
+
+		__m128 d = _mm_sub_ps(left, _mm_loadu_ps(right + c));
+		__m128 valid = _mm_cmpord_ps(d, d);
+		d = _mm_and_ps(d, valid);
+		__m128 a = _mm_andnot_ps(sign, d);
+
+		sum = _mm_add_ps(sum, d);
+		sumAbs = _mm_add_ps(sumAbs, a);
+		maxAbs = _mm_max_ps(maxAbs, a);
+		pairs = _mm_add_ps(pairs, _mm_and_ps(one, valid));
+	}
+
+	float total = horizontal_sum(sum), totalAbs = horizontal_sum(sumAbs), largest = horizontal_max(maxAbs);
+	uint32_t count = static_cast<uint32_t>(horizontal_sum(pairs));
+
+	for (; c < half; c++) {
+		float d = cells[half - 1 - c] - right[c];
+		if (isnan(d))
+			continue;
+		total += d;
+		totalAbs += fabsf(d);
+		if (fabsf(d) > largest)
+			largest = fabsf(d);
+		count++;
+	}
+
+	out.pairs = count;
+	out.mean = count ? total / count : NAN;
+	out.meanAbs = count ? totalAbs / count : NAN;
+	out.maxAbs = count ? largest : NAN;
+}
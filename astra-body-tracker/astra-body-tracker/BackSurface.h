@@ -0,0 +1,127 @@
+#ifndef BACKSURFACE_H
+#define BACKSURFACE_H
+
+#include "BodySegmentation.h"
+#include "FrameRecord.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+const char* const BACK_SURFACE_FILE = "back_asymmetry.json";
+
+struct BackSurfaceSettings
+{
+	bool enabled = false;
+
+	// Map rows spread evenly from BaseSpine to ShoulderSpine
+	int rows = 48;
+
+	// Cells on each side of the spine line and their width across the back in mm
+	int halfColumns = 20;
+	float cellWidth = 10.0f;
+
+	// Points further than this from the spine line's depth are not the back
+	// surface (arms held in front, background caught in the mask), mm
+	float maxHeight = 250.0f;
+
+	// Fewest points a cell needs in a frame to count for that frame
+	int minCellPoints = 3;
+};
+
+// Asymmetry of one map row, mm; NAN where no mirrored pair of cells was seen
+struct RowAsymmetry
+{
+	// Mean of left minus right height, positive when the left side is raised
+	float mean;
+	float meanAbs;
+	float maxAbs;
+	uint32_t pairs;
+};
+
+/*
+	Back-surface asymmetry of the patient, for scoliosis screening.
+
+	Each frame the patient's points are placed on a height map aligned to the
+	spine: rows run from BaseSpine to ShoulderSpine as fractions of the spine
+	length, columns are mm to either side of the spine line through BaseSpine,
+	MidSpine and ShoulderSpine, and a cell holds the mean height of the
+	surface towards the sensor relative to that line. The patient stands with
+	their back to the sensor, so columns left of the centre are their left side.
+	Rows are relative, so frames average correctly as the patient shifts.
+
+	Cell heights are averaged over every frame that saw the cell. Asymmetry
+	mirrors the averaged map about the spine line and compares each left cell
+	with its right counterpart, four pairs per instruction.
+
+	The patient is the tracked body nearest the sensor with all three spine
+	joints, kept for as long as it stays in view.
+*/
+class BackSurfaceAnalyzer : public SegmentConsumer
+{
+public:
+	// Writes the result to outputPath on finish(), or to report when it is empty
+	BackSurfaceAnalyzer(const BackSurfaceSettings& settings, const std::string& outputPath, std::ostream& report);
+
+	void consume(const SegmentedFrame& frame) override;
+	void finish() override;
+
+	// Adds one frame of the body's points; false when its spine joints are
+	// missing or the spine is too short to align to
+	bool add_frame(const BodySegment& segment, const BodyRecord& body);
+
+	uint32_t frames() const { return frames_; }
+
+	// Averaged height of a cell, NAN when it was never seen; columns count
+	// from the patient's far left
+	float height(int row, int column) const;
+
+	// Asymmetry of every row of the averaged map, base of the spine first
+	void asymmetry(std::vector<RowAsymmetry>& rows) const;
+
+	void write_json(std::ostream& out) const;
+
+private:
+	const BodyRecord* choose_patient(const SegmentedFrame& frame);
+	void project(const BodySegment& segment, size_t begin, size_t count);
+
+	BackSurfaceSettings settings_;
+	int columns_;
+	std::string outputPath_;
+	std::ostream& report_;
+
+	uint8_t patientId_ = 0;
+	uint32_t frames_ = 0;
+	double spineLengthSum_ = 0;
+
+	// Spine frame of the current frame: the axis from BaseSpine up, the axis
+	// towards the patient's right and the one towards the sensor
+	float base_[3];
+	float up_[3];
+	float right_[3];
+	float toward_[3];
+	float rowsPerMm_;
+
+	// Per row, the spine line's position on the right and toward axes
+	std::vector<float> centreRight_;
+	std::vector<float> centreToward_;
+
+	// Points of the current block projected onto the spine frame
+	std::vector<float> along_;
+	std::vector<float> across_;
+	std::vector<float> height_;
+
+	// Current frame, per cell
+	std::vector<float> frameSum_;
+	std::vector<uint32_t> frameCount_;
+
+	// Over all frames, per cell: sum of the frame means and frames that saw it
+	std::vector<double> heightSum_;
+	std::vector<uint32_t> heightFrames_;
+};
+
+// Left minus right of rows of mirrored cells, columns cells wide with the
+// spine between columns / 2 - 1 and columns / 2; cells may be NAN
+void row_asymmetry(const float* cells, int columns, RowAsymmetry& out);
+
+#endif /* BACKSURFACE_H */
@@ -0,0 +1,462 @@
+#include "Benchmark.h"
+#include "BackSurface.h"
+#include "BodySegmentation.h"
+#include "DepthToWorld.h"
+#include "FrameRecord.h"
+#include "JointFilter.h"
+#include "NetworkLibrary.h"
+#include "PostureKernels.h"
+#include "SessionFile.h"
+#include "StreamSink.h"
+#include "SyntheticBodies.h"
+#include "VoxelGrid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <math.h>
+#include <streambuf>
+#include <vector>
+
+// Stands in for the stdout pipe: accepts everything and only counts bytes
+class CountingBuffer : public std::streambuf
+{
+public:
+	uint64_t count = 0;
+
+protected:
+	virtual std::streamsize xsputn(const char*, std::streamsize n) override
+	{
+		count += n;
+		return n;
+	}
+
+	virtual int_type overflow(int_type c) override
+	{
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+			count++;
+		return traits_type::not_eof(c);
+	}
+};
+
+static const char* format_name(OutputFormat format)
+{
+	switch (format) {
+	case OutputFormat::Binary:
+		return "binary";
+	case OutputFormat::Delta:
+		return "delta";
+	default:
+		return "json";
+	}
+}
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+	size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+// Frames that decoded to something other than what was encoded, and the
+// largest position error of the rest in mm
+struct DeltaCheck
+{
+	uint64_t decoded = 0;
+	uint64_t rejected = 0;
+	uint64_t wrong = 0;
+	float maxError = 0;
+};
+
+static void compare_decoded(const FrameRecord& sent, const FrameRecord& received, float tolerance, DeltaCheck& check)
+{
+	bool same = sent.frameNumber == received.frameNumber && sent.timestampUs == received.timestampUs &&
+		sent.bodyCount == received.bodyCount;
+	for (uint32_t i = 0; same && i < sent.bodyCount; i++) {
+		const BodyRecord& a = sent.bodies[i];
+		const BodyRecord& b = received.bodies[i];
+		uint32_t mask = a.jointsEnabled ? a.jointMask & ((1u << ASTRA_MAX_JOINTS) - 1) : 0;
+		same = a.id == b.id && a.status == b.status && mask == b.jointMask;
+		for (int n = 0; same && n < ASTRA_MAX_JOINTS; n++) {
+			if ((mask & (1u << n)) == 0)
+				continue;
+			for (int axis = 0; axis < 3; axis++) {
+				float error = fabsf(a.joints[n][axis] - b.joints[n][axis]);
+				check.maxError = std::max(check.maxError, error);
+				same = same && error <= tolerance;
+			}
+		}
+	}
+	if (!same)
+		check.wrong++;
+}
+
+// Decodes delta packets once as sent and once with every lossInterval-th
+// packet lost, and reports any frame that does not decode to what was encoded.
+// Steady skeletons, with no joints dropping out, are included because a delta
+// against the wrong frame then parses cleanly and only the sequence number
+// gives it away.
+static void run_delta_check(const BenchmarkSettings& settings, std::ostream& report)
+{
+	const int lossInterval = 45;
+
+	DeltaSettings deltaSettings;
+	float tolerance = 0.5f / deltaSettings.positionScale + 0.01f;
+
+	astra_body_t bodies[ASTRA_MAX_BODIES];
+	FrameRecord record, decoded;
+	sf::Packet packet;
+	bool failed = false;
+
+	report << std::endl << "delta check          lost  decoded  rejected  wrong  max error mm" << std::endl;
+
+	const double untrackedChances[] = { 0.05, 0.0 };
+	for (double untrackedChance : untrackedChances) {
+		SyntheticBodies generator(42, untrackedChance);
+		DeltaEncoder encoder(deltaSettings);
+		DeltaDecoder intact, lossy;
+		DeltaCheck intactCheck, lossyCheck;
+		uint64_t lost = 0;
+
+		for (int frame = 0; frame < settings.frames; frame++) {
+			generator.generate(ASTRA_MAX_BODIES, frame, bodies);
+			record.frameNumber = frame;
+			record.elapsedMs = 33;
+			record.timestampUs = frame * 33333ull;
+			extract_frame_record(SyntheticBodies::as_bodies(bodies), ASTRA_MAX_BODIES, record);
+			encoder.encode(record, packet);
+
+			if (intact.decode(packet, decoded)) {
+				intactCheck.decoded++;
+				compare_decoded(record, decoded, tolerance, intactCheck);
+			}
+			else
+				intactCheck.rejected++;
+
+			if (frame % lossInterval == lossInterval - 1) {
+				lost++;
+				continue;
+			}
+			if (lossy.decode(packet, decoded)) {
+				lossyCheck.decoded++;
+				compare_decoded(record, decoded, tolerance, lossyCheck);
+			}
+			else
+				lossyCheck.rejected++;
+		}
+
+		const char* kind = untrackedChance > 0 ? "dropouts" : "steady";
+		const DeltaCheck* checks[] = { &intactCheck, &lossyCheck };
+		for (int k = 0; k < 2; k++) {
+			const DeltaCheck& check = *checks[k];
+			report << std::left << std::setw(9) << kind << std::setw(8) << (k == 0 ? "intact" : "lossy") << std::right
+				<< std::setw(7) << (k == 0 ? 0 : lost) << std::setw(9) << check.decoded
+				<< std::setw(10) << check.rejected << std::setw(7) << check.wrong
+				<< std::fixed << std::setprecision(2) << std::setw(14) << check.maxError << std::endl;
+		}
+		failed = failed || intactCheck.rejected > 0 || intactCheck.wrong > 0 || lossyCheck.wrong > 0;
+	}
+
+	if (failed)
+		report << "delta check FAILED" << std::endl;
+}
+
+// Joint filters over ASTRA_MAX_BODIES synthetic bodies per frame
+static void run_filter_benchmark(const BenchmarkSettings& settings, std::ostream& report)
+{
+	using namespace std::chrono;
+
+	SyntheticBodies generator(42);
+	astra_body_t bodies[ASTRA_MAX_BODIES];
+	std::vector<FrameRecord> frames(settings.frames);
+	for (int frame = 0; frame < settings.frames; frame++) {
+		generator.generate(ASTRA_MAX_BODIES, frame, bodies);
+		frames[frame].frameNumber = frame;
+		frames[frame].timestampUs = frame * 33333ull;
+		extract_frame_record(SyntheticBodies::as_bodies(bodies), ASTRA_MAX_BODIES, frames[frame]);
+	}
+
+	report << std::endl << "filter     ns/body" << std::endl;
+
+	const FilterType types[] = { FilterType::OneEuro, FilterType::Kalman };
+	for (FilterType type : types) {
+		FilterSettings filterSettings;
+		filterSettings.type = type;
+		JointFilterBank filter(filterSettings);
+
+		double seconds = 0;
+		uint64_t count = 0;
+		for (FrameRecord& record : frames) {
+			auto begin = steady_clock::now();
+			filter.apply(record);
+			seconds += duration<double>(steady_clock::now() - begin).count();
+			count += record.bodyCount;
+		}
+
+		report << std::left << std::setw(8) << (type == FilterType::OneEuro ? "one-euro" : "kalman") << std::right
+			<< std::fixed << std::setprecision(1) << std::setw(11) << seconds * 1e9 / count << std::endl;
+	}
+}
+
+// Posture kernels at every level the CPU supports, over synthetic bodies laid
+// out the way a session file stores them
+static void run_posture_benchmark(const BenchmarkSettings& settings, std::ostream& report)
+{
+	using namespace std::chrono;
+
+	const int repeats = 50;
+
+	SyntheticBodies generator(42);
+	astra_body_t bodies[ASTRA_MAX_BODIES];
+	FrameRecord record;
+	SessionColumns columns;
+	for (int frame = 0; frame < settings.frames; frame++) {
+		generator.generate(ASTRA_MAX_BODIES, frame, bodies);
+		extract_frame_record(SyntheticBodies::as_bodies(bodies), ASTRA_MAX_BODIES, record);
+		for (uint32_t i = 0; i < record.bodyCount; i++)
+			columns.add_row(frame, 33, frame * 33333.0, record.bodies[i]);
+	}
+
+	size_t rows = columns.rows();
+	JointColumns joints;
+	joints.rows = rows;
+	joints.jointMask = columns.jointMask.data();
+	for (int j = 0; j < ASTRA_MAX_JOINTS; j++) {
+		joints.x[j] = columns.joints[j * 3 + 0].data();
+		joints.y[j] = columns.joints[j * 3 + 1].data();
+		joints.z[j] = columns.joints[j * 3 + 2].data();
+	}
+
+	std::vector<float> shoulderTilt(rows), hipTilt(rows), twist(rows), headOffset(rows);
+	PostureColumns out = { shoulderTilt.data(), hipTilt.data(), twist.data(), headOffset.data() };
+
+	report << std::endl << "posture    rows/s" << std::endl;
+
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 };
+	for (SimdLevel level : levels) {
+		if (level > detect_simd_level())
+			break;
+
+		// Best of the repeats, which keeps scheduler noise out of a short run
+		double best = 0;
+		for (int r = 0; r < repeats; r++) {
+			auto begin = steady_clock::now();
+			compute_posture(joints, out, level);
+			double seconds = duration<double>(steady_clock::now() - begin).count();
+			if (r == 0 || seconds < best)
+				best = seconds;
+		}
+
+		report << std::left << std::setw(8) << simd_level_name(level) << std::right
+			<< std::fixed << std::setprecision(0) << std::setw(11) << rows / best << std::endl;
+	}
+}
+
+// A wall at 3 m with a person-sized ellipse at 2 m in front of it and a
+// sparse pattern of pixels without depth; the mask marks the ellipse as body 1
+static void synthetic_depth(int width, int height, std::vector<int16_t>& depth, std::vector<uint8_t>& mask)
+{
+	depth.resize(static_cast<size_t>(width) * height);
+	mask.resize(depth.size());
+	for (int v = 0; v < height; v++) {
+		for (int u = 0; u < width; u++) {
+			size_t i = static_cast<size_t>(v) * width + u;
+			float du = (u - width * 0.5f) / (width * 0.15f);
+			float dv = (v - height * 0.55f) / (height * 0.4f);
+			bool body = du * du + dv * dv < 1;
+			bool hole = (u * 7 + v * 13) % 29 == 0;
+			depth[i] = hole ? 0 : static_cast<int16_t>(body ? 2000 + u % 50 : 3000 + v);
+			mask[i] = body ? 1 : 0;
+		}
+	}
+}
+
+static void run_depth_benchmark(std::ostream& report)
+{
+	using namespace std::chrono;
+
+	const int repeats = 50;
+
+	// Nominal Astra intrinsics, 60 x 49.5 degree field of view
+	astra_conversion_cache_t cache = { };
+	cache.resolutionX = 640;
+	cache.resolutionY = 480;
+	cache.xzFactor = 1.1547f;
+	cache.yzFactor = 0.9214f;
+	DepthToWorld converter(cache);
+
+	std::vector<int16_t> depth;
+	std::vector<uint8_t> mask;
+	synthetic_depth(cache.resolutionX, cache.resolutionY, depth, mask);
+
+	size_t pixels = depth.size();
+	std::vector<float> x(pixels), y(pixels), z(pixels);
+	std::vector<astra::Vector3f> points(pixels);
+	PointColumns columns = { x.data(), y.data(), z.data(), nullptr };
+
+	report << std::endl << "depth to world  dense ms  interleaved ms  masked ms" << std::endl;
+
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Avx2 };
+	for (SimdLevel level : levels) {
+		if (level > detect_simd_level())
+			break;
+
+		double best[3] = { 0, 0, 0 };
+		for (int r = 0; r < repeats; r++) {
+			auto t0 = steady_clock::now();
+			converter.convert(depth.data(), cache.resolutionX, cache.resolutionY, columns, level);
+			auto t1 = steady_clock::now();
+			converter.convert(depth.data(), cache.resolutionX, cache.resolutionY, points.data(), level);
+			auto t2 = steady_clock::now();
+			converter.convert_masked(depth.data(), mask.data(), cache.resolutionX, cache.resolutionY, columns, level);
+			auto t3 = steady_clock::now();
+
+			double times[3] = {
+				duration<double, std::milli>(t1 - t0).count(),
+				duration<double, std::milli>(t2 - t1).count(),
+				duration<double, std::milli>(t3 - t2).count()
+			};
+			for (int k = 0; k < 3; k++) {
+				if (r == 0 || times[k] < best[k])
+					best[k] = times[k];
+			}
+		}
+
+		report << std::left << std::setw(14) << simd_level_name(level) << std::right
+			<< std::fixed << std::setprecision(3) << std::setw(10) << best[0]
+			<< std::setw(16) << best[1] << std::setw(11) << best[2] << std::endl;
+	}
+
+	BodySegmenter segmenter;
+	segmenter.set_conversion_cache(cache);
+	double segmentBest = 0;
+	for (int r = 0; r < repeats; r++) {
+		auto begin = steady_clock::now();
+		segmenter.segment(depth.data(), mask.data(), cache.resolutionX, cache.resolutionY);
+		double ms = duration<double, std::milli>(steady_clock::now() - begin).count();
+		if (r == 0 || ms < segmentBest)
+			segmentBest = ms;
+	}
+	const SegmentedFrame& segmented = segmenter.segment(depth.data(), mask.data(), cache.resolutionX, cache.resolutionY);
+	size_t bodyPoints = segmented.segmentCount ? segmented.segments[0].pointCount : 0;
+
+	report << std::endl << "segmentation  points        ms" << std::endl
+		<< std::setw(20) << bodyPoints << std::setw(10) << segmentBest << std::endl;
+
+	// A spine standing 80 mm behind the synthetic body's surface
+	BodyRecord patient = { };
+	patient.id = 1;
+	patient.status = ASTRA_BODY_STATUS_TRACKING;
+	patient.jointMask = (1u << ASTRA_JOINT_BASE_SPINE) | (1u << ASTRA_JOINT_MID_SPINE) | (1u << ASTRA_JOINT_SHOULDER_SPINE);
+	const int spineJoints[] = { ASTRA_JOINT_BASE_SPINE, ASTRA_JOINT_MID_SPINE, ASTRA_JOINT_SHOULDER_SPINE };
+	for (int k = 0; k < 3; k++) {
+		patient.joints[spineJoints[k]][0] = 0;
+		patient.joints[spineJoints[k]][1] = -300.0f + 250.0f * k;
+		patient.joints[spineJoints[k]][2] = 2080;
+	}
+
+	BackSurfaceSettings backSettings;
+	BackSurfaceAnalyzer backSurface(backSettings, "", report);
+	double backBest = 0;
+	for (int r = 0; r < repeats && segmented.segmentCount > 0; r++) {
+		auto begin = steady_clock::now();
+		backSurface.add_frame(segmented.segments[0], patient);
+		double ms = duration<double, std::milli>(steady_clock::now() - begin).count();
+		if (r == 0 || ms < backBest)
+			backBest = ms;
+	}
+
+	report << std::endl << "back surface  points        ms" << std::endl
+		<< std::setw(20) << bodyPoints << std::setw(10) << backBest << std::endl;
+
+	report << std::endl << "voxel grid  leaf mm    voxels        ms" << std::endl;
+
+	const float leafSizes[] = { 10, 20, 50 };
+	VoxelDownsampler downsampler;
+	for (float leafSize : leafSizes) {
+		downsampler.set_leaf_size(leafSize);
+
+		double best = 0;
+		size_t voxels = 0;
+		for (int r = 0; r < repeats; r++) {
+			auto begin = steady_clock::now();
+			voxels = downsampler.downsample(points.data(), points.size());
+			double ms = duration<double, std::milli>(steady_clock::now() - begin).count();
+			if (r == 0 || ms < best)
+				best = ms;
+		}
+
+		report << std::setw(20) << std::setprecision(0) << leafSize << std::setw(10) << voxels
+			<< std::setprecision(3) << std::setw(10) << best << std::endl;
+	}
+}
+
+void run_benchmark(const BenchmarkSettings& settings, std::ostream& report)
+{
+	using namespace std::chrono;
+
+	const OutputFormat formats[] = { OutputFormat::Json, OutputFormat::Binary, OutputFormat::Delta };
+	const int warmup = 100;
+
+	astra_body_t bodies[ASTRA_MAX_BODIES];
+	FrameRecord record;
+	std::vector<double> latencies;
+	latencies.reserve(settings.frames);
+
+	report << "format  bodies   frames/s   p50 us   p99 us   bytes/frame   total bytes" << std::endl;
+
+	for (OutputFormat format : formats) {
+		if (format == OutputFormat::Delta && !network_library_available()) {
+			report << "delta   skipped, " << network_library_name() << " not found" << std::endl;
+			continue;
+		}
+
+		for (int count = 1; count <= ASTRA_MAX_BODIES; count++) {
+			// Same seed for every run so each format sees identical frames
+			SyntheticBodies generator(42);
+			CountingBuffer counter;
+			std::ostream out(&counter);
+			StreamSink sink(format, out);
+
+			latencies.clear();
+
+			for (int frame = 0; frame < warmup + settings.frames; frame++) {
+				generator.generate(count, frame, bodies);
+
+				if (frame == warmup)
+					counter.count = 0;
+
+				auto begin = steady_clock::now();
+
+				record.frameNumber = frame;
+				record.elapsedMs = 33;
+				record.timestampUs = frame * 33333ull;
+				extract_frame_record(SyntheticBodies::as_bodies(bodies), count, record);
+				sink.consume(record);
+				sink.flush();
+
+				if (frame >= warmup)
+					latencies.push_back(duration<double, std::micro>(steady_clock::now() - begin).count());
+			}
+
+			// Throughput of the output path alone, without the generator
+			double seconds = 0;
+			for (double latency : latencies)
+				seconds += latency / 1e6;
+			std::sort(latencies.begin(), latencies.end());
+
+			report << std::left << std::setw(8) << format_name(format) << std::right
+				<< std::setw(6) << count
+				<< std::fixed << std::setprecision(0) << std::setw(11) << settings.frames / seconds
+				<< std::setprecision(2) << std::setw(9) << percentile(latencies, 0.50)
+				<< std::setw(9) << percentile(latencies, 0.99)
+				<< std::setprecision(0) << std::setw(14) << static_cast<double>(counter.count) / settings.frames
+				<< std::setw(14) << counter.count << std::endl;
+		}
+	}
+
+	if (network_library_available())
+		run_delta_check(settings, report);
+	run_filter_benchmark(settings, report);
+	run_posture_benchmark(settings, report);
+	run_depth_benchmark(report);
+}
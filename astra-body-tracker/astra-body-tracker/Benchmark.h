@@ -0,0 +1,21 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <ostream>
+
+struct BenchmarkSettings
+{
+	// Frames timed per body count and output format
+	int frames = 3000;
+};
+
+// Pushes synthetic frames for 1..ASTRA_MAX_BODIES bodies through the same
+// extraction and encoding code log_data uses and reports throughput, per-frame
+// latency percentiles and bytes emitted for every output format, and checks
+// that delta packets decode to the frames encoded, also with packets lost.
+// Then times the joint filters, the posture kernels and depth to world
+// conversion at every SIMD level the CPU supports, then body segmentation,
+// the back-surface map and voxel downsampling of the converted cloud.
+void run_benchmark(const BenchmarkSettings& settings, std::ostream& report);
+
+#endif /* BENCHMARK_H */
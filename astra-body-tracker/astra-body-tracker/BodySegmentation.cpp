@@ -0,0 +1,184 @@
+#include "BodySegmentation.h"
+#include <cstring>
+#include <emmintrin.h>
+
+static const uint8_t NO_SEGMENT = 0xFF;
+
+// Room for a span to be written, including the whole vectors the AVX2
+// kernel stores past the last point
+static void reserve_points(BodySegment& segment, size_t count)
+{
+	if (segment.x.size() >= count)
+		return;
+
+	size_t size = segment.x.size() * 2;
+	if (size < count)
+		size = count;
+	if (size < 4096)
+		size = 4096;
+	segment.x.resize(size);
+	segment.y.resize(size);
+	segment.z.resize(size);
+	segment.pixel.resize(size);
+}
+
+BodySegmenter::BodySegmenter()
+	: converter_(astra_conversion_cache_t()),
+	avx2_(detect_simd_level() == SimdLevel::Avx2)
+{
+	memset(segmentOfId_, NO_SEGMENT, sizeof(segmentOfId_));
+	frame_.segmentCount = 0;
+	for (BodySegment& segment : frame_.segments)
+		segment.pointCount = 0;
+}
+
+void BodySegmenter::set_conversion_cache(const astra_conversion_cache_t& cache)
+{
+	converter_ = DepthToWorld(cache);
+}
+
+void BodySegmenter::add_consumer(SegmentConsumer& consumer)
+{
+	consumers_.push_back(&consumer);
+}
+
+const SegmentedFrame& BodySegmenter::segment(const DepthFrameRef& frame)
+{
+	segment(frame.data(), frame.body_mask(), frame.width(), frame.height());
+	frame_.depth = frame;
+	return frame_;
+}
+
+const SegmentedFrame& BodySegmenter::segment(const int16_t* depth, const uint8_t* mask, int width, int height)
+{
+	frame_.depth.reset();
+	frame_.segmentCount = 0;
+
+	if (!mask || width != converter_.width() || height != converter_.height()) {
+		skippedFrames_++;
+		return frame_;
+	}
+
+	const __m128i zero = _mm_setzero_si128();
+
+	for (int v = 0; v < height; v++) {
+		DepthRow row = converter_.row(depth, nullptr, v);
+		const uint8_t* maskRow = mask + row.firstPixel;
+
+		int u = 0;
+		for (; u + 16 <= width; u += 16) {
+			__m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskRow + u));
+			int background = _mm_movemask_epi8(_mm_cmpeq_epi8(ids, zero));
+			if (background == 0xFFFF)
+				continue;
+
+			uint8_t first = maskRow[u];
+			int same = _mm_movemask_epi8(_mm_cmpeq_epi8(ids, _mm_set1_epi8(static_cast<char>(first))));
+			if (same == 0xFFFF) {
+				if (BodySegment* segment = segment_for(first))
+					add_span(*segment, row, v, u, 16);
+				continue;
+			}
+
+			add_pixels(row, maskRow, v, u, u + 16);
+		}
+		add_pixels(row, maskRow, v, u, width);
+	}
+
+	for (uint32_t i = 0; i < frame_.segmentCount; i++)
+		segmentOfId_[frame_.segments[i].bodyId] = NO_SEGMENT;
+
+	return frame_;
+}
+
+BodySegment* BodySegmenter::segment_for(uint8_t bodyId)
+{
+	uint8_t index = segmentOfId_[bodyId];
+	if (index != NO_SEGMENT)
+		return &frame_.segments[index];
+
+	// More ids than bodies only happens with a corrupt mask
+	if (frame_.segmentCount == ASTRA_MAX_BODIES)
+		return nullptr;
+
+	index = static_cast<uint8_t>(frame_.segmentCount++);
+	segmentOfId_[bodyId] = index;
+
+	BodySegment& segment = frame_.segments[index];
+	segment.bodyId = bodyId;
+	segment.minU = segment.minV = INT32_MAX;
+	segment.maxU = segment.maxV = -1;
+	segment.pixelCount = 0;
+	segment.pointCount = 0;
+	return &segment;
+}
+
+void BodySegmenter::add_span(BodySegment& segment, const DepthRow& row, int v, int begin, int count)
+{
+	if (begin < segment.minU)
+		segment.minU = begin;
+	if (begin + count - 1 > segment.maxU)
+		segment.maxU = begin + count - 1;
+	if (v < segment.minV)
+		segment.minV = v;
+	segment.maxV = v;
+	segment.pixelCount += count;
+
+	reserve_points(segment, segment.pointCount + count);
+	PointColumns out = { segment.x.data(), segment.y.data(), segment.z.data(), segment.pixel.data() };
+
+	DepthRow span = { row.depth + begin, nullptr, row.columnFactor + begin, row.rowFactor,
+		count, row.firstPixel + begin };
+	int done = avx2_ ? world_row_masked_avx2(span, out, segment.pointCount) : 0;
+	world_row_masked_scalar(span, done, out, segment.pointCount);
+}
+
+void BodySegmenter::add_pixels(const DepthRow& row, const uint8_t* mask, int v, int begin, int end)
+{
+	for (int u = begin; u < end; u++) {
+		if (!mask[u])
+			continue;
+
+		BodySegment* segment = segment_for(mask[u]);
+		if (!segment)
+			continue;
+
+		if (u < segment->minU)
+			segment->minU = u;
+		if (u > segment->maxU)
+			segment->maxU = u;
+		if (v < segment->minV)
+			segment->minV = v;
+		segment->maxV = v;
+		segment->pixelCount++;
+
+		if (row.depth[u] <= 0)
+			continue;
+
+		// The same products as the row kernels, so a pixel converts identically on either path
+		reserve_points(*segment, segment->pointCount + 1);
+		size_t i = segment->pointCount++;
+		float z = row.depth[u];
+		segment->x[i] = row.columnFactor[u] * z;
+		segment->y[i] = row.rowFactor * z;
+		segment->z[i] = z;
+		segment->pixel[i] = row.firstPixel + u;
+	}
+}
+
+void BodySegmenter::analyze(const DepthFrameRef& frame)
+{
+	const SegmentedFrame& segmented = segment(frame);
+	if (segmented.segmentCount == 0)
+		return;
+
+	for (SegmentConsumer* consumer : consumers_)
+		consumer->consume(segmented);
+}
+
+void BodySegmenter::finish()
+{
+	frame_.depth.reset();
+	for (SegmentConsumer* consumer : consumers_)
+		consumer->finish();
+}
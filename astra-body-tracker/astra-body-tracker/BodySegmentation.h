@@ -0,0 +1,105 @@
+#ifndef BODYSEGMENTATION_H
+#define BODYSEGMENTATION_H
+
+#include "DepthToWorld.h"
+#include "DepthWorker.h"
+
+#include <astra/capi/streams/body_types.h>
+#include <cstdint>
+#include <vector>
+
+// One body's pixels in a depth frame
+struct BodySegment
+{
+	// Id from the body mask, the same as astra_body_t::id
+	uint8_t bodyId;
+
+	// Inclusive pixel bounds of the body's mask pixels
+	int minU;
+	int minV;
+	int maxU;
+	int maxV;
+
+	// Mask pixels, with or without depth
+	uint32_t pixelCount;
+
+	// World points in mm of the mask pixels that have depth, in pixel order;
+	// the first pointCount entries of each array are valid
+	size_t pointCount;
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<uint32_t> pixel;
+};
+
+struct SegmentedFrame
+{
+	// Keeps the depth and mask buffer alive for consumers that read pixels
+	DepthFrameRef depth;
+
+	uint32_t segmentCount;
+	BodySegment segments[ASTRA_MAX_BODIES];
+};
+
+// Receives every segmented frame on the depth worker thread
+class SegmentConsumer
+{
+public:
+	virtual ~SegmentConsumer() { }
+
+	virtual void consume(const SegmentedFrame& frame) = 0;
+
+	virtual void finish() { }
+};
+
+/*
+	Splits a depth frame into per-body point clouds using the body mask
+	retained with it, in one pass over both. Sixteen mask bytes are compared
+	at a time: all-background runs are skipped outright and runs of a single
+	body go through the masked DepthToWorld row kernel, so only edge pixels
+	are handled one by one. Consumers then see a few tens of thousands of
+	points per body instead of the whole frame.
+
+	Point buffers are kept between frames and only grow. Frames without a
+	mask, or not of the conversion cache's resolution, are skipped.
+*/
+class BodySegmenter : public DepthAnalyzer
+{
+public:
+	BodySegmenter();
+
+	// The depth stream's depth_to_world_data(); set before frames arrive
+	void set_conversion_cache(const astra_conversion_cache_t& cache);
+
+	// Consumers must be added before the worker starts and outlive it
+	void add_consumer(SegmentConsumer& consumer);
+	bool has_consumers() const { return !consumers_.empty(); }
+
+	// The result stays valid until the next call
+	const SegmentedFrame& segment(const DepthFrameRef& frame);
+	const SegmentedFrame& segment(const int16_t* depth, const uint8_t* mask, int width, int height);
+
+	void analyze(const DepthFrameRef& frame) override;
+	void finish() override;
+
+	uint64_t skipped_frames() const { return skippedFrames_; }
+
+private:
+	BodySegment* segment_for(uint8_t bodyId);
+	void add_span(BodySegment& segment, const DepthRow& row, int v, int begin, int count);
+	void add_pixels(const DepthRow& row, const uint8_t* mask, int v, int begin, int end);
+
+	DepthToWorld converter_;
+	bool avx2_;
+
+	std::vector<SegmentConsumer*> consumers_;
+
+	SegmentedFrame frame_;
+
+	// Segment index of every body id in the current frame, NO_SEGMENT if none
+	uint8_t segmentOfId_[256];
+
+	uint64_t skippedFrames_ = 0;
+};
+
+#endif /* BODYSEGMENTATION_H */
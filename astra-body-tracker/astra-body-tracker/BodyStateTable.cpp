@@ -0,0 +1,140 @@
+#include "BodyStateTable.h"
+#include "JointSchema.h"
+#include <cstring>
+#include <math.h>
+
+void RollingMean::reset()
+{
+	sum = 0;
+	count = 0;
+}
+
+void RollingMean::push(uint32_t slot, bool full, float value)
+{
+	if (full && !isnan(values[slot])) {
+		sum -= values[slot];
+		count--;
+	}
+
+	values[slot] = value;
+	if (!isnan(value)) {
+		sum += value;
+		count++;
+	}
+}
+
+float RollingMean::mean() const
+{
+	return count ? static_cast<float>(sum / count) : NAN;
+}
+
+// One slot per possible astra::BodyId, 0 unused
+static const size_t BODY_ID_COUNT = 256;
+
+BodyStateTable::BodyStateTable()
+	: states_(BODY_ID_COUNT)
+{
+	activeIds_.reserve(BODY_ID_COUNT);
+	for (BodyState& state : states_)
+		state.active = false;
+}
+
+const BodyState* BodyStateTable::find(uint8_t id) const
+{
+	const BodyState& state = states_[id];
+	return state.active ? &state : nullptr;
+}
+
+void BodyStateTable::consume(const FrameRecord& record)
+{
+	for (uint32_t i = 0; i < record.bodyCount; i++) {
+		const BodyRecord& body = record.bodies[i];
+		if (body.id == 0)
+			continue;
+
+		auto status = static_cast<astra::BodyStatus>(body.status);
+		if (status == astra::BodyStatus::TrackingLost || status == astra::BodyStatus::NotTracking) {
+			evict(body.id);
+			continue;
+		}
+
+		BodyState& state = states_[body.id];
+		if (!state.active) {
+			begin(state, body, record.frameNumber);
+			activeIds_.push_back(body.id);
+		}
+		update(state, body, record);
+	}
+
+	// Catch bodies that vanished without the SDK ever reporting them lost
+	for (size_t i = 0; i < activeIds_.size();) {
+		const BodyState& state = states_[activeIds_[i]];
+		if (record.frameNumber - state.lastFrame > BODY_STALE_FRAMES)
+			evict(activeIds_[i]);
+		else
+			i++;
+	}
+}
+
+void BodyStateTable::begin(BodyState& state, const BodyRecord& body, uint32_t frameNumber)
+{
+	state.active = true;
+	state.id = body.id;
+	state.firstFrame = frameNumber;
+	state.framesSeen = 0;
+	state.historyHead = 0;
+	state.historyCount = 0;
+	state.shoulderAngle.reset();
+	state.hipAngle.reset();
+	state.spinePathLength = 0;
+}
+
+void BodyStateTable::update(BodyState& state, const BodyRecord& body, const FrameRecord& record)
+{
+	state.status = body.status;
+	state.lastFrame = record.frameNumber;
+	state.framesSeen++;
+
+	if (!body.jointsEnabled)
+		return;
+
+	const int spine = joint_index(astra::JointType::BaseSpine);
+	if (state.historyCount > 0 && joint_valid(body, spine)) {
+		uint32_t previous = state.history_slot(0);
+		if (state.historyJointMask[previous] & (1u << spine)) {
+			const float* from = state.historyJoints[previous][spine];
+			const float* to = body.joints[spine];
+			double dx = to[0] - from[0], dy = to[1] - from[1], dz = to[2] - from[2];
+			state.spinePathLength += sqrt(dx * dx + dy * dy + dz * dz);
+		}
+	}
+
+	uint32_t slot = state.historyHead & (BODY_HISTORY_FRAMES - 1);
+	bool full = state.historyCount == BODY_HISTORY_FRAMES;
+
+	state.historyFrame[slot] = record.frameNumber;
+	state.historyTimestampUs[slot] = record.timestampUs;
+	state.historyJointMask[slot] = body.jointMask;
+	memcpy(state.historyJoints[slot], body.joints, sizeof(body.joints));
+	state.shoulderAngle.push(slot, full, body.shoulderAngle);
+	state.hipAngle.push(slot, full, body.hipAngle);
+
+	state.historyHead++;
+	if (!full)
+		state.historyCount++;
+}
+
+void BodyStateTable::evict(uint8_t id)
+{
+	BodyState& state = states_[id];
+	if (!state.active)
+		return;
+
+	state.active = false;
+	for (size_t i = 0; i < activeIds_.size(); i++) {
+		if (activeIds_[i] == id) {
+			activeIds_.erase(activeIds_.begin() + i);
+			break;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef BODYSTATETABLE_H
+#define BODYSTATETABLE_H
+
+#include "FrameSink.h"
+#include <vector>
+
+// Frames of joint history kept per body, a power of two
+const uint32_t BODY_HISTORY_FRAMES = 16;
+
+// Bodies not reported for this many frames are evicted even without a Lost status
+const uint32_t BODY_STALE_FRAMES = 90;
+
+// Mean of the last BODY_HISTORY_FRAMES values, NAN ones skipped, kept up to date
+// by adding the newest and subtracting the one it replaces
+struct RollingMean
+{
+	float values[BODY_HISTORY_FRAMES];
+	double sum;
+	uint32_t count;
+
+	void reset();
+	void push(uint32_t slot, bool full, float value);
+	float mean() const;
+};
+
+struct BodyState
+{
+	bool active;
+	uint8_t id;
+	uint8_t status;
+
+	uint32_t firstFrame;
+	uint32_t lastFrame;
+	uint32_t framesSeen;
+
+	// Ring of the last BODY_HISTORY_FRAMES frames with joints, newest at
+	// (historyHead - 1) & (BODY_HISTORY_FRAMES - 1)
+	uint32_t historyHead;
+	uint32_t historyCount;
+	uint32_t historyFrame[BODY_HISTORY_FRAMES];
+	uint64_t historyTimestampUs[BODY_HISTORY_FRAMES];
+	uint32_t historyJointMask[BODY_HISTORY_FRAMES];
+	float historyJoints[BODY_HISTORY_FRAMES][ASTRA_MAX_JOINTS][3];
+
+	RollingMean shoulderAngle;
+	RollingMean hipAngle;
+
+	// Distance BaseSpine has moved while tracked, in millimetres
+	double spinePathLength;
+
+	// Index of the frame n frames back, 0 being the newest; n < historyCount
+	uint32_t history_slot(uint32_t n) const
+	{
+		return (historyHead - 1 - n) & (BODY_HISTORY_FRAMES - 1);
+	}
+};
+
+/*
+	State of every body the SDK is tracking, indexed by astra::BodyId (1..255).
+
+	Updated incrementally as a FrameSink on the writer thread, so it sees frames
+	in order and costs the SDK callback nothing. Register it before the sinks that
+	read it. A body's slot is cleared when the SDK reports it lost, or when it has
+	not been seen for BODY_STALE_FRAMES frames.
+*/
+class BodyStateTable : public FrameSink
+{
+public:
+	BodyStateTable();
+
+	virtual void consume(const FrameRecord& record) override;
+
+	// nullptr unless the body is being tracked
+	const BodyState* find(uint8_t id) const;
+
+	// Ids of the bodies being tracked, in the order they were first seen
+	const std::vector<uint8_t>& active_ids() const { return activeIds_; }
+
+private:
+	void begin(BodyState& state, const BodyRecord& body, uint32_t frameNumber);
+	void update(BodyState& state, const BodyRecord& body, const FrameRecord& record);
+	void evict(uint8_t id);
+
+	std::vector<BodyState> states_;
+	std::vector<uint8_t> activeIds_;
+};
+
+#endif /* BODYSTATETABLE_H */
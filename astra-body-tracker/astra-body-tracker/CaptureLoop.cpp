@@ -0,0 +1,110 @@
+#include "CaptureLoop.h"
+#include "PipelineMetrics.h"
+
+#include <astra_core/astra_core.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+static volatile std::sig_atomic_t shutdownSignal = 0;
+static std::atomic<bool> shutdownFlag{ false };
+static std::atomic<bool> shutdownDone{ false };
+static std::atomic<uint64_t> updateStartedUs{ 0 };
+
+static void on_signal(int)
+{
+	shutdownSignal = 1;
+}
+
+#ifdef _WIN32
+static BOOL WINAPI on_console_event(DWORD type)
+{
+	switch (type) {
+	case CTRL_C_EVENT:
+	case CTRL_BREAK_EVENT:
+		request_shutdown();
+		return TRUE;
+	case CTRL_CLOSE_EVENT:
+		// The process is killed as soon as this returns, so give main a moment to flush
+		request_shutdown();
+		for (int i = 0; i < 40 && !shutdownDone.load(); i++)
+			Sleep(50);
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+#endif
+
+static void watch_stdin()
+{
+	char buffer[256];
+	while (fread(buffer, 1, sizeof(buffer), stdin) > 0) {
+	}
+	request_shutdown();
+}
+
+void install_shutdown_handlers(bool watchStdin)
+{
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+#ifdef _WIN32
+	SetConsoleCtrlHandler(on_console_event, TRUE);
+#endif
+
+	// Blocks in fread for the life of the process, so it is never joined
+	if (watchStdin)
+		std::thread(watch_stdin).detach();
+}
+
+void request_shutdown()
+{
+	shutdownFlag.store(true);
+}
+
+bool shutdown_requested()
+{
+	return shutdownFlag.load() || shutdownSignal != 0;
+}
+
+void shutdown_complete()
+{
+	shutdownDone.store(true);
+}
+
+uint64_t capture_update_started_us()
+{
+	return updateStartedUs.load(std::memory_order_relaxed);
+}
+
+void run_capture_loop(const CaptureLoopSettings& settings)
+{
+	using namespace std::chrono;
+
+	int fps = std::max(settings.fps, 1);
+	int budget = std::min(std::max(settings.cpuBudget, 1), 100);
+
+	// Polling at twice the frame rate picks every frame up within half a frame period
+	const auto pollInterval = duration_cast<steady_clock::duration>(duration<double>(0.5 / fps));
+
+	while (!shutdown_requested()) {
+		auto start = steady_clock::now();
+		updateStartedUs.store(pipeline_clock_us(), std::memory_order_relaxed);
+		astra_update();
+		auto busy = steady_clock::now() - start;
+
+		// Sleep out the rest of the poll interval, and long enough that time spent
+		// inside astra_update() stays within the CPU budget
+		auto idle = std::max(pollInterval - busy, busy * (100 - budget) / budget);
+		if (idle > steady_clock::duration::zero())
+			std::this_thread::sleep_for(idle);
+	}
+}
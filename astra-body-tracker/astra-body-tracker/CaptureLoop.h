@@ -0,0 +1,33 @@
+#ifndef CAPTURELOOP_H
+#define CAPTURELOOP_H
+
+#include <cstdint>
+
+struct CaptureLoopSettings
+{
+	// Rate the depth stream was configured for; the loop polls at twice this
+	int fps = 30;
+
+	// Share of one core, in percent, the loop may spend inside astra_update()
+	int cpuBudget = 100;
+};
+
+// Routes SIGINT/SIGTERM (and console close on Windows) to request_shutdown().
+// With watchStdin, end of input on stdin requests shutdown as well, which is
+// how the Electron app stops the tracker gracefully.
+void install_shutdown_handlers(bool watchStdin);
+
+void request_shutdown();
+bool shutdown_requested();
+
+// Lets a pending console close event return once cleanup has finished
+void shutdown_complete();
+
+// Pumps astra_update() at the configured rate until shutdown is requested
+void run_capture_loop(const CaptureLoopSettings& settings);
+
+// When the current astra_update() call was entered, on pipeline_clock_us().
+// Frame callbacks run inside that call, so this is when their frame was asked for.
+uint64_t capture_update_started_us();
+
+#endif /* CAPTURELOOP_H */
@@ -0,0 +1,293 @@
+#include "DeltaCodec.h"
+#include <cstring>
+#include <math.h>
+
+static const uint8_t FRAME_KEYFRAME = 1;
+
+static const uint8_t BODY_NO_REFERENCE = 1;
+static const uint8_t BODY_MASK = 2;
+static const uint8_t BODY_JOINTS_ENABLED = 4;
+
+// Clamped well inside int32 so differences of two values cannot overflow an int64
+static int32_t quantize(float v, float scale)
+{
+	float scaled = v * scale;
+	if (!(scaled > -1.0e9f))
+		return -1000000000;
+	if (scaled > 1.0e9f)
+		return 1000000000;
+	return static_cast<int32_t>(lrintf(scaled));
+}
+
+static int32_t quantize_angle(float degrees)
+{
+	if (isnan(degrees))
+		return DELTA_NO_ANGLE;
+	return quantize(degrees, 100.0f);
+}
+
+static void put_varint(std::vector<uint8_t>& out, uint64_t v)
+{
+	while (v >= 0x80) {
+		out.push_back(static_cast<uint8_t>(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(v));
+}
+
+static void put_svarint(std::vector<uint8_t>& out, int64_t v)
+{
+	put_varint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+const DeltaBody* DeltaReference::find(uint8_t id) const
+{
+	for (uint32_t i = 0; i < bodyCount; i++) {
+		if (bodies[i].id == id)
+			return &bodies[i];
+	}
+	return nullptr;
+}
+
+DeltaEncoder::DeltaEncoder(const DeltaSettings& settings)
+	: settings_(settings)
+{
+	if (settings_.positionScale < 1)
+		settings_.positionScale = 1;
+	if (settings_.positionScale > DELTA_MAX_SCALE)
+		settings_.positionScale = DELTA_MAX_SCALE;
+	scratch_.reserve(4096);
+}
+
+bool DeltaEncoder::encode(const FrameRecord& record, sf::Packet& packet)
+{
+	bool keyframe = !reference_.valid || sinceKeyframe_ >= settings_.keyframeInterval;
+	if (keyframe)
+		sinceKeyframe_ = 0;
+	sinceKeyframe_++;
+
+	uint32_t bodyCount = record.bodyCount < ASTRA_MAX_BODIES ? record.bodyCount : ASTRA_MAX_BODIES;
+	float scale = static_cast<float>(settings_.positionScale);
+
+	scratch_.clear();
+	scratch_.push_back(keyframe ? FRAME_KEYFRAME : 0);
+	scratch_.push_back(static_cast<uint8_t>(settings_.positionScale));
+	put_varint(scratch_, sequence_);
+	if (keyframe) {
+		put_varint(scratch_, record.frameNumber);
+		put_varint(scratch_, record.elapsedMs);
+		put_varint(scratch_, record.timestampUs);
+	}
+	else {
+		put_svarint(scratch_, static_cast<int64_t>(record.frameNumber) - reference_.frameNumber);
+		put_varint(scratch_, record.elapsedMs);
+		put_svarint(scratch_, static_cast<int64_t>(record.timestampUs - reference_.timestampUs));
+	}
+	scratch_.push_back(static_cast<uint8_t>(bodyCount));
+
+	DeltaReference next;
+	next.valid = true;
+	next.sequence = sequence_++;
+	next.frameNumber = record.frameNumber;
+	next.timestampUs = record.timestampUs;
+	next.bodyCount = bodyCount;
+
+	for (uint32_t i = 0; i < bodyCount; i++) {
+		const BodyRecord& body = record.bodies[i];
+		const DeltaBody* prev = keyframe ? nullptr : reference_.find(body.id);
+
+		DeltaBody& q = next.bodies[i];
+		q.id = body.id;
+		q.jointMask = body.jointsEnabled ? body.jointMask & ((1u << ASTRA_MAX_JOINTS) - 1) : 0;
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			bool valid = (q.jointMask & (1u << n)) != 0;
+			for (int axis = 0; axis < 3; axis++)
+				q.joints[n][axis] = valid ? quantize(body.joints[n][axis], scale) : 0;
+		}
+		q.shoulderAngle = quantize_angle(body.shoulderAngle);
+		q.hipAngle = quantize_angle(body.hipAngle);
+
+		uint8_t flags = body.jointsEnabled ? BODY_JOINTS_ENABLED : 0;
+		if (!prev)
+			flags |= BODY_NO_REFERENCE | BODY_MASK;
+		else if (prev->jointMask != q.jointMask)
+			flags |= BODY_MASK;
+
+		scratch_.push_back(body.id);
+		scratch_.push_back(body.status);
+		scratch_.push_back(flags);
+		if (flags & BODY_MASK)
+			put_varint(scratch_, prev ? q.jointMask ^ prev->jointMask : q.jointMask);
+
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			if ((q.jointMask & (1u << n)) == 0)
+				continue;
+			bool referenced = prev && (prev->jointMask & (1u << n)) != 0;
+			for (int axis = 0; axis < 3; axis++) {
+				int64_t base = referenced ? prev->joints[n][axis] : 0;
+				put_svarint(scratch_, q.joints[n][axis] - base);
+			}
+		}
+		put_svarint(scratch_, static_cast<int64_t>(q.shoulderAngle) - (prev ? prev->shoulderAngle : 0));
+		put_svarint(scratch_, static_cast<int64_t>(q.hipAngle) - (prev ? prev->hipAngle : 0));
+	}
+
+	reference_ = next;
+
+	packet.clear();
+	packet.append(scratch_.data(), scratch_.size());
+	return keyframe;
+}
+
+// Bounds-checked reads; any read past the end clears ok and returns zero
+struct PacketReader
+{
+	const uint8_t* p;
+	const uint8_t* end;
+	bool ok;
+
+	uint8_t u8()
+	{
+		if (p == end) {
+			ok = false;
+			return 0;
+		}
+		return *p++;
+	}
+
+	uint64_t varint()
+	{
+		uint64_t v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t byte = u8();
+			v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return v;
+		}
+		ok = false;
+		return 0;
+	}
+
+	int64_t svarint()
+	{
+		uint64_t v = varint();
+		return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+	}
+};
+
+static float angle_degrees(int32_t v)
+{
+	return v == DELTA_NO_ANGLE ? NAN : v / 100.0f;
+}
+
+bool DeltaDecoder::decode(const sf::Packet& packet, FrameRecord& record)
+{
+	const uint8_t* data = static_cast<const uint8_t*>(packet.getData());
+	PacketReader in = { data, data + packet.getDataSize(), true };
+
+	bool keyframe = (in.u8() & FRAME_KEYFRAME) != 0;
+	uint8_t scaleUnits = in.u8();
+	uint32_t sequence = static_cast<uint32_t>(in.varint());
+
+	// A delta after a lost packet would decode against the wrong frame
+	bool follows = reference_.valid && sequence == reference_.sequence + 1;
+	if (!in.ok || scaleUnits == 0 || (!keyframe && !follows)) {
+		reference_.valid = false;
+		return false;
+	}
+	float scale = 1.0f / scaleUnits;
+
+	DeltaReference next;
+	next.valid = true;
+	next.sequence = sequence;
+	if (keyframe) {
+		next.frameNumber = static_cast<uint32_t>(in.varint());
+		record.elapsedMs = static_cast<uint32_t>(in.varint());
+		next.timestampUs = in.varint();
+	}
+	else {
+		next.frameNumber = static_cast<uint32_t>(reference_.frameNumber + in.svarint());
+		record.elapsedMs = static_cast<uint32_t>(in.varint());
+		next.timestampUs = reference_.timestampUs + static_cast<uint64_t>(in.svarint());
+	}
+
+	next.bodyCount = in.u8();
+	if (next.bodyCount > ASTRA_MAX_BODIES)
+		in.ok = false;
+
+	for (uint32_t i = 0; in.ok && i < next.bodyCount; i++) {
+		DeltaBody& q = next.bodies[i];
+		BodyRecord& body = record.bodies[i];
+		q.id = in.u8();
+		body.status = in.u8();
+		uint8_t flags = in.u8();
+
+		const DeltaBody* prev = (flags & BODY_NO_REFERENCE) ? nullptr : reference_.find(q.id);
+		if (!(flags & BODY_NO_REFERENCE) && (keyframe || !prev)) {
+			in.ok = false;
+			break;
+		}
+
+		if (flags & BODY_MASK) {
+			uint32_t mask = static_cast<uint32_t>(in.varint());
+			q.jointMask = prev ? prev->jointMask ^ mask : mask;
+		}
+		else {
+			if (!prev) {
+				in.ok = false;
+				break;
+			}
+			q.jointMask = prev->jointMask;
+		}
+		q.jointMask &= (1u << ASTRA_MAX_JOINTS) - 1;
+
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			bool valid = (q.jointMask & (1u << n)) != 0;
+			bool referenced = valid && prev && (prev->jointMask & (1u << n)) != 0;
+			for (int axis = 0; axis < 3; axis++) {
+				int64_t v = valid ? in.svarint() : 0;
+				q.joints[n][axis] = static_cast<int32_t>(referenced ? prev->joints[n][axis] + v : v);
+				body.joints[n][axis] = q.joints[n][axis] * scale;
+			}
+			body.orientations[n] = MISSING_ROTATION;
+		}
+		q.shoulderAngle = static_cast<int32_t>(in.svarint() + (prev ? prev->shoulderAngle : 0));
+		q.hipAngle = static_cast<int32_t>(in.svarint() + (prev ? prev->hipAngle : 0));
+
+		body.id = q.id;
+		body.jointsEnabled = (flags & BODY_JOINTS_ENABLED) != 0;
+		body.jointMask = q.jointMask;
+		body.shoulderAngle = angle_degrees(q.shoulderAngle);
+		body.hipAngle = angle_degrees(q.hipAngle);
+		body.trunkRotation = NAN;
+		for (SegmentAngles& segment : body.spine)
+			segment.flexion = segment.lateral = segment.axial = NAN;
+	}
+
+	if (!in.ok || in.p != in.end) {
+		reference_.valid = false;
+		return false;
+	}
+
+	record.frameNumber = next.frameNumber;
+	record.timestampUs = next.timestampUs;
+	record.bodyCount = next.bodyCount;
+	record.timing = FrameTiming();
+	reference_ = next;
+	return true;
+}
+
+void append_framed(const sf::Packet& packet, std::vector<char>& out)
+{
+	uint32_t size = static_cast<uint32_t>(packet.getDataSize());
+	const char* data = static_cast<const char*>(packet.getData());
+
+	size_t offset = out.size();
+	out.resize(offset + 4 + size);
+	out[offset + 0] = static_cast<char>(size >> 24);
+	out[offset + 1] = static_cast<char>(size >> 16);
+	out[offset + 2] = static_cast<char>(size >> 8);
+	out[offset + 3] = static_cast<char>(size);
+	if (size > 0)
+		memcpy(&out[offset + 4], data, size);
+}
@@ -0,0 +1,113 @@
+#ifndef DELTACODEC_H
+#define DELTACODEC_H
+
+#include "FrameRecord.h"
+#include <SFML/Network/Packet.hpp>
+#include <vector>
+
+/*
+	Compact frame packets for remote stations. Positions are quantized to
+	integer units of 1 / positionScale mm and, between keyframes, sent as
+	differences to the same body in the previous frame, which are a few units
+	and fit a single varint byte. One packet per frame:
+
+	uint8       flags: bit 0 keyframe
+	uint8       position scale, units per mm
+	varint      packet sequence number, one more than the packet before
+	varint      frame number; on deltas, the difference to the previous frame
+	varint      milliseconds since the previous frame
+	varint      microseconds since the tracker started; on deltas, the difference
+	uint8       body count
+	per body:
+	uint8       body id
+	uint8       body status (astra::BodyStatus)
+	uint8       flags: bit 0 no reference, everything below is absolute
+	                   bit 1 joint mask follows
+	                   bit 2 joints enabled
+	varint      joint mask; with a reference, XOR with the previous mask, so
+	            only joints whose validity changed have a bit set
+	svarint     x, y, z of each valid joint in joint order, as differences when
+	            the joint was also valid in the reference
+	svarint     shoulder and hip angles in hundredths of a degree, as differences
+	            with a reference; DELTA_NO_ANGLE when missing
+
+	varint is LEB128, svarint is a zig-zag mapped varint. Bodies without a
+	previous frame, and every body of a keyframe, have no reference. Every
+	keyframeInterval frames is a keyframe. A delta whose sequence number does
+	not follow the last packet decoded refers to a frame the receiver never
+	saw, so the receiver drops it and every delta after it, resynchronising at
+	the next keyframe: within keyframeInterval frames, or at once when the
+	encoder is asked for one. Orientations and spine angles are not carried.
+*/
+const int DELTA_DEFAULT_SCALE = 1;
+const int DELTA_MAX_SCALE = 10;
+const uint32_t DELTA_KEYFRAME_INTERVAL = 30;
+const int32_t DELTA_NO_ANGLE = -32768;
+
+struct DeltaSettings
+{
+	// Position units per mm, 1 for whole millimetres
+	int positionScale = DELTA_DEFAULT_SCALE;
+	uint32_t keyframeInterval = DELTA_KEYFRAME_INTERVAL;
+};
+
+// Quantized body as both ends remember it between packets
+struct DeltaBody
+{
+	uint8_t id;
+	uint32_t jointMask;
+	int32_t joints[ASTRA_MAX_JOINTS][3];
+	int32_t shoulderAngle;
+	int32_t hipAngle;
+};
+
+struct DeltaReference
+{
+	bool valid = false;
+	uint32_t sequence = 0;
+	uint32_t frameNumber = 0;
+	uint64_t timestampUs = 0;
+	uint32_t bodyCount = 0;
+	DeltaBody bodies[ASTRA_MAX_BODIES];
+
+	const DeltaBody* find(uint8_t id) const;
+};
+
+class DeltaEncoder
+{
+public:
+	explicit DeltaEncoder(const DeltaSettings& settings = DeltaSettings());
+
+	// Replaces the contents of packet with record. Returns true for a keyframe.
+	bool encode(const FrameRecord& record, sf::Packet& packet);
+
+	// Makes the next packet a keyframe
+	void request_keyframe() { reference_.valid = false; }
+
+private:
+	DeltaSettings settings_;
+	DeltaReference reference_;
+	uint32_t sequence_ = 0;
+	uint32_t sinceKeyframe_ = 0;
+	std::vector<uint8_t> scratch_;
+};
+
+class DeltaDecoder
+{
+public:
+	// Fills record from packet. Returns false for malformed packets, for a
+	// delta that does not follow the packet decoded before it, and for every
+	// delta after that until the next keyframe.
+	bool decode(const sf::Packet& packet, FrameRecord& record);
+
+	bool synchronised() const { return reference_.valid; }
+
+private:
+	DeltaReference reference_;
+};
+
+// Appends packet the way sf::TcpSocket frames packets, a big-endian uint32
+// size and the data, so a client can receive it as an sf::Packet
+void append_framed(const sf::Packet& packet, std::vector<char>& out);
+
+#endif /* DELTACODEC_H */
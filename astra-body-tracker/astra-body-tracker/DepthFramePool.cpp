@@ -0,0 +1,200 @@
+#include "DepthFramePool.h"
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static uint32_t lowest_set_bit(uint64_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return index;
+#else
+	return static_cast<uint32_t>(__builtin_ctzll(mask));
+#endif
+}
+
+DepthFrameRef::DepthFrameRef(const DepthFrameRef& other)
+	: pool_(other.pool_),
+	slot_(other.slot_)
+{
+	if (pool_)
+		pool_->add_ref(slot_);
+}
+
+DepthFrameRef::DepthFrameRef(DepthFrameRef&& other)
+	: pool_(other.pool_),
+	slot_(other.slot_)
+{
+	other.pool_ = nullptr;
+}
+
+DepthFrameRef& DepthFrameRef::operator=(DepthFrameRef other)
+{
+	std::swap(pool_, other.pool_);
+	std::swap(slot_, other.slot_);
+	return *this;
+}
+
+DepthFrameRef::~DepthFrameRef()
+{
+	reset();
+}
+
+void DepthFrameRef::reset()
+{
+	if (pool_)
+		pool_->release(slot_);
+	pool_ = nullptr;
+}
+
+const int16_t* DepthFrameRef::data() const
+{
+	return pool_->buffer(slot_);
+}
+
+const uint8_t* DepthFrameRef::body_mask() const
+{
+	return pool_->slots_[slot_].hasMask ? pool_->mask_buffer(slot_) : nullptr;
+}
+
+uint32_t DepthFrameRef::body_count() const
+{
+	return pool_->slots_[slot_].bodyCount;
+}
+
+const BodyRecord* DepthFrameRef::bodies() const
+{
+	return pool_->slots_[slot_].bodies;
+}
+
+int DepthFrameRef::width() const
+{
+	return pool_->slots_[slot_].width;
+}
+
+int DepthFrameRef::height() const
+{
+	return pool_->slots_[slot_].height;
+}
+
+uint32_t DepthFrameRef::frame_index() const
+{
+	return pool_->slots_[slot_].frameIndex;
+}
+
+uint64_t DepthFrameRef::timestamp_us() const
+{
+	return pool_->slots_[slot_].timestampUs;
+}
+
+DepthFramePool::DepthFramePool(uint32_t capacity, int width, int height)
+	: capacity_(capacity < 1 ? 1 : capacity > DEPTH_POOL_MAX_FRAMES ? DEPTH_POOL_MAX_FRAMES : capacity),
+	bufferPixels_(static_cast<size_t>(width) * height),
+	pixels_(capacity_ * bufferPixels_),
+	masks_(capacity_ * bufferPixels_),
+	slots_(new Slot[capacity_])
+{
+	for (uint32_t i = 0; i < capacity_; i++) {
+		slots_[i].refs.store(0, std::memory_order_relaxed);
+		slots_[i].hasMask = false;
+		slots_[i].bodyCount = 0;
+	}
+	freeMask_.store(capacity_ == 64 ? ~0ull : (1ull << capacity_) - 1, std::memory_order_release);
+}
+
+bool DepthFramePool::acquire(uint32_t& slot)
+{
+	uint64_t mask = freeMask_.load(std::memory_order_acquire);
+	while (mask != 0) {
+		uint64_t bit = mask & (~mask + 1);
+		if (freeMask_.compare_exchange_weak(mask, mask & ~bit, std::memory_order_acquire, std::memory_order_acquire)) {
+			slot = lowest_set_bit(bit);
+			slots_[slot].refs.store(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void DepthFramePool::add_ref(uint32_t slot)
+{
+	slots_[slot].refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DepthFramePool::release(uint32_t slot)
+{
+	// The last reader's accesses must happen before the producer refills the buffer
+	if (slots_[slot].refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		freeMask_.fetch_or(1ull << slot, std::memory_order_release);
+}
+
+void DepthFramePool::copy_bodies(Slot& slot, const FrameRecord* record)
+{
+	slot.bodyCount = record ? record->bodyCount : 0;
+	for (uint32_t i = 0; i < slot.bodyCount; i++)
+		slot.bodies[i] = record->bodies[i];
+}
+
+DepthFrameRef DepthFramePool::retain(const astra::DepthFrame& frame, const astra::BodyMask* mask,
+	const FrameRecord* record, uint64_t timestampUs)
+{
+	if (!frame.is_valid() || frame.length() > bufferPixels_) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return DepthFrameRef();
+	}
+
+	uint32_t slot;
+	if (!acquire(slot)) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return DepthFrameRef();
+	}
+
+	frame.copy_to(buffer(slot));
+	Slot& s = slots_[slot];
+	s.width = frame.width();
+	s.height = frame.height();
+	s.frameIndex = static_cast<uint32_t>(frame.frame_index());
+	s.timestampUs = timestampUs;
+	s.hasMask = mask && mask->width() == s.width && mask->height() == s.height;
+	if (s.hasMask)
+		memcpy(mask_buffer(slot), mask->data(), mask->byte_length());
+	copy_bodies(s, record);
+	return DepthFrameRef(this, slot);
+}
+
+DepthFrameRef DepthFramePool::retain(const int16_t* pixels, const uint8_t* mask, const FrameRecord* record,
+	int width, int height, uint32_t frameIndex, uint64_t timestampUs)
+{
+	size_t count = static_cast<size_t>(width) * height;
+	uint32_t slot;
+	if (count > bufferPixels_ || !acquire(slot)) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return DepthFrameRef();
+	}
+
+	memcpy(buffer(slot), pixels, count * sizeof(int16_t));
+	Slot& s = slots_[slot];
+	s.width = width;
+	s.height = height;
+	s.frameIndex = frameIndex;
+	s.timestampUs = timestampUs;
+	s.hasMask = mask != nullptr;
+	if (s.hasMask)
+		memcpy(mask_buffer(slot), mask, count);
+	copy_bodies(s, record);
+	return DepthFrameRef(this, slot);
+}
+
+uint32_t DepthFramePool::frames_in_use() const
+{
+	uint64_t free = freeMask_.load(std::memory_order_relaxed);
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < capacity_; i++) {
+		if (!(free & (1ull << i)))
+			count++;
+	}
+	return count;
+}
@@ -0,0 +1,145 @@
+#ifndef DEPTHFRAMEPOOL_H
+#define DEPTHFRAMEPOOL_H
+
+#include "FrameRecord.h"
+
+#include <astra/astra.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+const int DEPTH_WIDTH = 640;
+const int DEPTH_HEIGHT = 480;
+
+// Frames in flight by default: one being filled, a few queued, a few being analysed
+const uint32_t DEPTH_POOL_DEFAULT_FRAMES = 8;
+
+// Most buffers a pool can have, one bit each in its free mask
+const uint32_t DEPTH_POOL_MAX_FRAMES = 64;
+
+class DepthFramePool;
+
+// Shared, read-only view of a depth frame held in a DepthFramePool. Copies share
+// the buffer; it goes back to the pool when the last copy is destroyed or reset.
+// Copying and releasing are lock-free and safe from any thread.
+class DepthFrameRef
+{
+public:
+	DepthFrameRef() { }
+	DepthFrameRef(const DepthFrameRef& other);
+	DepthFrameRef(DepthFrameRef&& other);
+	DepthFrameRef& operator=(DepthFrameRef other);
+	~DepthFrameRef();
+
+	void reset();
+
+	explicit operator bool() const { return pool_ != nullptr; }
+
+	// Row-major millimetres, width() * height() pixels, 0 where there is no depth
+	const int16_t* data() const;
+
+	// Body id of each pixel, 0 for background, in the same layout as data();
+	// nullptr when the frame was retained without a body mask
+	const uint8_t* body_mask() const;
+
+	// Bodies extracted from the same frame, with filtered joints; none when the
+	// frame was retained without them
+	uint32_t body_count() const;
+	const BodyRecord* bodies() const;
+	int width() const;
+	int height() const;
+	uint32_t frame_index() const;
+	uint64_t timestamp_us() const;
+
+private:
+	friend class DepthFramePool;
+	DepthFrameRef(DepthFramePool* pool, uint32_t slot)
+		: pool_(pool),
+		slot_(slot)
+	{
+	}
+
+	DepthFramePool* pool_ = nullptr;
+	uint32_t slot_ = 0;
+};
+
+/*
+	Preallocated depth buffers for frames that must outlive on_frame_ready,
+	where DepthFrame::data() stops being valid. retain() copies a frame once
+	into a free buffer and every consumer shares that copy through
+	DepthFrameRef; nothing is allocated per frame. The body mask and the
+	extracted bodies of the same astra::Frame can be kept with the depth, so
+	analysis sees all three from one instant.
+
+	Free buffers are bits in an atomic mask, so retaining and releasing never
+	take a lock. When every buffer is held the frame is dropped and counted
+	rather than waiting for a consumer. The pool must outlive its refs.
+*/
+class DepthFramePool
+{
+public:
+	explicit DepthFramePool(uint32_t capacity = DEPTH_POOL_DEFAULT_FRAMES,
+		int width = DEPTH_WIDTH, int height = DEPTH_HEIGHT);
+
+	DepthFramePool(const DepthFramePool&) = delete;
+	DepthFramePool& operator=(const DepthFramePool&) = delete;
+
+	// Copies the frame, the body mask when one of the same size is given and
+	// the bodies of record when given into a free buffer; an empty ref when
+	// none is free or the frame is larger than the buffers
+	DepthFrameRef retain(const astra::DepthFrame& frame, const astra::BodyMask* mask,
+		const FrameRecord* record, uint64_t timestampUs);
+	DepthFrameRef retain(const int16_t* pixels, const uint8_t* mask, const FrameRecord* record,
+		int width, int height, uint32_t frameIndex, uint64_t timestampUs);
+
+	uint32_t capacity() const { return capacity_; }
+	uint32_t frames_in_use() const;
+	uint64_t dropped_frames() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	friend class DepthFrameRef;
+
+	struct Slot
+	{
+		std::atomic<uint32_t> refs;
+		int width;
+		int height;
+		uint32_t frameIndex;
+		uint64_t timestampUs;
+		bool hasMask;
+		uint32_t bodyCount;
+		BodyRecord bodies[ASTRA_MAX_BODIES];
+	};
+
+	// Claims a free buffer with one reference, or returns false
+	bool acquire(uint32_t& slot);
+	void add_ref(uint32_t slot);
+	void release(uint32_t slot);
+	void copy_bodies(Slot& slot, const FrameRecord* record);
+
+	int16_t* buffer(uint32_t slot) { return &pixels_[static_cast<size_t>(slot) * bufferPixels_]; }
+	uint8_t* mask_buffer(uint32_t slot) { return &masks_[static_cast<size_t>(slot) * bufferPixels_]; }
+
+	uint32_t capacity_;
+	size_t bufferPixels_;
+	std::vector<int16_t> pixels_;
+	std::vector<uint8_t> masks_;
+	std::unique_ptr<Slot[]> slots_;
+
+	// Bit n set while buffer n is free
+	std::atomic<uint64_t> freeMask_;
+	std::atomic<uint64_t> dropped_{ 0 };
+};
+
+// Receives every retained depth frame on the SDK thread; must not block.
+// Keep a copy of the ref to use the frame later.
+class DepthConsumer
+{
+public:
+	virtual ~DepthConsumer() { }
+
+	virtual void consume(const DepthFrameRef& frame) = 0;
+};
+
+#endif /* DEPTHFRAMEPOOL_H */
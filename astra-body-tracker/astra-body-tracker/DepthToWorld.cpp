@@ -0,0 +1,111 @@
+#include "DepthToWorld.h"
+
+DepthToWorld::DepthToWorld(const astra_conversion_cache_t& cache)
+	: width_(cache.resolutionX),
+	height_(cache.resolutionY),
+	columnFactor_(cache.resolutionX > 0 ? cache.resolutionX : 0),
+	rowFactor_(cache.resolutionY > 0 ? cache.resolutionY : 0)
+{
+	for (int u = 0; u < width_; u++)
+		columnFactor_[u] = (static_cast<float>(u) / width_ - 0.5f) * cache.xzFactor;
+	for (int v = 0; v < height_; v++)
+		rowFactor_[v] = (0.5f - static_cast<float>(v) / height_) * cache.yzFactor;
+}
+
+DepthRow DepthToWorld::row(const int16_t* depth, const uint8_t* mask, int v) const
+{
+	size_t first = static_cast<size_t>(v) * width_;
+	DepthRow row = { depth + first, mask ? mask + first : nullptr,
+		columnFactor_.data(), rowFactor_[v], width_, static_cast<uint32_t>(first) };
+	return row;
+}
+
+bool DepthToWorld::convert(const int16_t* depth, int width, int height, const PointColumns& out, SimdLevel level) const
+{
+	if (width != width_ || height != height_)
+		return false;
+
+	bool avx2 = level == SimdLevel::Avx2 && detect_simd_level() == SimdLevel::Avx2;
+	for (int v = 0; v < height_; v++) {
+		DepthRow r = row(depth, nullptr, v);
+		PointColumns rowOut = { out.x + r.firstPixel, out.y + r.firstPixel, out.z + r.firstPixel,
+			out.pixel ? out.pixel + r.firstPixel : nullptr };
+
+		int done = avx2 ? world_row_avx2(r, rowOut) : 0;
+		world_row_scalar(r, done, rowOut);
+	}
+	return true;
+}
+
+bool DepthToWorld::convert(const int16_t* depth, int width, int height, astra::Vector3f* out, SimdLevel level) const
+{
+	static_assert(sizeof(astra::Vector3f) == 3 * sizeof(float), "Vector3f must be three packed floats");
+
+	if (width != width_ || height != height_)
+		return false;
+
+	bool avx2 = level == SimdLevel::Avx2 && detect_simd_level() == SimdLevel::Avx2;
+	for (int v = 0; v < height_; v++) {
+		DepthRow r = row(depth, nullptr, v);
+		float* xyz = &out[r.firstPixel].x;
+
+		int done = avx2 ? world_row_interleaved_avx2(r, xyz) : 0;
+		world_row_interleaved_scalar(r, done, xyz);
+	}
+	return true;
+}
+
+size_t DepthToWorld::convert_masked(const int16_t* depth, const uint8_t* mask, int width, int height,
+	const PointColumns& out, SimdLevel level) const
+{
+	if (width != width_ || height != height_)
+		return 0;
+
+	bool avx2 = level == SimdLevel::Avx2 && detect_simd_level() == SimdLevel::Avx2;
+	size_t count = 0;
+	for (int v = 0; v < height_; v++) {
+		DepthRow r = row(depth, mask, v);
+
+		int done = avx2 ? world_row_masked_avx2(r, out, count) : 0;
+		world_row_masked_scalar(r, done, out, count);
+	}
+	return count;
+}
+
+void world_row_scalar(const DepthRow& row, int begin, const PointColumns& out)
+{
+	for (int u = begin; u < row.width; u++) {
+		float z = row.depth[u];
+		out.x[u] = row.columnFactor[u] * z;
+		out.y[u] = row.rowFactor * z;
+		out.z[u] = z;
+		if (out.pixel)
+			out.pixel[u] = row.firstPixel + u;
+	}
+}
+
+void world_row_interleaved_scalar(const DepthRow& row, int begin, float* xyz)
+{
+	for (int u = begin; u < row.width; u++) {
+		float z = row.depth[u];
+		xyz[u * 3 + 0] = row.columnFactor[u] * z;
+		xyz[u * 3 + 1] = row.rowFactor * z;
+		xyz[u * 3 + 2] = z;
+	}
+}
+
+void world_row_masked_scalar(const DepthRow& row, int begin, const PointColumns& out, size_t& count)
+{
+	for (int u = begin; u < row.width; u++) {
+		if (row.depth[u] <= 0 || (row.mask && !row.mask[u]))
+			continue;
+
+		float z = row.depth[u];
+		out.x[count] = row.columnFactor[u] * z;
+		out.y[count] = row.rowFactor * z;
+		out.z[count] = z;
+		if (out.pixel)
+			out.pixel[count] = row.firstPixel + u;
+		count++;
+	}
+}
@@ -0,0 +1,93 @@
+#ifndef DEPTHTOWORLD_H
+#define DEPTHTOWORLD_H
+
+#include "PostureKernels.h"
+
+#include <astra/astra.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+	Whole-frame depth to world conversion from the stream's conversion cache
+	(DepthStream::depth_to_world_data()), the same mapping as
+	CoordinateMapper::convert_depth_to_world without a C API call per pixel:
+
+	    x = (u / resolutionX - 0.5) * xzFactor * z
+	    y = (0.5 - v / resolutionY) * yzFactor * z
+
+	for pixel (u, v) with depth z in mm, giving millimetres in the body
+	tracker's coordinate system. The column and row factors are computed once,
+	so a pixel costs two multiplies. Results match the SDK to within float
+	rounding and do not depend on the SIMD level.
+
+	Depth is the row-major int16 buffer of a DepthFrame or DepthFrameRef and
+	must be as large as the cache's resolution.
+*/
+
+// Destination arrays, one entry per converted pixel. pixel is optional and
+// receives the row-major index v * width + u of each point.
+struct PointColumns
+{
+	float* x;
+	float* y;
+	float* z;
+	uint32_t* pixel;
+};
+
+// One row of a conversion, as the kernels see it
+struct DepthRow
+{
+	const int16_t* depth;
+	const uint8_t* mask;
+	const float* columnFactor;
+	float rowFactor;
+	int width;
+	uint32_t firstPixel;
+};
+
+class DepthToWorld
+{
+public:
+	explicit DepthToWorld(const astra_conversion_cache_t& cache);
+
+	int width() const { return width_; }
+	int height() const { return height_; }
+
+	// Every pixel, pixels without depth as (0, 0, 0); out holds width() * height()
+	// entries. False when the frame does not have the cache's resolution.
+	bool convert(const int16_t* depth, int width, int height, const PointColumns& out,
+		SimdLevel level = detect_simd_level()) const;
+
+	// The same into interleaved points
+	bool convert(const int16_t* depth, int width, int height, astra::Vector3f* out,
+		SimdLevel level = detect_simd_level()) const;
+
+	// Only pixels with depth whose mask byte is not zero, packed in pixel order.
+	// Returns the number of points; out must hold width() * height() entries.
+	// A null mask converts every pixel that has depth.
+	size_t convert_masked(const int16_t* depth, const uint8_t* mask, int width, int height,
+		const PointColumns& out, SimdLevel level = detect_simd_level()) const;
+
+	// Row v of a frame of the cache's resolution, for callers that run the
+	// row kernels themselves
+	DepthRow row(const int16_t* depth, const uint8_t* mask, int v) const;
+
+private:
+	int width_;
+	int height_;
+	std::vector<float> columnFactor_;
+	std::vector<float> rowFactor_;
+};
+
+// Columns begin .. width - 1 of one row at one level. The AVX2 kernels stop
+// before the last partial vector and return the first column they did not
+// convert; the masked kernels add the points they write to count.
+void world_row_scalar(const DepthRow& row, int begin, const PointColumns& out);
+void world_row_interleaved_scalar(const DepthRow& row, int begin, float* xyz);
+void world_row_masked_scalar(const DepthRow& row, int begin, const PointColumns& out, size_t& count);
+int world_row_avx2(const DepthRow& row, const PointColumns& out);
+int world_row_interleaved_avx2(const DepthRow& row, float* xyz);
+int world_row_masked_avx2(const DepthRow& row, const PointColumns& out, size_t& count);
+
+#endif /* DEPTHTOWORLD_H */
@@ -0,0 +1,138 @@
+// Built with /arch:AVX2 and only called after detect_simd_level() reports AVX2,
+// so nothing in here may be reachable from code that runs before that check.
+#include "DepthToWorld.h"
+#include <immintrin.h>
+
+static inline __m256 load_depth(const int16_t* depth)
+{
+	__m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth));
+	return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(raw));
+}
+
+int world_row_avx2(const DepthRow& row, const PointColumns& out)
+{
+	const __m256 rowFactor = _mm256_set1_ps(row.rowFactor);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	int u = 0;
+	for (; u + 8 <= row.width; u += 8) {
+		__m256 z = load_depth(row.depth + u);
+		_mm256_storeu_ps(out.x + u, _mm256_mul_ps(_mm256_loadu_ps(row.columnFactor + u), z));
+		_mm256_storeu_ps(out.y + u, _mm256_mul_ps(rowFactor, z));
+		_mm256_storeu_ps(out.z + u, z);
+		if (out.pixel) {
+			__m256i pixel = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(row.firstPixel + u)), lanes);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out.pixel + u), pixel);
+		}
+	}
+
+	_mm256_zeroupper();
+	return u;
+}
+
+int world_row_interleaved_avx2(const DepthRow& row, float* xyz)
+{
+	const __m256 rowFactor = _mm256_set1_ps(row.rowFactor);
+
+	// Eight points go out as three vectors
+	//   x0 y0 z0 x1 y1 z1 x2 y2 | z2 x3 y3 z3 x4 y4 z4 x5 | y5 z5 x6 y6 z6 x7 y7 z7
+	// each gathering its lanes from x, y and z with one permute per source
+	const __m256i x0 = _mm256_setr_epi32(0, 0, 0, 1, 0, 0, 2, 0);
+	const __m256i y0 = _mm256_setr_epi32(0, 0, 0, 0, 1, 0, 0, 2);
+	const __m256i z0 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 0, 0);
+	const __m256i x1 = _mm256_setr_epi32(0, 3, 0, 0, 4, 0, 0, 5);
+	const __m256i y1 = _mm256_setr_epi32(0, 0, 3, 0, 0, 4, 0, 0);
+	const __m256i z1 = _mm256_setr_epi32(2, 0, 0, 3, 0, 0, 4, 0);
+	const __m256i x2 = _mm256_setr_epi32(0, 0, 6, 0, 0, 7, 0, 0);
+	const __m256i y2 = _mm256_setr_epi32(5, 0, 0, 6, 0, 0, 7, 0);
+	const __m256i z2 = _mm256_setr_epi32(0, 5, 0, 0, 6, 0, 0, 7);
+
+	int u = 0;
+	for (; u + 8 <= row.width; u += 8) {
+		__m256 z = load_depth(row.depth + u);
+		__m256 x = _mm256_mul_ps(_mm256_loadu_ps(row.columnFactor + u), z);
+		__m256 y = _mm256_mul_ps(rowFactor, z);
+
+		// Blend immediates pick y (bit set) over x, then z over that
+		__m256 a = _mm256_blend_ps(_mm256_permutevar8x32_ps(x, x0), _mm256_permutevar8x32_ps(y, y0), 0x92);
+		a = _mm256_blend_ps(a, _mm256_permutevar8x32_ps(z, z0), 0x24);
+		__m256 b = _mm256_blend_ps(_mm256_permutevar8x32_ps(x, x1), _mm256_permutevar8x32_ps(y, y1), 0x24);
+		b = _mm256_blend_ps(b, _mm256_permutevar8x32_ps(z, z1), 0x49);
+		__m256 c = _mm256_blend_ps(_mm256_permutevar8x32_ps(x, x2), _mm256_permutevar8x32_ps(y, y2), 0x49);
+		c = _mm256_blend_ps(c, _mm256_permutevar8x32_ps(z, z2), 0x92);
+
+		float* dst = xyz + u * 3;
+		_mm256_storeu_ps(dst, a);
+		_mm256_storeu_ps(dst + 8, b);
+		_mm256_storeu_ps(dst + 16, c);
+	}
+
+	_mm256_zeroupper();
+	return u;
+}
+
+// Permutations that move the lanes selected by each 8-bit mask to the front,
+// four bits per lane index, and how many lanes each mask selects
+struct PackTable
+{
+	uint32_t entries[256];
+	uint8_t counts[256];
+
+	PackTable()
+	{
+		for (uint32_t mask = 0; mask < 256; mask++) {
+			uint32_t packed = 0, count = 0;
+			for (uint32_t lane = 0; lane < 8; lane++) {
+				if (mask & (1u << lane))
+					packed |= lane << (4 * count++);
+			}
+			entries[mask] = packed;
+			counts[mask] = static_cast<uint8_t>(count);
+		}
+	}
+};
+
+int world_row_masked_avx2(const DepthRow& row, const PointColumns& out, size_t& count)
+{
+	// Built on first use rather than at startup, which may run on a CPU without AVX2
+	static const PackTable table;
+
+	const __m256 rowFactor = _mm256_set1_ps(row.rowFactor);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i nibbleShifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+	const __m256i nibble = _mm256_set1_epi32(0xF);
+
+	int u = 0;
+	for (; u + 8 <= row.width; u += 8) {
+		__m256i depth = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row.depth + u)));
+		__m256i keep = _mm256_cmpgt_epi32(depth, _mm256_setzero_si256());
+		if (row.mask) {
+			__m128i maskBytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row.mask + u));
+			__m256i marked = _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(maskBytes), _mm256_setzero_si256());
+			keep = _mm256_andnot_si256(marked, keep);
+		}
+
+		int bits = _mm256_movemask_ps(_mm256_castsi256_ps(keep));
+		if (bits == 0)
+			continue;
+
+		__m256i order = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(table.entries[bits])), nibbleShifts), nibble);
+		__m256 z = _mm256_cvtepi32_ps(depth);
+		__m256 x = _mm256_mul_ps(_mm256_loadu_ps(row.columnFactor + u), z);
+		__m256 y = _mm256_mul_ps(rowFactor, z);
+
+		// Whole vectors are stored; lanes past the kept ones are overwritten by
+		// later points and never exceed the frame, since count <= pixels converted
+		_mm256_storeu_ps(out.x + count, _mm256_permutevar8x32_ps(x, order));
+		_mm256_storeu_ps(out.y + count, _mm256_permutevar8x32_ps(y, order));
+		_mm256_storeu_ps(out.z + count, _mm256_permutevar8x32_ps(z, order));
+		if (out.pixel) {
+			__m256i pixel = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(row.firstPixel + u)), lanes);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out.pixel + count), _mm256_permutevar8x32_epi32(pixel, order));
+		}
+		count += table.counts[bits];
+	}
+
+	_mm256_zeroupper();
+	return u;
+}
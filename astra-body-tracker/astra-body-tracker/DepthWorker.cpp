@@ -0,0 +1,77 @@
+#include "DepthWorker.h"
+#include <chrono>
+
+DepthWorker::DepthWorker(size_t capacity)
+	: queue_(capacity)
+{
+}
+
+DepthWorker::~DepthWorker()
+{
+	stop();
+}
+
+void DepthWorker::add_analyzer(DepthAnalyzer& analyzer)
+{
+	analyzers_.push_back(&analyzer);
+}
+
+void DepthWorker::start()
+{
+	if (running_.exchange(true))
+		return;
+	thread_ = std::thread(&DepthWorker::run, this);
+}
+
+void DepthWorker::stop()
+{
+	if (!running_.exchange(false))
+		return;
+	wake_.notify_one();
+	thread_.join();
+}
+
+void DepthWorker::consume(const DepthFrameRef& frame)
+{
+	DepthFrameRef* slot = queue_.begin_push();
+	if (!slot) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	*slot = frame;
+	queue_.end_push();
+	wake_.notify_one();
+}
+
+void DepthWorker::run()
+{
+	while (running_.load()) {
+		if (drain() == 0) {
+			// Same missed-wakeup bound as the frame writer
+			std::unique_lock<std::mutex> lock(wakeMutex_);
+			wake_.wait_for(lock, std::chrono::milliseconds(5));
+		}
+	}
+
+	drain();
+	for (DepthAnalyzer* analyzer : analyzers_)
+		analyzer->finish();
+}
+
+size_t DepthWorker::drain()
+{
+	size_t count = 0;
+	while (DepthFrameRef* frame = queue_.front()) {
+		for (DepthAnalyzer* analyzer : analyzers_)
+			analyzer->analyze(*frame);
+
+		// Return the buffer now rather than when the slot is next overwritten
+		frame->reset();
+		queue_.pop();
+		count++;
+	}
+
+	analyzed_.fetch_add(count, std::memory_order_relaxed);
+	return count;
+}
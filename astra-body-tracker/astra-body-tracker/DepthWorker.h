@@ -0,0 +1,72 @@
+#ifndef DEPTHWORKER_H
+#define DEPTHWORKER_H
+
+#include "DepthFramePool.h"
+#include "SpscRing.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Processes retained depth frames on a DepthWorker thread
+class DepthAnalyzer
+{
+public:
+	virtual ~DepthAnalyzer() { }
+
+	virtual void analyze(const DepthFrameRef& frame) = 0;
+
+	// After the last frame, on the worker thread
+	virtual void finish() { }
+};
+
+/*
+	Runs depth analysis off the SDK callback.
+
+	consume() queues a reference to the pooled frame, not the pixels, and the
+	worker thread hands each frame to every analyzer before releasing it back
+	to the pool. When the worker falls behind the queue fills up and frames are
+	dropped and counted, the same policy as AsyncFrameWriter.
+*/
+class DepthWorker : public DepthConsumer
+{
+public:
+	explicit DepthWorker(size_t capacity = 4);
+	~DepthWorker();
+
+	DepthWorker(const DepthWorker&) = delete;
+	DepthWorker& operator=(const DepthWorker&) = delete;
+
+	// Analyzers must be added before start() and outlive the worker thread
+	void add_analyzer(DepthAnalyzer& analyzer);
+	bool has_analyzers() const { return !analyzers_.empty(); }
+
+	void start();
+
+	// Analyzes whatever is still queued, finishes the analyzers and joins the thread
+	void stop();
+
+	void consume(const DepthFrameRef& frame) override;
+
+	uint64_t analyzed_frames() const { return analyzed_.load(std::memory_order_relaxed); }
+	uint64_t dropped_frames() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	void run();
+	size_t drain();
+
+	SpscRing<DepthFrameRef> queue_;
+	std::vector<DepthAnalyzer*> analyzers_;
+
+	std::thread thread_;
+	std::atomic<bool> running_{ false };
+	std::mutex wakeMutex_;
+	std::condition_variable wake_;
+
+	std::atomic<uint64_t> analyzed_{ 0 };
+	std::atomic<uint64_t> dropped_{ 0 };
+};
+
+#endif /* DEPTHWORKER_H */
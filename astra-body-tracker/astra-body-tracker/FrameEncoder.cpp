@@ -0,0 +1,403 @@
+#include "FrameEncoder.h"
+#include "JointSchema.h"
+#include "OrientationMetrics.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <math.h>
+
+// Upper bound on the JSON text of one body, checked by the encoder
+static const size_t JSON_BODY_MAX_SIZE = 4096;
+
+static void put_text(char*& p, const char* text, size_t length)
+{
+	memcpy(p, text, length);
+	p += length;
+}
+
+#define PUT_LITERAL(p, text) put_text(p, text, sizeof(text) - 1)
+
+static void put_uint(char*& p, uint64_t v)
+{
+	char digits[20];
+	int n = 0;
+	do {
+		digits[n++] = static_cast<char>('0' + v % 10);
+		v /= 10;
+	} while (v != 0);
+	while (n > 0)
+		*p++ = digits[--n];
+}
+
+// Fixed-point text with trailing zeros trimmed. Independent of the C locale and
+// far cheaper than ostream formatting; non-finite values become null.
+static void put_number(char*& p, double v, int decimals)
+{
+	static const uint64_t scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+	if (!isfinite(v)) {
+		PUT_LITERAL(p, "null");
+		return;
+	}
+	if (fabs(v) >= 1e12) {
+		p += snprintf(p, 32, "%g", v);
+		return;
+	}
+
+	uint64_t scale = scales[decimals];
+	uint64_t scaled = static_cast<uint64_t>(llround(fabs(v) * scale));
+	if (scaled == 0) {
+		*p++ = '0';
+		return;
+	}
+	if (v < 0)
+		*p++ = '-';
+
+	put_uint(p, scaled / scale);
+	uint64_t fraction = scaled % scale;
+	if (fraction == 0)
+		return;
+
+	*p++ = '.';
+	while (fraction % 10 == 0) {
+		fraction /= 10;
+		decimals--;
+	}
+	for (int i = decimals - 1; i >= 0; i--) {
+		p[i] = static_cast<char>('0' + fraction % 10);
+		fraction /= 10;
+	}
+	p += decimals;
+}
+
+// Positions are millimetres, so 0.01 mm is already far below the sensor noise
+static const int POSITION_DECIMALS = 2;
+static const int ANGLE_DECIMALS = 4;
+
+void encode_json(const FrameRecord& record, std::vector<char>& out)
+{
+	for (uint32_t i = 0; i < record.bodyCount; i++) {
+		const BodyRecord& body = record.bodies[i];
+		if (!body.jointsEnabled)
+			continue;
+
+		size_t offset = out.size();
+		out.resize(offset + JSON_BODY_MAX_SIZE);
+		char* start = &out[offset];
+		char* p = start;
+
+		PUT_LITERAL(p, "{\"frame_number\": ");
+		put_uint(p, record.frameNumber);
+		PUT_LITERAL(p, ",\"time\": ");
+		put_uint(p, record.elapsedMs);
+		PUT_LITERAL(p, ",\"body_id\": ");
+		put_uint(p, body.id);
+		PUT_LITERAL(p, ",\"joints\": {");
+
+		bool first_joint = true;
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			if (!joint_valid(body, n))
+				continue;
+			if (first_joint)
+				first_joint = false;
+			else
+				*p++ = ',';
+
+			const JointInfo& info = JOINT_SCHEMA[n];
+			put_text(p, info.jsonKey, info.jsonKeyLength);
+			put_number(p, body.joints[n][0], POSITION_DECIMALS);
+			PUT_LITERAL(p, ",\"y\": ");
+			put_number(p, body.joints[n][1], POSITION_DECIMALS);
+			PUT_LITERAL(p, ",\"z\": ");
+			put_number(p, body.joints[n][2], POSITION_DECIMALS);
+			*p++ = '}';
+		}
+		*p++ = '}';
+
+		if (!isnan(body.shoulderAngle)) {
+			PUT_LITERAL(p, ",\"shoulder_angle\": ");
+			put_number(p, body.shoulderAngle, ANGLE_DECIMALS);
+		}
+		if (!isnan(body.hipAngle)) {
+			PUT_LITERAL(p, ",\"hip_angle\": ");
+			put_number(p, body.hipAngle, ANGLE_DECIMALS);
+		}
+		if (!isnan(body.trunkRotation)) {
+			PUT_LITERAL(p, ",\"trunk_rotation\": ");
+			put_number(p, body.trunkRotation, ANGLE_DECIMALS);
+		}
+
+		bool any_segment = false;
+		for (const SegmentAngles& segment : body.spine)
+			any_segment = any_segment || !isnan(segment.flexion);
+		if (any_segment) {
+			PUT_LITERAL(p, ",\"spine\": [");
+			for (int s = 0; s < SPINE_SEGMENT_COUNT; s++) {
+				if (s > 0)
+					*p++ = ',';
+				PUT_LITERAL(p, "{\"flexion\": ");
+				put_number(p, body.spine[s].flexion, ANGLE_DECIMALS);
+				PUT_LITERAL(p, ",\"lateral\": ");
+				put_number(p, body.spine[s].lateral, ANGLE_DECIMALS);
+				PUT_LITERAL(p, ",\"axial\": ");
+				put_number(p, body.spine[s].axial, ANGLE_DECIMALS);
+				*p++ = '}';
+			}
+			*p++ = ']';
+		}
+		PUT_LITERAL(p, "}\n");
+
+		assert(static_cast<size_t>(p - start) <= JSON_BODY_MAX_SIZE);
+		out.resize(offset + (p - start));
+	}
+}
+
+// Upper bound on the JSON text of one summary
+static const size_t JSON_SUMMARY_MAX_SIZE = 1024;
+
+static void put_stats_json(char*& p, const RunningStats& stats)
+{
+	PUT_LITERAL(p, "{\"mean\": ");
+	put_number(p, stats.count ? stats.mean : NAN, ANGLE_DECIMALS);
+	PUT_LITERAL(p, ",\"stddev\": ");
+	put_number(p, stats.stddev(), ANGLE_DECIMALS);
+	PUT_LITERAL(p, ",\"min\": ");
+	put_number(p, stats.min, ANGLE_DECIMALS);
+	PUT_LITERAL(p, ",\"max\": ");
+	put_number(p, stats.max, ANGLE_DECIMALS);
+	*p++ = '}';
+}
+
+void encode_summary_json(const BodySummary& summary, std::vector<char>& out)
+{
+	size_t offset = out.size();
+	out.resize(offset + JSON_SUMMARY_MAX_SIZE);
+	char* start = &out[offset];
+	char* p = start;
+
+	if (summary.final)
+		PUT_LITERAL(p, "{\"summary\": \"final\"");
+	else
+		PUT_LITERAL(p, "{\"summary\": \"periodic\"");
+	PUT_LITERAL(p, ",\"frame_number\": ");
+	put_uint(p, summary.frameNumber);
+	PUT_LITERAL(p, ",\"body_id\": ");
+	put_uint(p, summary.bodyId);
+	PUT_LITERAL(p, ",\"count\": ");
+	put_uint(p, summary.shoulderAngle.count);
+	PUT_LITERAL(p, ",\"shoulder_angle\": ");
+	put_stats_json(p, summary.shoulderAngle);
+	PUT_LITERAL(p, ",\"abs_shoulder_angle\": ");
+	put_stats_json(p, summary.absShoulderAngle);
+	PUT_LITERAL(p, ",\"tracked_frames\": ");
+	put_uint(p, summary.trackedFrames);
+	PUT_LITERAL(p, ",\"recent_shoulder_angle\": ");
+	put_number(p, summary.recentShoulderAngle, ANGLE_DECIMALS);
+	PUT_LITERAL(p, ",\"recent_hip_angle\": ");
+	put_number(p, summary.recentHipAngle, ANGLE_DECIMALS);
+	PUT_LITERAL(p, ",\"spine_path_mm\": ");
+	put_number(p, summary.spinePathMm, POSITION_DECIMALS);
+	PUT_LITERAL(p, "}\n");
+
+	assert(static_cast<size_t>(p - start) <= JSON_SUMMARY_MAX_SIZE);
+	out.resize(offset + (p - start));
+}
+
+static void put_u8(char*& p, uint8_t v)
+{
+	*p++ = static_cast<char>(v);
+}
+
+static void put_u16(char*& p, uint16_t v)
+{
+	put_u8(p, static_cast<uint8_t>(v));
+	put_u8(p, static_cast<uint8_t>(v >> 8));
+}
+
+static void put_u32(char*& p, uint32_t v)
+{
+	put_u16(p, static_cast<uint16_t>(v));
+	put_u16(p, static_cast<uint16_t>(v >> 16));
+}
+
+static void put_u64(char*& p, uint64_t v)
+{
+	put_u32(p, static_cast<uint32_t>(v));
+	put_u32(p, static_cast<uint32_t>(v >> 32));
+}
+
+static void put_f32(char*& p, float v)
+{
+	uint32_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	put_u32(p, bits);
+}
+
+void encode_binary(const FrameRecord& record, std::vector<char>& out)
+{
+	for (uint32_t i = 0; i < record.bodyCount; i++) {
+		const BodyRecord& body = record.bodies[i];
+		if (!body.jointsEnabled)
+			continue;
+
+		size_t offset = out.size();
+		out.resize(offset + BINARY_RECORD_SIZE);
+		char* p = &out[offset];
+
+		put_u16(p, BINARY_RECORD_SIZE);
+		put_u16(p, BINARY_RECORD_VERSION);
+		put_u32(p, record.frameNumber);
+		put_u32(p, record.elapsedMs);
+		put_u64(p, record.timestampUs);
+		put_u8(p, body.id);
+		put_u8(p, body.status);
+		put_u16(p, 0);
+		put_u32(p, body.jointMask);
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			put_f32(p, body.joints[n][0]);
+			put_f32(p, body.joints[n][1]);
+			put_f32(p, body.joints[n][2]);
+		}
+		put_f32(p, body.shoulderAngle);
+		put_f32(p, body.hipAngle);
+		for (const Quaternion& q : body.orientations) {
+			put_f32(p, q.w);
+			put_f32(p, q.x);
+			put_f32(p, q.y);
+			put_f32(p, q.z);
+		}
+		put_f32(p, body.trunkRotation);
+		for (const SegmentAngles& segment : body.spine) {
+			put_f32(p, segment.flexion);
+			put_f32(p, segment.lateral);
+			put_f32(p, segment.axial);
+		}
+	}
+}
+
+static void put_f64(char*& p, double v)
+{
+	uint64_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	put_u64(p, bits);
+}
+
+static void put_stats_binary(char*& p, const RunningStats& stats)
+{
+	put_f64(p, stats.count ? stats.mean : NAN);
+	put_f64(p, stats.stddev());
+	put_f64(p, stats.min);
+	put_f64(p, stats.max);
+}
+
+void encode_summary_binary(const BodySummary& summary, std::vector<char>& out)
+{
+	size_t offset = out.size();
+	out.resize(offset + BINARY_SUMMARY_SIZE);
+	char* p = &out[offset];
+
+	put_u16(p, BINARY_SUMMARY_SIZE);
+	put_u16(p, BINARY_SUMMARY_VERSION);
+	put_u32(p, summary.frameNumber);
+	put_u8(p, summary.bodyId);
+	put_u8(p, summary.final ? 1 : 0);
+	put_u16(p, 0);
+	put_u32(p, static_cast<uint32_t>(summary.shoulderAngle.count));
+	put_stats_binary(p, summary.shoulderAngle);
+	put_stats_binary(p, summary.absShoulderAngle);
+	put_u32(p, summary.trackedFrames);
+	put_f32(p, summary.recentShoulderAngle);
+	put_f32(p, summary.recentHipAngle);
+	put_f32(p, summary.spinePathMm);
+}
+
+static uint8_t get_u8(const char*& p)
+{
+	return static_cast<uint8_t>(*p++);
+}
+
+static uint16_t get_u16(const char*& p)
+{
+	uint16_t v = get_u8(p);
+	return static_cast<uint16_t>(v | (get_u8(p) << 8));
+}
+
+static uint32_t get_u32(const char*& p)
+{
+	uint32_t v = get_u16(p);
+	return v | (static_cast<uint32_t>(get_u16(p)) << 16);
+}
+
+static uint64_t get_u64(const char*& p)
+{
+	uint64_t v = get_u32(p);
+	return v | (static_cast<uint64_t>(get_u32(p)) << 32);
+}
+
+static float get_f32(const char*& p)
+{
+	uint32_t bits = get_u32(p);
+	float v;
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+bool decode_binary(const char* data, size_t length, FrameRecord& record)
+{
+	// Every record of a frame has the same version; older recordings hold version 1
+	const char* p = data;
+	uint16_t size = length >= 2 ? get_u16(p) : BINARY_RECORD_SIZE;
+	uint16_t version;
+	if (size == BINARY_RECORD_SIZE)
+		version = BINARY_RECORD_VERSION;
+	else if (size == BINARY_RECORD_V1_SIZE)
+		version = 1;
+	else
+		return false;
+
+	if (length % size != 0 || length / size > ASTRA_MAX_BODIES)
+		return false;
+
+	record.bodyCount = 0;
+	p = data;
+	const char* end = data + length;
+	while (p < end) {
+		if (get_u16(p) != size || get_u16(p) != version)
+			return false;
+
+		BodyRecord& body = record.bodies[record.bodyCount++];
+		record.frameNumber = get_u32(p);
+		record.elapsedMs = get_u32(p);
+		record.timestampUs = get_u64(p);
+		body.id = get_u8(p);
+		body.status = get_u8(p);
+		get_u16(p);
+		body.jointsEnabled = true;
+		body.jointMask = get_u32(p);
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			body.joints[n][0] = get_f32(p);
+			body.joints[n][1] = get_f32(p);
+			body.joints[n][2] = get_f32(p);
+		}
+		body.shoulderAngle = get_f32(p);
+		body.hipAngle = get_f32(p);
+
+		if (version == 1) {
+			clear_orientations(body);
+			continue;
+		}
+		for (Quaternion& q : body.orientations) {
+			q.w = get_f32(p);
+			q.x = get_f32(p);
+			q.y = get_f32(p);
+			q.z = get_f32(p);
+		}
+		body.trunkRotation = get_f32(p);
+		for (SegmentAngles& segment : body.spine) {
+			segment.flexion = get_f32(p);
+			segment.lateral = get_f32(p);
+			segment.axial = get_f32(p);
+		}
+	}
+	return true;
+}
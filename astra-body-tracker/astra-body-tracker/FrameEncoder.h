@@ -0,0 +1,82 @@
+#ifndef FRAMEENCODER_H
+#define FRAMEENCODER_H
+
+#include "FrameRecord.h"
+#include <vector>
+
+enum class OutputFormat
+{
+	Json,
+	Binary,
+
+	// Packets of DeltaCodec.h framed as sf::Packet; summaries are not written
+	Delta
+};
+
+/*
+	Binary body record, little-endian and packed, one per body with joints enabled:
+
+	offset  type        field
+	0       uint16      record size in bytes (BINARY_RECORD_SIZE)
+	2       uint16      record version (BINARY_RECORD_VERSION)
+	4       uint32      frame number
+	8       uint32      milliseconds since the previous frame
+	12      uint64      microseconds since the tracker started
+	20      uint8       body id
+	21      uint8       body status (astra::BodyStatus)
+	22      uint16      reserved, zero
+	24      uint32      joint validity mask, bit n for astra::JointType n
+	28      float32     x, y, z for each of the ASTRA_MAX_JOINTS joints
+	256     float32     shoulder angle in degrees, NaN when unavailable
+	260     float32     hip angle in degrees, NaN when unavailable
+	264     float32     w, x, y, z orientation for each joint, NaN when unavailable
+	568     float32     trunk rotation in degrees, NaN when unavailable
+	572     float32     flexion, lateral and axial degrees for each spine segment
+
+	Version 1 records end after the hip angle; decode_binary still reads them.
+*/
+const uint16_t BINARY_RECORD_VERSION = 2;
+const uint16_t BINARY_RECORD_V1_SIZE = 28 + ASTRA_MAX_JOINTS * 3 * 4 + 2 * 4;
+const uint16_t BINARY_RECORD_SIZE = BINARY_RECORD_V1_SIZE + ASTRA_MAX_JOINTS * 4 * 4 + 4 + SPINE_SEGMENT_COUNT * 3 * 4;
+
+/*
+	Binary summary record, told apart from body records by its size field:
+
+	offset  type        field
+	0       uint16      record size in bytes (BINARY_SUMMARY_SIZE)
+	2       uint16      record version (BINARY_SUMMARY_VERSION)
+	4       uint32      frame number
+	8       uint8       body id
+	9       uint8       1 for the final summary of the session, else 0
+	10      uint16      reserved, zero
+	12      uint32      number of frames with a shoulder angle
+	16      float64     mean, stddev, min, max of the shoulder angle in degrees
+	48      float64     mean, stddev, min, max of its absolute value
+	80      uint32      frames tracked since the body was acquired, 0 when lost
+	84      float32     recent mean shoulder angle in degrees, NaN when unavailable
+	88      float32     recent mean hip angle in degrees, NaN when unavailable
+	92      float32     distance the spine base moved while tracked in mm, NaN
+	                    when unavailable
+
+	Version 1 records end after the absolute value statistics.
+*/
+const uint16_t BINARY_SUMMARY_VERSION = 2;
+const uint16_t BINARY_SUMMARY_V1_SIZE = 16 + 2 * 4 * 8;
+const uint16_t BINARY_SUMMARY_SIZE = BINARY_SUMMARY_V1_SIZE + 4 * 4;
+
+// Appends one JSON object per body to out, each terminated by a newline
+void encode_json(const FrameRecord& record, std::vector<char>& out);
+
+// Appends one binary record per body to out
+void encode_binary(const FrameRecord& record, std::vector<char>& out);
+
+// Appends one summary line or record to out. JSON summaries carry a "summary"
+// member ("periodic" or "final") that frame lines never have.
+void encode_summary_json(const BodySummary& summary, std::vector<char>& out);
+void encode_summary_binary(const BodySummary& summary, std::vector<char>& out);
+
+// Rebuilds a frame from the records encode_binary wrote for it. Frame fields are
+// left untouched when there are no records. Returns false on malformed data.
+bool decode_binary(const char* data, size_t length, FrameRecord& record);
+
+#endif /* FRAMEENCODER_H */
@@ -0,0 +1,78 @@
+#define PI 3.14159265
+#define ASTRA_X 0
+#define ASTRA_Y 3349.3
+#define ASTRA_Z 0
+
+#include "FrameRecord.h"
+#include "JointFilter.h"
+#include "JointSchema.h"
+#include "OrientationMetrics.h"
+#include <cstring>
+#include <math.h>
+
+// Tilt of the line between two joints against the horizontal, in degrees
+static float tilt_angle(const BodyRecord& body, astra::JointType leftJoint, astra::JointType rightJoint)
+{
+	int left = joint_index(leftJoint);
+	int right = joint_index(rightJoint);
+
+	if (!joint_valid(body, left) || !joint_valid(body, right))
+		return NAN;
+
+	double x_L = body.joints[left][0], y_L = body.joints[left][1], z_L = body.joints[left][2];
+	double x_R = body.joints[right][0], y_R = body.joints[right][1], z_R = body.joints[right][2];
+
+	double deg = asin((y_R - y_L) / (sqrt(pow((x_R - x_L), 2) + pow((y_R - y_L), 2) + pow((z_R - z_L), 2)))) * 180 / PI;
+	return static_cast<float>(deg);
+}
+
+void extract_frame_record(const astra::Body* bodies, size_t count, FrameRecord& record,
+	JointFilterBank* filter)
+{
+	if (count > ASTRA_MAX_BODIES)
+		count = ASTRA_MAX_BODIES;
+
+	record.bodyCount = static_cast<uint32_t>(count);
+	for (size_t i = 0; i < count; i++) {
+		const astra::Body& body = bodies[i];
+		BodyRecord& out = record.bodies[i];
+
+		out.id = body.id();
+		out.status = static_cast<uint8_t>(body.status());
+		out.jointsEnabled = body.joints_enabled();
+		out.jointMask = 0;
+		memset(out.joints, 0, sizeof(out.joints));
+		for (Quaternion& q : out.orientations)
+			q = MISSING_ROTATION;
+
+		for (auto& joint : body.joints()) {
+			int n = static_cast<int>(joint.type());
+			if (n >= ASTRA_MAX_JOINTS)
+				continue;
+
+			const auto& p = joint.world_position();
+			out.joints[n][0] = p.x;
+			out.joints[n][1] = p.y;
+			out.joints[n][2] = p.z;
+
+			// Joints the SDK has not placed sit at a fixed position in front of the
+			// sensor; the float to double comparison rarely matches it exactly, so
+			// the joint status decides first
+			if (joint.status() != astra::JointStatus::NotTracked &&
+				!(p.x == ASTRA_X && p.y == ASTRA_Y && p.z == ASTRA_Z)) {
+				out.jointMask |= 1u << n;
+				out.orientations[n] = quaternion_from_matrix(joint.orientation());
+			}
+		}
+	}
+
+	if (filter)
+		filter->apply(record);
+
+	for (size_t i = 0; i < count; i++) {
+		BodyRecord& out = record.bodies[i];
+		out.shoulderAngle = tilt_angle(out, astra::JointType::LeftShoulder, astra::JointType::RightShoulder);
+		out.hipAngle = tilt_angle(out, astra::JointType::LeftHip, astra::JointType::RightHip);
+		compute_orientation_metrics(out);
+	}
+}
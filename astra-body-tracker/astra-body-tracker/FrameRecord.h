@@ -0,0 +1,106 @@
+#ifndef FRAMERECORD_H
+#define FRAMERECORD_H
+
+#include "PipelineMetrics.h"
+#include "Quaternion.h"
+#include "RunningStats.h"
+#include <astra/astra.hpp>
+#include <cstdint>
+
+// Spine segments, each the rotation of a joint relative to the one below it:
+// BaseSpine to MidSpine, MidSpine to ShoulderSpine, ShoulderSpine to Neck
+const int SPINE_SEGMENT_COUNT = 3;
+
+// Degrees in the frame of the lower joint, NAN when either rotation is missing
+struct SegmentAngles
+{
+	// Forward bend, about the lower joint's x axis
+	float flexion;
+
+	// Side bend, about its z axis
+	float lateral;
+
+	// Twist about the segment itself
+	float axial;
+};
+
+// Plain copy of everything the output path needs from one tracked body.
+// Joint positions are indexed by astra::JointType, so joints[ASTRA_JOINT_HEAD]
+// is always the head whether or not it was tracked this frame.
+struct BodyRecord
+{
+	uint8_t id;
+	uint8_t status;
+	bool jointsEnabled;
+
+	// Bit n is set when joint n has a usable world position
+	uint32_t jointMask;
+	float joints[ASTRA_MAX_JOINTS][3];
+
+	// Degrees, NAN when one of the two joints is missing
+	float shoulderAngle;
+	float hipAngle;
+
+	// Joint rotations, indexed like joints; MISSING_ROTATION where the joint
+	// is not in jointMask or the SDK gave no usable orientation
+	Quaternion orientations[ASTRA_MAX_JOINTS];
+
+	// Degrees the shoulders are turned against the pelvis about the spine
+	// (ShoulderSpine relative to BaseSpine), NAN when either is missing
+	float trunkRotation;
+	SegmentAngles spine[SPINE_SEGMENT_COUNT];
+};
+
+struct FrameRecord
+{
+	uint32_t frameNumber;
+
+	// Milliseconds since the previous frame (the "time" field of the JSON output)
+	uint32_t elapsedMs;
+
+	// Microseconds since the tracker started
+	uint64_t timestampUs;
+
+	uint32_t bodyCount;
+	BodyRecord bodies[ASTRA_MAX_BODIES];
+
+	// Stage timestamps for --metrics, filled in by the producer
+	FrameTiming timing;
+};
+
+// Shoulder angle statistics of one body from the start of the session up to frameNumber
+struct BodySummary
+{
+	uint32_t frameNumber;
+	uint8_t bodyId;
+
+	// Set on the summary written when the session ends
+	bool final;
+
+	// Degrees, over the frames where the angle was available
+	RunningStats shoulderAngle;
+	RunningStats absShoulderAngle;
+
+	// From the body state table while the body is tracked: frames seen since
+	// it was acquired (0 when it is not tracked), means of the angles over its
+	// recent history in degrees and the distance its spine base moved in mm.
+	// NAN when unavailable.
+	uint32_t trackedFrames;
+	float recentShoulderAngle;
+	float recentHipAngle;
+	float spinePathMm;
+};
+
+inline bool joint_valid(const BodyRecord& body, int joint)
+{
+	return (body.jointMask & (1u << joint)) != 0;
+}
+
+class JointFilterBank;
+
+// Copies the bodies into record and derives the angles, smoothing the joint
+// positions with filter first when one is given. record.timestampUs must be set.
+void extract_frame_record(const astra::Body* bodies, size_t count, FrameRecord& record,
+	JointFilterBank* filter = nullptr);
+
+#endif /* FRAMERECORD_H */
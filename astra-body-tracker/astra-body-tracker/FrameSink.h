@@ -0,0 +1,22 @@
+#ifndef FRAMESINK_H
+#define FRAMESINK_H
+
+#include "FrameRecord.h"
+
+// Destination for frames drained by AsyncFrameWriter. Both calls are made on
+// the writer thread only.
+class FrameSink
+{
+public:
+	virtual ~FrameSink() { }
+
+	virtual void consume(const FrameRecord& record) = 0;
+
+	// Sinks that do not write summaries ignore them
+	virtual void consume_summary(const BodySummary& summary) { }
+
+	// End of a batch of frames
+	virtual void flush() { }
+};
+
+#endif /* FRAMESINK_H */
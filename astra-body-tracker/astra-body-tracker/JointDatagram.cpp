@@ -0,0 +1,143 @@
+#include "JointDatagram.h"
+#include <cstring>
+#include <math.h>
+
+static void put_u8(char*& p, uint8_t v)
+{
+	*p++ = static_cast<char>(v);
+}
+
+static void put_u16(char*& p, uint16_t v)
+{
+	put_u8(p, static_cast<uint8_t>(v));
+	put_u8(p, static_cast<uint8_t>(v >> 8));
+}
+
+static void put_u32(char*& p, uint32_t v)
+{
+	put_u16(p, static_cast<uint16_t>(v));
+	put_u16(p, static_cast<uint16_t>(v >> 16));
+}
+
+static void put_u64(char*& p, uint64_t v)
+{
+	put_u32(p, static_cast<uint32_t>(v));
+	put_u32(p, static_cast<uint32_t>(v >> 32));
+}
+
+// Rounded and clamped so far-off values cannot wrap around
+static void put_i16(char*& p, float v)
+{
+	float clamped = v < -32767.0f ? -32767.0f : (v > 32767.0f ? 32767.0f : v);
+	put_u16(p, static_cast<uint16_t>(static_cast<int16_t>(lrintf(clamped))));
+}
+
+static void put_angle(char*& p, float degrees)
+{
+	if (isnan(degrees))
+		put_u16(p, static_cast<uint16_t>(JOINT_DATAGRAM_NO_ANGLE));
+	else
+		put_i16(p, degrees * 100.0f);
+}
+
+size_t encode_joint_datagram(const JointFrame& frame, char* out)
+{
+	uint32_t bodyCount = frame.bodyCount < ASTRA_MAX_BODIES ? frame.bodyCount : ASTRA_MAX_BODIES;
+
+	char* p = out;
+	memcpy(p, JOINT_DATAGRAM_MAGIC, sizeof(JOINT_DATAGRAM_MAGIC));
+	p += sizeof(JOINT_DATAGRAM_MAGIC);
+	put_u16(p, JOINT_DATAGRAM_VERSION);
+	put_u8(p, static_cast<uint8_t>(bodyCount));
+	put_u8(p, 0);
+	put_u32(p, frame.session);
+	put_u32(p, frame.sequence);
+	put_u64(p, frame.timestampUs);
+	put_u32(p, frame.frameNumber);
+	put_u32(p, frame.sensorFrameIndex);
+
+	for (uint32_t i = 0; i < bodyCount; i++) {
+		const JointFrameBody& body = frame.bodies[i];
+		put_u8(p, body.id);
+		put_u8(p, body.status);
+		put_u16(p, 0);
+		put_u32(p, body.jointMask);
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			bool valid = (body.jointMask & (1u << n)) != 0;
+			for (int axis = 0; axis < 3; axis++)
+				put_i16(p, valid ? body.joints[n][axis] : 0.0f);
+		}
+		put_angle(p, body.shoulderAngle);
+		put_angle(p, body.hipAngle);
+		put_u16(p, 0);
+	}
+
+	return static_cast<size_t>(p - out);
+}
+
+static uint8_t get_u8(const char*& p)
+{
+	return static_cast<uint8_t>(*p++);
+}
+
+static uint16_t get_u16(const char*& p)
+{
+	uint16_t v = get_u8(p);
+	return static_cast<uint16_t>(v | (get_u8(p) << 8));
+}
+
+static uint32_t get_u32(const char*& p)
+{
+	uint32_t v = get_u16(p);
+	return v | (static_cast<uint32_t>(get_u16(p)) << 16);
+}
+
+static uint64_t get_u64(const char*& p)
+{
+	uint64_t v = get_u32(p);
+	return v | (static_cast<uint64_t>(get_u32(p)) << 32);
+}
+
+static float get_angle(const char*& p)
+{
+	int16_t v = static_cast<int16_t>(get_u16(p));
+	return v == JOINT_DATAGRAM_NO_ANGLE ? NAN : v / 100.0f;
+}
+
+bool decode_joint_datagram(const char* data, size_t length, JointFrame& frame)
+{
+	if (length < JOINT_DATAGRAM_HEADER_SIZE || memcmp(data, JOINT_DATAGRAM_MAGIC, sizeof(JOINT_DATAGRAM_MAGIC)) != 0)
+		return false;
+
+	const char* p = data + sizeof(JOINT_DATAGRAM_MAGIC);
+	if (get_u16(p) != JOINT_DATAGRAM_VERSION)
+		return false;
+
+	uint32_t bodyCount = get_u8(p);
+	if (bodyCount > ASTRA_MAX_BODIES || length != JOINT_DATAGRAM_HEADER_SIZE + bodyCount * JOINT_DATAGRAM_BODY_SIZE)
+		return false;
+
+	get_u8(p);
+	frame.session = get_u32(p);
+	frame.sequence = get_u32(p);
+	frame.timestampUs = get_u64(p);
+	frame.frameNumber = get_u32(p);
+	frame.sensorFrameIndex = get_u32(p);
+	frame.bodyCount = bodyCount;
+
+	for (uint32_t i = 0; i < bodyCount; i++) {
+		JointFrameBody& body = frame.bodies[i];
+		body.id = get_u8(p);
+		body.status = get_u8(p);
+		get_u16(p);
+		body.jointMask = get_u32(p);
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			for (int axis = 0; axis < 3; axis++)
+				body.joints[n][axis] = static_cast<int16_t>(get_u16(p));
+		}
+		body.shoulderAngle = get_angle(p);
+		body.hipAngle = get_angle(p);
+		get_u16(p);
+	}
+	return true;
+}
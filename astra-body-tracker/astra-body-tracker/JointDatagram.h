@@ -0,0 +1,85 @@
+#ifndef JOINTDATAGRAM_H
+#define JOINTDATAGRAM_H
+
+#include <astra/capi/streams/body_types.h>
+#include <cstddef>
+#include <cstdint>
+
+/*
+	One UDP datagram per frame for live displays, little-endian and packed.
+	Everything a receiver needs is in the datagram, so a lost one costs a
+	frame and never corrupts the next.
+
+	offset  type        field
+	0       char[4]     "AJDG"
+	4       uint16      version (JOINT_DATAGRAM_VERSION)
+	6       uint8       body count, at most ASTRA_MAX_BODIES
+	7       uint8       reserved, zero
+	8       uint32      publisher session, random per run
+	12      uint32      sequence number, one more than the previous datagram
+	16      uint64      microseconds since the tracker started
+	24      uint32      frame number
+	28      uint32      sensor frame index, 0 for replayed frames
+	32      body[]      JOINT_DATAGRAM_BODY_SIZE bytes each:
+	  0     uint8       body id
+	  1     uint8       body status (astra::BodyStatus)
+	  2     uint16      reserved, zero
+	  4     uint32      joint validity mask, bit n for astra::JointType n
+	  8     int16       x, y, z in mm for each of the ASTRA_MAX_JOINTS joints,
+	                    zero for joints not in the mask
+	  122   int16       shoulder angle in hundredths of a degree
+	  124   int16       hip angle in hundredths of a degree
+	  126   uint16      reserved, zero
+
+	Angles are JOINT_DATAGRAM_NO_ANGLE when unavailable. Sequence numbers
+	compare with wraparound and only within one session, so a restarted
+	tracker is followed at once.
+*/
+const char JOINT_DATAGRAM_MAGIC[4] = { 'A', 'J', 'D', 'G' };
+const uint16_t JOINT_DATAGRAM_VERSION = 1;
+const size_t JOINT_DATAGRAM_HEADER_SIZE = 32;
+const size_t JOINT_DATAGRAM_BODY_SIZE = 8 + ASTRA_MAX_JOINTS * 3 * 2 + 3 * 2;
+const size_t JOINT_DATAGRAM_MAX_SIZE = JOINT_DATAGRAM_HEADER_SIZE + ASTRA_MAX_BODIES * JOINT_DATAGRAM_BODY_SIZE;
+const int16_t JOINT_DATAGRAM_NO_ANGLE = INT16_MIN;
+
+struct JointFrameBody
+{
+	uint8_t id;
+	uint8_t status;
+	uint32_t jointMask;
+
+	// mm, rounded to whole millimetres on the wire
+	float joints[ASTRA_MAX_JOINTS][3];
+
+	// Degrees, NAN when unavailable
+	float shoulderAngle;
+	float hipAngle;
+};
+
+// The skeletons of one frame as carried by one datagram
+struct JointFrame
+{
+	uint32_t session;
+	uint32_t sequence;
+	uint64_t timestampUs;
+	uint32_t frameNumber;
+	uint32_t sensorFrameIndex;
+
+	uint32_t bodyCount;
+	JointFrameBody bodies[ASTRA_MAX_BODIES];
+};
+
+// Writes the datagram for frame to out, which must hold JOINT_DATAGRAM_MAX_SIZE
+// bytes, and returns its size
+size_t encode_joint_datagram(const JointFrame& frame, char* out);
+
+// Returns false for datagrams that are not version 1 joint datagrams
+bool decode_joint_datagram(const char* data, size_t length, JointFrame& frame);
+
+// True when sequence b comes after a in the same session
+inline bool sequence_after(uint32_t b, uint32_t a)
+{
+	return static_cast<int32_t>(b - a) > 0;
+}
+
+#endif /* JOINTDATAGRAM_H */
@@ -0,0 +1,187 @@
+#include "JointFilter.h"
+#include <math.h>
+
+static const float TWO_PI = 6.28318531f;
+
+// Frames this far apart are treated as a restart rather than smoothed across
+static const float MAX_FRAME_GAP_SECONDS = 0.5f;
+
+// Velocity variance a Kalman joint starts with, (1 m/s)^2 in mm^2/s^2
+static const float INITIAL_VELOCITY_VARIANCE = 1.0e6f;
+
+// A joint held perfectly still makes the differences decay geometrically into
+// denormals, which are many times slower to compute with. Anything under a
+// micrometre (or micrometre per second) is noise, so it is rounded to zero.
+static float settle(float v)
+{
+	return fabsf(v) < 1e-3f ? 0.0f : v;
+}
+
+JointFilterBank::JointFilterBank(const FilterSettings& settings)
+	: settings_(settings)
+{
+	for (int s = 0; s < ASTRA_MAX_BODIES; s++) {
+		slotIds_[s] = 0;
+		slotSeen_[s] = false;
+		slotTimestampUs_[s] = 0;
+		slotJointMask_[s] = 0;
+	}
+}
+
+int JointFilterBank::slot_for(uint8_t id)
+{
+	int free = -1;
+	for (int s = 0; s < ASTRA_MAX_BODIES; s++) {
+		if (slotIds_[s] == id)
+			return s;
+		if (free < 0 && slotIds_[s] == 0)
+			free = s;
+	}
+
+	// The SDK never reports more than ASTRA_MAX_BODIES bodies, so a slot was
+	// released for every body that left
+	if (free >= 0) {
+		slotIds_[free] = id;
+		slotJointMask_[free] = 0;
+	}
+	return free;
+}
+
+void JointFilterBank::apply(FrameRecord& record)
+{
+	if (settings_.type == FilterType::None)
+		return;
+
+	for (int s = 0; s < ASTRA_MAX_BODIES; s++)
+		slotSeen_[s] = false;
+
+	for (uint32_t i = 0; i < record.bodyCount; i++) {
+		BodyRecord& body = record.bodies[i];
+		auto status = static_cast<astra::BodyStatus>(body.status);
+		if (body.id == 0 || status == astra::BodyStatus::TrackingLost || status == astra::BodyStatus::NotTracking)
+			continue;
+
+		int slot = slot_for(body.id);
+		if (slot < 0)
+			continue;
+		slotSeen_[slot] = true;
+
+		float dt = static_cast<float>(record.timestampUs - slotTimestampUs_[slot]) * 1e-6f;
+		if (dt <= 0 || dt > MAX_FRAME_GAP_SECONDS)
+			slotJointMask_[slot] = 0;
+		slotTimestampUs_[slot] = record.timestampUs;
+
+		if (settings_.type == FilterType::OneEuro)
+			filter_one_euro(slot, body, dt);
+		else
+			filter_kalman(slot, body, dt);
+	}
+
+	// Bodies that are lost or missing start over if they come back
+	for (int s = 0; s < ASTRA_MAX_BODIES; s++) {
+		if (!slotSeen_[s])
+			slotIds_[s] = 0;
+	}
+}
+
+// Smoothing factor of a first-order low-pass filter at cutoff Hz over dt seconds
+static float smoothing(float cutoff, float dt)
+{
+	float tau = 1.0f / (TWO_PI * cutoff);
+	return 1.0f / (1.0f + tau / dt);
+}
+
+void JointFilterBank::filter_one_euro(int slot, BodyRecord& body, float dt)
+{
+	uint32_t previous = slotJointMask_[slot];
+	float derivativeAlpha = previous ? smoothing(settings_.derivativeCutoff, dt) : 0;
+
+	for (int j = 0; j < ASTRA_MAX_JOINTS; j++) {
+		if (!joint_valid(body, j))
+			continue;
+
+		float* joint = body.joints[j];
+		float* position = position_[slot][j];
+		float* velocity = velocity_[slot][j];
+
+		if (!(previous & (1u << j))) {
+			for (int a = 0; a < 3; a++) {
+				position[a] = joint[a];
+				velocity[a] = 0;
+			}
+			continue;
+		}
+
+		// One cutoff for all three axes from the joint's speed, so smoothing
+		// does not bend the direction a joint moves in
+		float speed2 = 0;
+		for (int a = 0; a < 3; a++) {
+			float raw = settle(joint[a] - position[a]) / dt;
+			velocity[a] = settle(velocity[a] + derivativeAlpha * (raw - velocity[a]));
+			speed2 += velocity[a] * velocity[a];
+		}
+		float alpha = smoothing(settings_.minCutoff + settings_.beta * sqrtf(speed2), dt);
+
+		for (int a = 0; a < 3; a++) {
+			position[a] += alpha * settle(joint[a] - position[a]);
+			joint[a] = position[a];
+		}
+	}
+
+	slotJointMask_[slot] = body.jointMask;
+}
+
+void JointFilterBank::filter_kalman(int slot, BodyRecord& body, float dt)
+{
+	uint32_t previous = slotJointMask_[slot];
+	float r = settings_.measurementNoise * settings_.measurementNoise;
+	float q = settings_.accelerationNoise * settings_.accelerationNoise;
+
+	// Process noise of a constant-velocity model driven by white acceleration
+	float dt2 = dt * dt;
+	float q00 = q * dt2 * dt2 * 0.25f;
+	float q01 = q * dt2 * dt * 0.5f;
+	float q11 = q * dt2;
+
+	for (int j = 0; j < ASTRA_MAX_JOINTS; j++) {
+		if (!joint_valid(body, j))
+			continue;
+
+		float* joint = body.joints[j];
+		float* position = position_[slot][j];
+		float* velocity = velocity_[slot][j];
+		float* p = covariance_[slot][j];
+
+		if (!(previous & (1u << j))) {
+			for (int a = 0; a < 3; a++) {
+				position[a] = joint[a];
+				velocity[a] = 0;
+			}
+			p[0] = r;
+			p[1] = 0;
+			p[2] = INITIAL_VELOCITY_VARIANCE;
+			continue;
+		}
+
+		// Predict
+		float p00 = p[0] + dt * (2.0f * p[1] + dt * p[2]) + q00;
+		float p01 = p[1] + dt * p[2] + q01;
+		float p11 = p[2] + q11;
+
+		// Update with the measured position
+		float k0 = p00 / (p00 + r);
+		float k1 = p01 / (p00 + r);
+		for (int a = 0; a < 3; a++) {
+			float predicted = position[a] + velocity[a] * dt;
+			float residual = settle(joint[a] - predicted);
+			position[a] = predicted + k0 * residual;
+			velocity[a] = settle(velocity[a] + k1 * residual);
+			joint[a] = position[a];
+		}
+		p[0] = (1.0f - k0) * p00;
+		p[1] = (1.0f - k0) * p01;
+		p[2] = p11 - k1 * p01;
+	}
+
+	slotJointMask_[slot] = body.jointMask;
+}
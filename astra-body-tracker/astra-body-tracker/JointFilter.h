@@ -0,0 +1,73 @@
+#ifndef JOINTFILTER_H
+#define JOINTFILTER_H
+
+#include "FrameRecord.h"
+
+enum class FilterType
+{
+	None,
+	OneEuro,
+	Kalman
+};
+
+struct FilterSettings
+{
+	FilterType type = FilterType::None;
+
+	// One-Euro: cutoff in Hz when a joint is still, raised by beta Hz for every
+	// mm/s of joint speed so fast movements are not dragged behind
+	float minCutoff = 1.5f;
+	float beta = 0.01f;
+	float derivativeCutoff = 1.0f;
+
+	// Constant-velocity Kalman: standard deviation of the sensor's position
+	// noise in mm and of the unmodelled acceleration in mm/s^2
+	float measurementNoise = 5.0f;
+	float accelerationNoise = 1000.0f;
+};
+
+/*
+	Smooths joint positions between extraction and the angle calculations, so
+	shoulder_angle and everything after it see the filtered joints. State for
+	ASTRA_MAX_BODIES bodies lives in fixed arrays indexed [slot][joint], laid out
+	contiguously per body; nothing is allocated after construction, which keeps
+	the filter inside the frame callback at well under a microsecond per body.
+
+	A body's slot is reset when the SDK reports it lost or it is missing from a
+	frame, and a joint restarts from its raw position when it was not tracked in
+	the previous frame. Orientations are passed through unfiltered.
+*/
+class JointFilterBank
+{
+public:
+	explicit JointFilterBank(const FilterSettings& settings);
+
+	// Filters every body in record in place, using record.timestampUs as the clock
+	void apply(FrameRecord& record);
+
+private:
+	int slot_for(uint8_t id);
+	void filter_one_euro(int slot, BodyRecord& body, float dt);
+	void filter_kalman(int slot, BodyRecord& body, float dt);
+
+	FilterSettings settings_;
+
+	// Body id owning each slot, 0 when free
+	uint8_t slotIds_[ASTRA_MAX_BODIES];
+	bool slotSeen_[ASTRA_MAX_BODIES];
+	uint64_t slotTimestampUs_[ASTRA_MAX_BODIES];
+
+	// Joints that had state after the previous frame
+	uint32_t slotJointMask_[ASTRA_MAX_BODIES];
+
+	// One-Euro: filtered position and filtered velocity per axis.
+	// Kalman: position and velocity estimates per axis.
+	float position_[ASTRA_MAX_BODIES][ASTRA_MAX_JOINTS][3];
+	float velocity_[ASTRA_MAX_BODIES][ASTRA_MAX_JOINTS][3];
+
+	// Kalman covariance [p00, p01, p11] per joint. It does not depend on the
+	// measurements, so the three axes share it.
+	float covariance_[ASTRA_MAX_BODIES][ASTRA_MAX_JOINTS][3];
+};
+
+#endif /* JOINTFILTER_H */
@@ -0,0 +1,98 @@
+#include "JointReceiver.h"
+#include <SFML/Network/IpAddress.hpp>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+bool JointReceiver::Socket::bind_shared(unsigned short port)
+{
+	// The option has to be set between creating the socket and binding it
+	create();
+	int reuse = 1;
+	setsockopt(getHandle(), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+	return bind(port) == sf::Socket::Done;
+}
+
+bool JointReceiver::Socket::join(const sf::IpAddress& group)
+{
+	ip_mreq request;
+	request.imr_multiaddr.s_addr = htonl(group.toInteger());
+	request.imr_interface.s_addr = htonl(INADDR_ANY);
+	return setsockopt(getHandle(), IPPROTO_IP, IP_ADD_MEMBERSHIP,
+		reinterpret_cast<const char*>(&request), sizeof(request)) == 0;
+}
+
+JointReceiver::JointReceiver()
+{
+	latest_.bodyCount = 0;
+}
+
+bool JointReceiver::open(unsigned short port, const std::string& group)
+{
+	close();
+	socket_.setBlocking(false);
+	if (!socket_.bind_shared(port))
+		return false;
+
+	if (!group.empty()) {
+		sf::IpAddress address(group);
+		// 0 for a failed lookup; sf::IpAddress::None cannot be delay-loaded
+		if (address.toInteger() == 0 || !socket_.join(address)) {
+			socket_.unbind();
+			return false;
+		}
+	}
+	return true;
+}
+
+void JointReceiver::close()
+{
+	socket_.unbind();
+	hasFrame_ = false;
+}
+
+bool JointReceiver::poll()
+{
+	bool changed = false;
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	for (;;) {
+		size_t received;
+		sf::IpAddress sender;
+		unsigned short senderPort;
+		if (socket_.receive(buffer_, sizeof(buffer_), received, sender, senderPort) != sf::Socket::Done)
+			break;
+
+		if (!decode_joint_datagram(buffer_, received, incoming_)) {
+			malformed_++;
+			continue;
+		}
+
+		if (!accept(incoming_, now)) {
+			stale_++;
+			continue;
+		}
+
+		latest_ = incoming_;
+		lastAccepted_ = now;
+		hasFrame_ = true;
+		accepted_++;
+		changed = true;
+	}
+	return changed;
+}
+
+bool JointReceiver::accept(const JointFrame& frame, std::chrono::steady_clock::time_point now)
+{
+	if (!hasFrame_)
+		return true;
+	if (frame.session == latest_.session)
+		return sequence_after(frame.sequence, latest_.sequence);
+	return now - lastAccepted_ >= std::chrono::milliseconds(JOINT_RECEIVER_SESSION_TIMEOUT_MS);
+}
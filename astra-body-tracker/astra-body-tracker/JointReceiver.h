@@ -0,0 +1,65 @@
+#ifndef JOINTRECEIVER_H
+#define JOINTRECEIVER_H
+
+#include "JointDatagram.h"
+#include <SFML/Network/UdpSocket.hpp>
+#include <chrono>
+#include <string>
+
+/*
+	Receiving end of UdpPublisher, small enough to link into a display.
+
+	poll() reads every datagram waiting on the socket without blocking and
+	keeps only the newest, so a display that polls once per repaint always
+	draws the latest complete skeleton and never works through a backlog.
+	Datagrams older than the one kept, duplicates and datagrams from another
+	publisher are discarded. A different session only takes over once the
+	current one has been silent for JOINT_RECEIVER_SESSION_TIMEOUT_MS, which
+	follows a restarted tracker without flipping between two live ones.
+*/
+const int JOINT_RECEIVER_SESSION_TIMEOUT_MS = 1000;
+
+class JointReceiver
+{
+public:
+	JointReceiver();
+
+	// Listens on port, also joining group when one is given. Several
+	// receivers on one machine can share a multicast port.
+	bool open(unsigned short port, const std::string& group = "");
+	void close();
+
+	// Returns true when latest() changed
+	bool poll();
+
+	bool has_frame() const { return hasFrame_; }
+	const JointFrame& latest() const { return latest_; }
+
+	uint64_t accepted_datagrams() const { return accepted_; }
+	uint64_t stale_datagrams() const { return stale_; }
+	uint64_t malformed_datagrams() const { return malformed_; }
+
+private:
+	// Reaches the socket options SFML does not wrap
+	class Socket : public sf::UdpSocket
+	{
+	public:
+		bool bind_shared(unsigned short port);
+		bool join(const sf::IpAddress& group);
+	};
+
+	bool accept(const JointFrame& frame, std::chrono::steady_clock::time_point now);
+
+	Socket socket_;
+	char buffer_[JOINT_DATAGRAM_MAX_SIZE + 1];
+	JointFrame incoming_;
+	JointFrame latest_;
+	bool hasFrame_ = false;
+	std::chrono::steady_clock::time_point lastAccepted_;
+
+	uint64_t accepted_ = 0;
+	uint64_t stale_ = 0;
+	uint64_t malformed_ = 0;
+};
+
+#endif /* JOINTRECEIVER_H */
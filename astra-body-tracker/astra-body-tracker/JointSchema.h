@@ -0,0 +1,70 @@
+#ifndef JOINTSCHEMA_H
+#define JOINTSCHEMA_H
+
+#include <astra/astra.hpp>
+#include <cstddef>
+
+struct JointInfo
+{
+	astra::JointType type;
+
+	// Name used by the Electron app as the key of the joint in "joints"
+	const char* name;
+
+	// Pre-rendered `"<name>": {"x": ` so the encoder can copy it in one go
+	const char* jsonKey;
+	size_t jsonKeyLength;
+
+	// Other end of the bone leading towards BaseSpine, Unknown for BaseSpine itself
+	astra::JointType parent;
+};
+
+#define JOINT_JSON_KEY(name) "\"" name "\": {\"x\": "
+#define JOINT_INFO(type, name, parent) \
+	{ astra::JointType::type, name, JOINT_JSON_KEY(name), sizeof(JOINT_JSON_KEY(name)) - 1, astra::JointType::parent }
+
+// Indexed by astra::JointType
+constexpr JointInfo JOINT_SCHEMA[ASTRA_MAX_JOINTS] = {
+	JOINT_INFO(Head,          "Head",           Neck),
+	JOINT_INFO(ShoulderSpine, "Spine Top",      MidSpine),
+	JOINT_INFO(LeftShoulder,  "Left Shoulder",  ShoulderSpine),
+	JOINT_INFO(LeftElbow,     "Left Elbow",     LeftShoulder),
+	JOINT_INFO(LeftHand,      "Left Hand",      LeftWrist),
+	JOINT_INFO(RightShoulder, "Right Shoulder", ShoulderSpine),
+	JOINT_INFO(RightElbow,    "Right Elbow",    RightShoulder),
+	JOINT_INFO(RightHand,     "Right Hand",     RightWrist),
+	JOINT_INFO(MidSpine,      "Spine Middle",   BaseSpine),
+	JOINT_INFO(BaseSpine,     "Spine Base",     Unknown),
+	JOINT_INFO(LeftHip,       "Left Hip",       BaseSpine),
+	JOINT_INFO(LeftKnee,      "Left Knee",      LeftHip),
+	JOINT_INFO(LeftFoot,      "Left Foot",      LeftKnee),
+	JOINT_INFO(RightHip,      "Right Hip",      BaseSpine),
+	JOINT_INFO(RightKnee,     "Right Knee",     RightHip),
+	JOINT_INFO(RightFoot,     "Right Foot",     RightKnee),
+	JOINT_INFO(LeftWrist,     "Left Wrist",     LeftElbow),
+	JOINT_INFO(RightWrist,    "Right Wrist",    RightElbow),
+	JOINT_INFO(Neck,          "Neck",           ShoulderSpine),
+};
+
+#undef JOINT_INFO
+#undef JOINT_JSON_KEY
+
+constexpr int joint_index(astra::JointType type)
+{
+	return static_cast<int>(type);
+}
+
+constexpr const JointInfo& joint_info(astra::JointType type)
+{
+	return JOINT_SCHEMA[joint_index(type)];
+}
+
+constexpr bool joint_schema_is_ordered(int i = 0)
+{
+	return i == ASTRA_MAX_JOINTS ||
+		(joint_index(JOINT_SCHEMA[i].type) == i && joint_schema_is_ordered(i + 1));
+}
+
+static_assert(joint_schema_is_ordered(), "JOINT_SCHEMA must be indexed by astra::JointType");
+
+#endif /* JOINTSCHEMA_H */
@@ -0,0 +1,26 @@
+#include "NetworkLibrary.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+const char* network_library_name()
+{
+#ifdef _DEBUG
+	return "sfml-network-d-2.dll";
+#else
+	return "sfml-network-2.dll";
+#endif
+}
+
+bool network_library_available()
+{
+#ifdef _WIN32
+	// The delay-load helper binds to the copy loaded here
+	static bool available = LoadLibraryA(network_library_name()) != nullptr;
+	return available;
+#else
+	return true;
+#endif
+}
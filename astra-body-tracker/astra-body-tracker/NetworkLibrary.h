@@ -0,0 +1,19 @@
+#ifndef NETWORKLIBRARY_H
+#define NETWORKLIBRARY_H
+
+/*
+	sfml-network is delay-loaded, so the tracker starts without its DLL and
+	only --serve, --udp and the delta format need it. Those check here first:
+	once the DLL cannot be found, the first call into it would raise an
+	exception instead of failing.
+
+	Nothing that constructs an SFML network object, not even an sf::Packet or
+	sf::IpAddress, may run before the check. Static data such as
+	sf::IpAddress::None cannot be delay-loaded at all and must not be used.
+*/
+const char* network_library_name();
+
+// Loads the DLL on the first call and keeps it loaded
+bool network_library_available();
+
+#endif /* NETWORKLIBRARY_H */
@@ -0,0 +1,67 @@
+#include "OrientationMetrics.h"
+#include "JointSchema.h"
+
+static const float DEGREES = 57.2957795f;
+
+static const astra::JointType SPINE_JOINTS[SPINE_SEGMENT_COUNT + 1] = {
+	astra::JointType::BaseSpine,
+	astra::JointType::MidSpine,
+	astra::JointType::ShoulderSpine,
+	astra::JointType::Neck
+};
+
+// Rotation of child in the frame of parent, MISSING_ROTATION when either is missing
+static Quaternion relative_rotation(const BodyRecord& body, astra::JointType parent, astra::JointType child)
+{
+	const Quaternion& p = body.orientations[joint_index(parent)];
+	const Quaternion& c = body.orientations[joint_index(child)];
+	if (!rotation_valid(p) || !rotation_valid(c))
+		return MISSING_ROTATION;
+	return conjugate(p) * c;
+}
+
+// Angle of the twist part of q about the y axis, the direction of the bone, in (-180, 180]
+static float twist_about_y(const Quaternion& q)
+{
+	float angle = 2.0f * atan2f(q.y, q.w) * DEGREES;
+	if (angle > 180.0f)
+		angle -= 360.0f;
+	else if (angle <= -180.0f)
+		angle += 360.0f;
+	return angle;
+}
+
+static SegmentAngles segment_angles(const Quaternion& q)
+{
+	if (!rotation_valid(q))
+		return { NAN, NAN, NAN };
+
+	// Where the rotation takes the bone direction: the y column of its matrix.
+	// Rotating about x tips y towards z, rotating about z tips it towards -x,
+	// and neither is affected by the twist about y itself.
+	float vx = 2.0f * (q.x * q.y - q.w * q.z);
+	float vy = 1.0f - 2.0f * (q.x * q.x + q.z * q.z);
+	float vz = 2.0f * (q.y * q.z + q.w * q.x);
+
+	SegmentAngles angles;
+	angles.flexion = atan2f(vz, vy) * DEGREES;
+	angles.lateral = atan2f(-vx, vy) * DEGREES;
+	angles.axial = twist_about_y(q);
+	return angles;
+}
+
+void compute_orientation_metrics(BodyRecord& body)
+{
+	for (int s = 0; s < SPINE_SEGMENT_COUNT; s++)
+		body.spine[s] = segment_angles(relative_rotation(body, SPINE_JOINTS[s], SPINE_JOINTS[s + 1]));
+
+	Quaternion trunk = relative_rotation(body, astra::JointType::BaseSpine, astra::JointType::ShoulderSpine);
+	body.trunkRotation = rotation_valid(trunk) ? twist_about_y(trunk) : NAN;
+}
+
+void clear_orientations(BodyRecord& body)
+{
+	for (Quaternion& q : body.orientations)
+		q = MISSING_ROTATION;
+	compute_orientation_metrics(body);
+}
@@ -0,0 +1,14 @@
+#ifndef ORIENTATIONMETRICS_H
+#define ORIENTATIONMETRICS_H
+
+#include "FrameRecord.h"
+
+// Fills trunkRotation and spine from body.orientations. Works on the record in
+// place without allocating, so it runs in the frame callback for every body.
+void compute_orientation_metrics(BodyRecord& body);
+
+// Marks every rotation and orientation metric missing, for records rebuilt
+// from sources that carry no orientations
+void clear_orientations(BodyRecord& body);
+
+#endif /* ORIENTATIONMETRICS_H */
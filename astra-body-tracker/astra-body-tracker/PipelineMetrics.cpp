@@ -0,0 +1,228 @@
+#include "PipelineMetrics.h"
+#include "SinkChannel.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+
+uint64_t pipeline_clock_us()
+{
+	using namespace std::chrono;
+	return static_cast<uint64_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+void LatencyHistogram::reset()
+{
+	memset(buckets_, 0, sizeof(buckets_));
+	count_ = 0;
+	sum_ = 0;
+	min_ = UINT64_MAX;
+	max_ = 0;
+}
+
+int LatencyHistogram::bucket_of(uint64_t us)
+{
+	const uint64_t linear = 1u << SUB_BUCKET_BITS;
+	if (us < linear)
+		return static_cast<int>(us);
+
+	int exponent = 0;
+	while ((us >> exponent) > 1)
+		exponent++;
+
+	int shift = exponent - SUB_BUCKET_BITS;
+	int sub = static_cast<int>((us >> shift) & (linear - 1));
+	return ((shift + 1) << SUB_BUCKET_BITS) + sub;
+}
+
+uint64_t LatencyHistogram::bucket_midpoint(int bucket)
+{
+	const int linear = 1 << SUB_BUCKET_BITS;
+	if (bucket < linear)
+		return static_cast<uint64_t>(bucket);
+
+	int shift = (bucket >> SUB_BUCKET_BITS) - 1;
+	uint64_t lower = static_cast<uint64_t>(linear + (bucket & (linear - 1))) << shift;
+	return lower + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::add(uint64_t us)
+{
+	buckets_[bucket_of(us)]++;
+	count_++;
+	sum_ += us;
+	if (us < min_)
+		min_ = us;
+	if (us > max_)
+		max_ = us;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+	for (int i = 0; i < BUCKET_COUNT; i++)
+		buckets_[i] += other.buckets_[i];
+	count_ += other.count_;
+	sum_ += other.sum_;
+	if (other.count_ && other.min_ < min_)
+		min_ = other.min_;
+	if (other.max_ > max_)
+		max_ = other.max_;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+	if (count_ == 0)
+		return 0;
+
+	uint64_t rank = static_cast<uint64_t>(q * (count_ - 1)) + 1;
+	uint64_t seen = 0;
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		seen += buckets_[i];
+		if (seen >= rank) {
+			// Never report outside what was actually measured
+			uint64_t value = bucket_midpoint(i);
+			if (value < min_)
+				return min_;
+			if (value > max_)
+				return max_;
+			return value;
+		}
+	}
+	return max_;
+}
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = {
+	"sdk", "extract", "queue", "serialize", "write", "total"
+};
+
+PipelineMetrics::PipelineMetrics(std::ostream& out, int reportInterval)
+	: out_(out),
+	  intervalUs_(static_cast<uint64_t>(reportInterval) * 1000000),
+	  startUs_(pipeline_clock_us()),
+	  windowStartUs_(startUs_)
+{
+}
+
+void PipelineMetrics::add_channel(SinkChannel& channel)
+{
+	ChannelStats stats;
+	stats.channel = &channel;
+	stats.produced = 0;
+	stats.delivered = 0;
+	stats.dropped = 0;
+	channels_.push_back(stats);
+	channel.enable_timing();
+}
+
+static uint64_t lapse(uint64_t from, uint64_t to)
+{
+	return to > from ? to - from : 0;
+}
+
+void PipelineMetrics::add(const FrameTiming& frame, const WriterTiming& writer)
+{
+	uint64_t firstUs = frame.callbackUs;
+	if (frame.updateUs != 0) {
+		firstUs = frame.updateUs;
+		window_[STAGE_SDK].add(lapse(frame.updateUs, frame.callbackUs));
+
+		if (haveSdkIndex_ && frame.sdkFrameIndex > lastSdkIndex_ + 1)
+			windowSkipped_ += frame.sdkFrameIndex - lastSdkIndex_ - 1;
+		haveSdkIndex_ = true;
+		lastSdkIndex_ = frame.sdkFrameIndex;
+	}
+
+	window_[STAGE_EXTRACT].add(lapse(frame.callbackUs, frame.extractedUs));
+	window_[STAGE_QUEUE].add(lapse(frame.extractedUs, writer.dequeuedUs));
+	window_[STAGE_SERIALIZE].add(lapse(writer.dequeuedUs, writer.encodedUs));
+	window_[STAGE_WRITE].add(lapse(writer.flushStartUs, writer.writtenUs));
+	window_[STAGE_TOTAL].add(lapse(firstUs, writer.writtenUs));
+}
+
+void PipelineMetrics::maybe_report(uint64_t nowUs)
+{
+	if (nowUs - windowStartUs_ < intervalUs_)
+		return;
+
+	report("last", (nowUs - windowStartUs_) / 1e6, window_, windowSkipped_);
+	report_channels(false);
+
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		total_[i].merge(window_[i]);
+		window_[i].reset();
+	}
+	totalSkipped_ += windowSkipped_;
+	windowSkipped_ = 0;
+	windowStartUs_ = nowUs;
+}
+
+void PipelineMetrics::report_final()
+{
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		total_[i].merge(window_[i]);
+		window_[i].reset();
+	}
+	totalSkipped_ += windowSkipped_;
+	windowSkipped_ = 0;
+
+	report("session", (pipeline_clock_us() - startUs_) / 1e6, total_, totalSkipped_);
+	report_channels(true);
+}
+
+void PipelineMetrics::report_channels(bool session)
+{
+	for (ChannelStats& stats : channels_) {
+		SinkChannel& channel = *stats.channel;
+		stats.channel->take_latencies(stats.consume, stats.flush);
+		stats.totalConsume.merge(stats.consume);
+		stats.totalFlush.merge(stats.flush);
+
+		uint64_t produced = channel.produced_frames();
+		uint64_t delivered = channel.delivered_frames();
+		uint64_t dropped = channel.dropped_frames();
+		uint64_t since = session ? 0 : 1;
+		out_ << "  sink " << channel.name() << " (" << sink_policy_name(channel.policy()) << "): "
+			<< produced - since * stats.produced << " frames produced, "
+			<< delivered - since * stats.delivered << " delivered, "
+			<< dropped - since * stats.dropped << " dropped" << std::endl;
+		report_histogram("consume", session ? stats.totalConsume : stats.consume);
+		report_histogram("flush", session ? stats.totalFlush : stats.flush);
+
+		stats.consume.reset();
+		stats.flush.reset();
+		stats.produced = produced;
+		stats.delivered = delivered;
+		stats.dropped = dropped;
+	}
+	out_.flush();
+}
+
+void PipelineMetrics::report_histogram(const char* name, const LatencyHistogram& h)
+{
+	if (h.count() == 0)
+		return;
+
+	out_ << "  " << std::left << std::setw(10) << name << std::right
+		<< std::setw(9) << h.count()
+		<< std::fixed << std::setprecision(0) << std::setw(9) << h.mean()
+		<< std::setw(9) << h.minimum()
+		<< std::setw(9) << h.percentile(0.50)
+		<< std::setw(9) << h.percentile(0.90)
+		<< std::setw(9) << h.percentile(0.99)
+		<< std::setw(9) << h.maximum() << std::endl;
+}
+
+void PipelineMetrics::report(const char* title, double seconds, const LatencyHistogram* stages, uint64_t skipped)
+{
+	out_ << "pipeline latency, " << title << " " << std::fixed << std::setprecision(1) << seconds << " s: "
+		<< stages[STAGE_TOTAL].count() << " frames written, " << skipped << " skipped by the SDK" << std::endl
+		<< "  stage        frames     mean      min      p50      p90      p99      max  (us)" << std::endl;
+
+	for (int i = 0; i < STAGE_COUNT; i++)
+		report_histogram(STAGE_NAMES[i], stages[i]);
+	out_.flush();
+}
@@ -0,0 +1,141 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+class SinkChannel;
+
+// Microseconds on the steady clock that every stage timestamp is taken from
+uint64_t pipeline_clock_us();
+
+// When a frame passed each stage before it was queued, on pipeline_clock_us().
+// updateUs is zero for frames that did not come from the sensor.
+struct FrameTiming
+{
+	// Frame index the SDK gave the body frame, used to spot frames it skipped
+	uint32_t sdkFrameIndex;
+
+	uint64_t updateUs;
+	uint64_t callbackUs;
+	uint64_t extractedUs;
+};
+
+// When the writer thread handled a frame, on pipeline_clock_us()
+struct WriterTiming
+{
+	uint64_t dequeuedUs;
+	uint64_t encodedUs;
+	uint64_t flushStartUs;
+	uint64_t writtenUs;
+};
+
+enum PipelineStage
+{
+	STAGE_SDK,       // astra_update() entered -> on_frame_ready entered
+	STAGE_EXTRACT,   // on_frame_ready entered -> bodies copied into the record
+	STAGE_QUEUE,     // record queued -> picked up by the writer thread
+	STAGE_SERIALIZE, // picked up -> encoded by every sink
+	STAGE_WRITE,     // sinks flushed to the pipe or file
+	STAGE_TOTAL,     // first timestamp -> written
+	STAGE_COUNT
+};
+
+/*
+	Latency histogram with logarithmic buckets, eight per power of two, so any
+	percentile it reports is within 12.5% of the true value. Fixed size and
+	allocation-free, cheap enough to update for every frame.
+*/
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	void add(uint64_t us);
+	void merge(const LatencyHistogram& other);
+	void reset();
+
+	uint64_t count() const { return count_; }
+	uint64_t minimum() const { return count_ ? min_ : 0; }
+	uint64_t maximum() const { return max_; }
+	double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+	// q in [0, 1]; the midpoint of the bucket holding that rank
+	uint64_t percentile(double q) const;
+
+	static const int SUB_BUCKET_BITS = 3;
+	static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+private:
+	static int bucket_of(uint64_t us);
+	static uint64_t bucket_midpoint(int bucket);
+
+	uint64_t buckets_[BUCKET_COUNT];
+	uint64_t count_;
+	uint64_t sum_;
+	uint64_t min_;
+	uint64_t max_;
+};
+
+/*
+	Per-stage latency of every frame through the pipeline, fed by the writer
+	thread. Every reportInterval seconds it writes a summary of the frames seen
+	since the previous one, and a summary of the whole session at the end.
+
+	For an output behind a SinkChannel, the serialize and write stages only
+	time the copy into the channel's queue. The summaries therefore also list
+	every channel: how long its own thread spent in the sink's consume and
+	flush, and how many frames its policy delivered and dropped.
+*/
+class PipelineMetrics
+{
+public:
+	PipelineMetrics(std::ostream& out, int reportInterval);
+
+	// Before the channel starts; turns on its timing
+	void add_channel(SinkChannel& channel);
+
+	// Writer thread only
+	void add(const FrameTiming& frame, const WriterTiming& writer);
+	void maybe_report(uint64_t nowUs);
+
+	// Once the writer and every channel have stopped
+	void report_final();
+
+private:
+	struct ChannelStats
+	{
+		SinkChannel* channel;
+		LatencyHistogram consume;
+		LatencyHistogram flush;
+		LatencyHistogram totalConsume;
+		LatencyHistogram totalFlush;
+
+		// Counters of the channel at the previous report
+		uint64_t produced;
+		uint64_t delivered;
+		uint64_t dropped;
+	};
+
+	void report(const char* title, double seconds, const LatencyHistogram* stages, uint64_t skipped);
+	void report_channels(bool session);
+	void report_histogram(const char* name, const LatencyHistogram& h);
+
+	std::ostream& out_;
+	uint64_t intervalUs_;
+	uint64_t startUs_;
+	uint64_t windowStartUs_;
+
+	LatencyHistogram window_[STAGE_COUNT];
+	LatencyHistogram total_[STAGE_COUNT];
+
+	bool haveSdkIndex_ = false;
+	uint32_t lastSdkIndex_ = 0;
+	uint64_t windowSkipped_ = 0;
+	uint64_t totalSkipped_ = 0;
+
+	std::vector<ChannelStats> channels_;
+};
+
+#endif /* PIPELINEMETRICS_H */
@@ -0,0 +1,64 @@
+#include "PostureAnalysis.h"
+#include "RunningStats.h"
+#include <vector>
+
+JointColumns session_joint_columns(const MappedSession& session)
+{
+	JointColumns joints;
+	joints.rows = session.rows();
+	joints.jointMask = session.joint_masks();
+	for (int j = 0; j < ASTRA_MAX_JOINTS; j++) {
+		joints.x[j] = session.joint_axis(j, 0);
+		joints.y[j] = session.joint_axis(j, 1);
+		joints.z[j] = session.joint_axis(j, 2);
+	}
+	return joints;
+}
+
+static void write_number(std::ostream& out, double value)
+{
+	if (isfinite(value))
+		out << value;
+	else
+		out << "null";
+}
+
+static void write_metric(std::ostream& out, const char* name, const std::vector<float>& values)
+{
+	RunningStats stats;
+	stats.reset();
+	for (float v : values) {
+		if (!isnan(v))
+			stats.add(v);
+	}
+
+	out << ",\"" << name << "\": {\"count\": " << stats.count << ",\"mean\": ";
+	write_number(out, stats.count ? stats.mean : NAN);
+	out << ",\"stddev\": ";
+	write_number(out, stats.stddev());
+	out << ",\"min\": ";
+	write_number(out, stats.min);
+	out << ",\"max\": ";
+	write_number(out, stats.max);
+	out << "}";
+}
+
+bool analyze_session(const std::string& path, std::ostream& out)
+{
+	MappedSession session;
+	if (!session.open(path))
+		return false;
+
+	size_t rows = session.rows();
+	std::vector<float> shoulderTilt(rows), hipTilt(rows), twist(rows), headOffset(rows);
+	PostureColumns metrics = { shoulderTilt.data(), hipTilt.data(), twist.data(), headOffset.data() };
+	compute_posture(session_joint_columns(session), metrics);
+
+	out << "{\"rows\": " << rows << ",\"simd\": \"" << simd_level_name(detect_simd_level()) << "\"";
+	write_metric(out, "shoulder_tilt", shoulderTilt);
+	write_metric(out, "hip_tilt", hipTilt);
+	write_metric(out, "twist", twist);
+	write_metric(out, "head_offset", headOffset);
+	out << "}" << std::endl;
+	return true;
+}
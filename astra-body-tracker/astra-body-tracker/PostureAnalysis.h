@@ -0,0 +1,17 @@
+#ifndef POSTUREANALYSIS_H
+#define POSTUREANALYSIS_H
+
+#include "PostureKernels.h"
+#include "SessionFile.h"
+#include <ostream>
+#include <string>
+
+// Points the kernel inputs at the joint columns of a mapped session
+JointColumns session_joint_columns(const MappedSession& session);
+
+// Runs the posture kernels over the session file at path and writes one JSON
+// line with count, mean, stddev, min and max of every metric. Meant for
+// re-analysing archived sessions from a script, one patient directory per run.
+bool analyze_session(const std::string& path, std::ostream& out);
+
+#endif /* POSTUREANALYSIS_H */
@@ -0,0 +1,198 @@
+#include "PostureKernels.h"
+#include <emmintrin.h>
+#include <math.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+static const uint32_t SHOULDERS = (1u << ASTRA_JOINT_LEFT_SHOULDER) | (1u << ASTRA_JOINT_RIGHT_SHOULDER);
+static const uint32_t HIPS = (1u << ASTRA_JOINT_LEFT_HIP) | (1u << ASTRA_JOINT_RIGHT_HIP);
+static const uint32_t HEAD_AND_BASE = (1u << ASTRA_JOINT_HEAD) | (1u << ASTRA_JOINT_BASE_SPINE);
+
+// atan2 from the shared polynomial, 0 for atan2(0, 0)
+static float fast_atan2(float y, float x)
+{
+	float ax = fabsf(x), ay = fabsf(y);
+	float hi = ax > ay ? ax : ay;
+	float lo = ax > ay ? ay : ax;
+	float a = hi > 0 ? lo / hi : 0;
+	float s = a * a;
+	float r = (((((ATAN_C5 * s + ATAN_C4) * s + ATAN_C3) * s + ATAN_C2) * s + ATAN_C1) * s + ATAN_C0) * a;
+	if (ay > ax)
+		r = HALF_PI_F - r;
+	if (x < 0)
+		r = PI_F - r;
+	return copysignf(r, y);
+}
+
+void posture_kernel_scalar(const JointColumns& joints, const PostureColumns& out, size_t begin, size_t end)
+{
+	const int ls = ASTRA_JOINT_LEFT_SHOULDER, rs = ASTRA_JOINT_RIGHT_SHOULDER;
+	const int lh = ASTRA_JOINT_LEFT_HIP, rh = ASTRA_JOINT_RIGHT_HIP;
+	const int head = ASTRA_JOINT_HEAD, base = ASTRA_JOINT_BASE_SPINE;
+
+	for (size_t i = begin; i < end; i++) {
+		uint32_t mask = joints.jointMask[i];
+
+		float sx = joints.x[rs][i] - joints.x[ls][i];
+		float sy = joints.y[rs][i] - joints.y[ls][i];
+		float sz = joints.z[rs][i] - joints.z[ls][i];
+		float hx = joints.x[rh][i] - joints.x[lh][i];
+		float hy = joints.y[rh][i] - joints.y[lh][i];
+		float hz = joints.z[rh][i] - joints.z[lh][i];
+
+		float shoulderTilt = fast_atan2(sy, sqrtf(sx * sx + sz * sz)) * DEGREES_PER_RADIAN;
+		float hipTilt = fast_atan2(hy, sqrtf(hx * hx + hz * hz)) * DEGREES_PER_RADIAN;
+		float twist = fast_atan2(sx * hz - sz * hx, sx * hx + sz * hz) * DEGREES_PER_RADIAN;
+		float headOffset = joints.x[head][i] - joints.x[base][i];
+
+		bool shoulders = (mask & SHOULDERS) == SHOULDERS;
+		bool hips = (mask & HIPS) == HIPS;
+		out.shoulderTilt[i] = shoulders ? shoulderTilt : NAN;
+		out.hipTilt[i] = hips ? hipTilt : NAN;
+		out.twist[i] = shoulders && hips ? twist : NAN;
+		out.headOffset[i] = (mask & HEAD_AND_BASE) == HEAD_AND_BASE ? headOffset : NAN;
+	}
+}
+
+// SSE2 is part of x64, so this kernel needs no separate translation unit
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 atan2_ps(__m128 y, __m128 x)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 ax = _mm_andnot_ps(sign, x), ay = _mm_andnot_ps(sign, y);
+	__m128 hi = _mm_max_ps(ax, ay);
+	__m128 lo = _mm_min_ps(ax, ay);
+	__m128 a = _mm_and_ps(_mm_div_ps(lo, hi), _mm_cmpgt_ps(hi, _mm_setzero_ps()));
+	__m128 s = _mm_mul_ps(a, a);
+	__m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ATAN_C5), s), _mm_set1_ps(ATAN_C4));
+	r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(ATAN_C3));
+	r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(ATAN_C2));
+	r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(ATAN_C1));
+	r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(ATAN_C0));
+	r = _mm_mul_ps(r, a);
+	r = select_ps(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(HALF_PI_F), r), r);
+	r = select_ps(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI_F), r), r);
+	return _mm_or_ps(r, _mm_and_ps(sign, y));
+}
+
+static inline __m128 has_joints(__m128i mask, uint32_t joints)
+{
+	__m128i wanted = _mm_set1_epi32(static_cast<int>(joints));
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(mask, wanted), wanted));
+}
+
+size_t posture_kernel_sse2(const JointColumns& joints, const PostureColumns& out, size_t begin, size_t end)
+{
+	const int ls = ASTRA_JOINT_LEFT_SHOULDER, rs = ASTRA_JOINT_RIGHT_SHOULDER;
+	const int lh = ASTRA_JOINT_LEFT_HIP, rh = ASTRA_JOINT_RIGHT_HIP;
+	const int head = ASTRA_JOINT_HEAD, base = ASTRA_JOINT_BASE_SPINE;
+	const __m128 degrees = _mm_set1_ps(DEGREES_PER_RADIAN);
+	const __m128 nan = _mm_set1_ps(NAN);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(joints.jointMask + i));
+
+		__m128 sx = _mm_sub_ps(_mm_loadu_ps(joints.x[rs] + i), _mm_loadu_ps(joints.x[ls] + i));
+		__m128 sy = _mm_sub_ps(_mm_loadu_ps(joints.y[rs] + i), _mm_loadu_ps(joints.y[ls] + i));
+		__m128 sz = _mm_sub_ps(_mm_loadu_ps(joints.z[rs] + i), _mm_loadu_ps(joints.z[ls] + i));
+		__m128 hx = _mm_sub_ps(_mm_loadu_ps(joints.x[rh] + i), _mm_loadu_ps(joints.x[lh] + i));
+		__m128 hy = _mm_sub_ps(_mm_loadu_ps(joints.y[rh] + i), _mm_loadu_ps(joints.y[lh] + i));
+		__m128 hz = _mm_sub_ps(_mm_loadu_ps(joints.z[rh] + i), _mm_loadu_ps(joints.z[lh] + i));
+
+		__m128 shoulderRun = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(sx, sx), _mm_mul_ps(sz, sz)));
+		__m128 hipRun = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(hx, hx), _mm_mul_ps(hz, hz)));
+		__m128 cross = _mm_sub_ps(_mm_mul_ps(sx, hz), _mm_mul_ps(sz, hx));
+		__m128 dot = _mm_add_ps(_mm_mul_ps(sx, hx), _mm_mul_ps(sz, hz));
+
+		__m128 shoulderTilt = _mm_mul_ps(atan2_ps(sy, shoulderRun), degrees);
+		__m128 hipTilt = _mm_mul_ps(atan2_ps(hy, hipRun), degrees);
+		__m128 twist = _mm_mul_ps(atan2_ps(cross, dot), degrees);
+		__m128 headOffset = _mm_sub_ps(_mm_loadu_ps(joints.x[head] + i), _mm_loadu_ps(joints.x[base] + i));
+
+		__m128 shoulders = has_joints(mask, SHOULDERS);
+		__m128 hips = has_joints(mask, HIPS);
+		_mm_storeu_ps(out.shoulderTilt + i, select_ps(shoulders, shoulderTilt, nan));
+		_mm_storeu_ps(out.hipTilt + i, select_ps(hips, hipTilt, nan));
+		_mm_storeu_ps(out.twist + i, select_ps(_mm_and_ps(shoulders, hips), twist, nan));
+		_mm_storeu_ps(out.headOffset + i, select_ps(has_joints(mask, HEAD_AND_BASE), headOffset, nan));
+	}
+	return i;
+}
+
+static SimdLevel query_simd_level()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	int highest = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	// AVX registers are only usable when the OS saves them on context switches
+	bool avxState = osxsave && avx && (_xgetbv(0) & 6) == 6;
+
+	bool avx2 = false;
+	if (highest >= 7 && avxState) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+#else
+	__builtin_cpu_init();
+	bool sse2 = __builtin_cpu_supports("sse2");
+	bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+	if (avx2)
+		return SimdLevel::Avx2;
+	if (sse2)
+		return SimdLevel::Sse2;
+	return SimdLevel::Scalar;
+}
+
+SimdLevel detect_simd_level()
+{
+	static const SimdLevel level = query_simd_level();
+	return level;
+}
+
+const char* simd_level_name(SimdLevel level)
+{
+	switch (level) {
+	case SimdLevel::Avx2:
+		return "avx2";
+	case SimdLevel::Sse2:
+		return "sse2";
+	default:
+		return "scalar";
+	}
+}
+
+void compute_posture(const JointColumns& joints, const PostureColumns& out)
+{
+	compute_posture(joints, out, detect_simd_level());
+}
+
+void compute_posture(const JointColumns& joints, const PostureColumns& out, SimdLevel level)
+{
+	if (level > detect_simd_level())
+		level = detect_simd_level();
+
+	size_t done = 0;
+	if (level == SimdLevel::Avx2)
+		done = posture_kernel_avx2(joints, out, 0, joints.rows);
+	else if (level == SimdLevel::Sse2)
+		done = posture_kernel_sse2(joints, out, 0, joints.rows);
+
+	posture_kernel_scalar(joints, out, done, joints.rows);
+}
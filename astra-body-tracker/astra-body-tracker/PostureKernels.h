@@ -0,0 +1,79 @@
+#ifndef POSTUREKERNELS_H
+#define POSTUREKERNELS_H
+
+#include <astra/capi/streams/body_types.h>
+#include <cstddef>
+#include <cstdint>
+
+/*
+	Batch posture metrics over joint positions stored as structure of arrays,
+	such as the columns of a session file. Every metric is computed for all
+	rows at once, four or eight rows per instruction where the CPU allows.
+
+	shoulderTilt    degrees of the left to right shoulder line against the
+	                horizontal, the same angle as shoulder_angle
+	hipTilt         the same for the hips (pelvic tilt)
+	twist           degrees between the shoulder and hip lines seen from above,
+	                positive when the shoulders are turned counterclockwise
+	headOffset      mm from the spine base to the head along the sensor x axis,
+	                which is the patient's left-right axis when they stand with
+	                their back to the sensor
+
+	A metric is NAN in rows where one of the joints it needs is missing. Angles
+	come from a polynomial arctangent accurate to about 1e-4 degrees, and every
+	level evaluates it in the same order, so results do not depend on the CPU.
+*/
+
+// Joint positions of rows rows; joint j of row i is (x[j][i], y[j][i], z[j][i]) in mm
+struct JointColumns
+{
+	size_t rows;
+	const uint32_t* jointMask;
+	const float* x[ASTRA_MAX_JOINTS];
+	const float* y[ASTRA_MAX_JOINTS];
+	const float* z[ASTRA_MAX_JOINTS];
+};
+
+// Destination arrays, rows entries each
+struct PostureColumns
+{
+	float* shoulderTilt;
+	float* hipTilt;
+	float* twist;
+	float* headOffset;
+};
+
+enum class SimdLevel
+{
+	Scalar,
+	Sse2,
+	Avx2
+};
+
+// Best level the CPU and operating system support, detected once
+SimdLevel detect_simd_level();
+
+const char* simd_level_name(SimdLevel level);
+
+// Uses the detected level, or level when it is lower
+void compute_posture(const JointColumns& joints, const PostureColumns& out);
+void compute_posture(const JointColumns& joints, const PostureColumns& out, SimdLevel level);
+
+// atan(a) on [0, 1] as a * P(a^2), shared by every kernel so they agree
+const float ATAN_C0 = 0.99997726f;
+const float ATAN_C1 = -0.33262347f;
+const float ATAN_C2 = 0.19354346f;
+const float ATAN_C3 = -0.11643287f;
+const float ATAN_C4 = 0.05265332f;
+const float ATAN_C5 = -0.01172120f;
+const float HALF_PI_F = 1.57079633f;
+const float PI_F = 3.14159265f;
+const float DEGREES_PER_RADIAN = 57.2957795f;
+
+// Rows begin .. end - 1 at one level. The SIMD kernels stop before the last
+// partial vector and return the first row they did not compute.
+void posture_kernel_scalar(const JointColumns& joints, const PostureColumns& out, size_t begin, size_t end);
+size_t posture_kernel_sse2(const JointColumns& joints, const PostureColumns& out, size_t begin, size_t end);
+size_t posture_kernel_avx2(const JointColumns& joints, const PostureColumns& out, size_t begin, size_t end);
+
+#endif /* POSTUREKERNELS_H */
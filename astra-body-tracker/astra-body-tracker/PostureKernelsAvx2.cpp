@@ -0,0 +1,77 @@
+// Built with /arch:AVX2 and only called after detect_simd_level() reports AVX2,
+// so nothing in here may be reachable from code that runs before that check.
+#include "PostureKernels.h"
+#include <immintrin.h>
+#include <math.h>
+
+static const uint32_t SHOULDERS = (1u << ASTRA_JOINT_LEFT_SHOULDER) | (1u << ASTRA_JOINT_RIGHT_SHOULDER);
+static const uint32_t HIPS = (1u << ASTRA_JOINT_LEFT_HIP) | (1u << ASTRA_JOINT_RIGHT_HIP);
+static const uint32_t HEAD_AND_BASE = (1u << ASTRA_JOINT_HEAD) | (1u << ASTRA_JOINT_BASE_SPINE);
+
+static inline __m256 atan2_ps(__m256 y, __m256 x)
+{
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 ax = _mm256_andnot_ps(sign, x), ay = _mm256_andnot_ps(sign, y);
+	__m256 hi = _mm256_max_ps(ax, ay);
+	__m256 lo = _mm256_min_ps(ax, ay);
+	__m256 a = _mm256_and_ps(_mm256_div_ps(lo, hi), _mm256_cmp_ps(hi, _mm256_setzero_ps(), _CMP_GT_OQ));
+	__m256 s = _mm256_mul_ps(a, a);
+	__m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(ATAN_C5), s), _mm256_set1_ps(ATAN_C4));
+	r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(ATAN_C3));
+	r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(ATAN_C2));
+	r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(ATAN_C1));
+	r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(ATAN_C0));
+	r = _mm256_mul_ps(r, a);
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(HALF_PI_F), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI_F), r), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+	return _mm256_or_ps(r, _mm256_and_ps(sign, y));
+}
+
+static inline __m256 has_joints(__m256i mask, uint32_t joints)
+{
+	__m256i wanted = _mm256_set1_epi32(static_cast<int>(joints));
+	return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(mask, wanted), wanted));
+}
+
+size_t posture_kernel_avx2(const JointColumns& joints, const PostureColumns& out, size_t begin, size_t end)
+{
+	const int ls = ASTRA_JOINT_LEFT_SHOULDER, rs = ASTRA_JOINT_RIGHT_SHOULDER;
+	const int lh = ASTRA_JOINT_LEFT_HIP, rh = ASTRA_JOINT_RIGHT_HIP;
+	const int head = ASTRA_JOINT_HEAD, base = ASTRA_JOINT_BASE_SPINE;
+	const __m256 degrees = _mm256_set1_ps(DEGREES_PER_RADIAN);
+	const __m256 nan = _mm256_set1_ps(NAN);
+
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(joints.jointMask + i));
+
+		__m256 sx = _mm256_sub_ps(_mm256_loadu_ps(joints.x[rs] + i), _mm256_loadu_ps(joints.x[ls] + i));
+		__m256 sy = _mm256_sub_ps(_mm256_loadu_ps(joints.y[rs] + i), _mm256_loadu_ps(joints.y[ls] + i));
+		__m256 sz = _mm256_sub_ps(_mm256_loadu_ps(joints.z[rs] + i), _mm256_loadu_ps(joints.z[ls] + i));
+		__m256 hx = _mm256_sub_ps(_mm256_loadu_ps(joints.x[rh] + i), _mm256_loadu_ps(joints.x[lh] + i));
+		__m256 hy = _mm256_sub_ps(_mm256_loadu_ps(joints.y[rh] + i), _mm256_loadu_ps(joints.y[lh] + i));
+		__m256 hz = _mm256_sub_ps(_mm256_loadu_ps(joints.z[rh] + i), _mm256_loadu_ps(joints.z[lh] + i));
+
+		// No FMA: AVX2 does not imply it, and fused results would differ from the other levels
+		__m256 shoulderRun = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(sx, sx), _mm256_mul_ps(sz, sz)));
+		__m256 hipRun = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(hx, hx), _mm256_mul_ps(hz, hz)));
+		__m256 cross = _mm256_sub_ps(_mm256_mul_ps(sx, hz), _mm256_mul_ps(sz, hx));
+		__m256 dot = _mm256_add_ps(_mm256_mul_ps(sx, hx), _mm256_mul_ps(sz, hz));
+
+		__m256 shoulderTilt = _mm256_mul_ps(atan2_ps(sy, shoulderRun), degrees);
+		__m256 hipTilt = _mm256_mul_ps(atan2_ps(hy, hipRun), degrees);
+		__m256 twist = _mm256_mul_ps(atan2_ps(cross, dot), degrees);
+		__m256 headOffset = _mm256_sub_ps(_mm256_loadu_ps(joints.x[head] + i), _mm256_loadu_ps(joints.x[base] + i));
+
+		__m256 shoulders = has_joints(mask, SHOULDERS);
+		__m256 hips = has_joints(mask, HIPS);
+		_mm256_storeu_ps(out.shoulderTilt + i, _mm256_blendv_ps(nan, shoulderTilt, shoulders));
+		_mm256_storeu_ps(out.hipTilt + i, _mm256_blendv_ps(nan, hipTilt, hips));
+		_mm256_storeu_ps(out.twist + i, _mm256_blendv_ps(nan, twist, _mm256_and_ps(shoulders, hips)));
+		_mm256_storeu_ps(out.headOffset + i, _mm256_blendv_ps(nan, headOffset, has_joints(mask, HEAD_AND_BASE)));
+	}
+
+	// Avoids the AVX to SSE transition penalty in the scalar code that follows
+	_mm256_zeroupper();
+	return i;
+}
@@ -0,0 +1,76 @@
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include <astra/astra.hpp>
+#include <math.h>
+
+// Unit quaternion w + xi + yj + zk; all NAN stands for a missing rotation
+struct Quaternion
+{
+	float w;
+	float x;
+	float y;
+	float z;
+};
+
+const Quaternion MISSING_ROTATION = { NAN, NAN, NAN, NAN };
+
+inline bool rotation_valid(const Quaternion& q)
+{
+	return !isnan(q.w);
+}
+
+inline Quaternion conjugate(const Quaternion& q)
+{
+	return { q.w, -q.x, -q.y, -q.z };
+}
+
+inline Quaternion operator*(const Quaternion& a, const Quaternion& b)
+{
+	return {
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+	};
+}
+
+// Rotation of a matrix whose columns are the rotated x, y and z axes, using the
+// largest of w, x, y, z as pivot so the result stays accurate near 180 degrees.
+// Matrices that are not close to a rotation give MISSING_ROTATION; the SDK
+// leaves joints it has no orientation for at zero or identity.
+inline Quaternion quaternion_from_matrix(const astra::Matrix3x3& m)
+{
+	float det = m.m00() * (m.m11() * m.m22() - m.m12() * m.m21())
+		- m.m01() * (m.m10() * m.m22() - m.m12() * m.m20())
+		+ m.m02() * (m.m10() * m.m21() - m.m11() * m.m20());
+	if (!(fabsf(det - 1.0f) < 0.1f))
+		return MISSING_ROTATION;
+
+	Quaternion q;
+	float trace = m.m00() + m.m11() + m.m22();
+	if (trace > 0) {
+		float s = 2.0f * sqrtf(trace + 1.0f);
+		q = { 0.25f * s, (m.m21() - m.m12()) / s, (m.m02() - m.m20()) / s, (m.m10() - m.m01()) / s };
+	}
+	else if (m.m00() > m.m11() && m.m00() > m.m22()) {
+		float s = 2.0f * sqrtf(1.0f + m.m00() - m.m11() - m.m22());
+		q = { (m.m21() - m.m12()) / s, 0.25f * s, (m.m01() + m.m10()) / s, (m.m02() + m.m20()) / s };
+	}
+	else if (m.m11() > m.m22()) {
+		float s = 2.0f * sqrtf(1.0f + m.m11() - m.m00() - m.m22());
+		q = { (m.m02() - m.m20()) / s, (m.m01() + m.m10()) / s, 0.25f * s, (m.m12() + m.m21()) / s };
+	}
+	else {
+		float s = 2.0f * sqrtf(1.0f + m.m22() - m.m00() - m.m11());
+		q = { (m.m10() - m.m01()) / s, (m.m02() + m.m20()) / s, (m.m12() + m.m21()) / s, 0.25f * s };
+	}
+
+	// Keeps w non-negative so the same rotation always has the same encoding
+	float norm = sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+	if (q.w < 0)
+		norm = -norm;
+	return { q.w / norm, q.x / norm, q.y / norm, q.z / norm };
+}
+
+#endif /* QUATERNION_H */
@@ -0,0 +1,35 @@
+#include "RecordingSink.h"
+#include "FrameEncoder.h"
+
+RecordingSink::RecordingSink(astra::serialization::FrameOutputStream& stream, int fps)
+	: stream_(stream)
+{
+	astra::serialization::StreamHeader header;
+	header.frameType = ASTRA_STREAM_BODY;
+	stream_.stage_stream_header(header);
+	stream_.write_stream_header();
+
+	description_.framePeriod = 1.0 / fps;
+	description_.bufferLength = 0;
+	buffer_.reserve(ASTRA_MAX_BODIES * BINARY_RECORD_SIZE);
+}
+
+void RecordingSink::consume(const FrameRecord& record)
+{
+	buffer_.clear();
+	encode_binary(record, buffer_);
+
+	// Play back at the pace the frames actually arrived
+	if (record.elapsedMs > 0)
+		description_.framePeriod = record.elapsedMs / 1000.0;
+	description_.bufferLength = static_cast<int>(buffer_.size());
+
+	frame_.byteLength = static_cast<int>(buffer_.size());
+	frame_.frameIndex = static_cast<int>(record.frameNumber);
+	frame_.rawFrameWrapper = buffer_.data();
+
+	stream_.stage_frame_description(description_);
+	stream_.write_frame_description();
+	stream_.stage_frame(frame_);
+	stream_.write_frame();
+}
@@ -0,0 +1,23 @@
+#ifndef RECORDINGSINK_H
+#define RECORDINGSINK_H
+
+#include "FrameSink.h"
+#include <common/serialization/FrameOutputStream.h>
+#include <vector>
+
+// Records body frames as binary records so --replay can feed them back later
+class RecordingSink : public FrameSink
+{
+public:
+	RecordingSink(astra::serialization::FrameOutputStream& stream, int fps);
+
+	virtual void consume(const FrameRecord& record) override;
+
+private:
+	astra::serialization::FrameOutputStream& stream_;
+	astra::serialization::FrameDescription description_;
+	astra::serialization::Frame frame_;
+	std::vector<char> buffer_;
+};
+
+#endif /* RECORDINGSINK_H */
@@ -0,0 +1,44 @@
+#ifndef RUNNINGSTATS_H
+#define RUNNINGSTATS_H
+
+#include <cstdint>
+#include <math.h>
+
+// Count, mean, variance, min and max of a stream of values in constant space.
+// The mean and variance use Welford's update, which stays accurate over long
+// sessions where a plain sum of squares would lose precision.
+struct RunningStats
+{
+	uint64_t count;
+	double mean;
+	double m2;
+	double min;
+	double max;
+
+	void reset()
+	{
+		count = 0;
+		mean = 0;
+		m2 = 0;
+		min = INFINITY;
+		max = -INFINITY;
+	}
+
+	void add(double value)
+	{
+		count++;
+		double delta = value - mean;
+		mean += delta / count;
+		m2 += delta * (value - mean);
+		if (value < min)
+			min = value;
+		if (value > max)
+			max = value;
+	}
+
+	// Sample variance, NAN with fewer than two values
+	double variance() const { return count > 1 ? m2 / (count - 1) : NAN; }
+	double stddev() const { return sqrt(variance()); }
+};
+
+#endif /* RUNNINGSTATS_H */
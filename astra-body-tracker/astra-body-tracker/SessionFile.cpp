@@ -0,0 +1,486 @@
+#include "SessionFile.h"
+#include "FrameEncoder.h"
+#include "JointSchema.h"
+#include "OrientationMetrics.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <math.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert((6 + SECTION_COUNT) * 4 <= SESSION_HEADER_SIZE, "section table must fit the header");
+
+void SessionColumns::add_row(uint32_t frame, uint32_t time, double timestamp, const BodyRecord& body)
+{
+	if (frameNumber.empty() || frameNumber.back() != frame)
+		frameOffsets.push_back(static_cast<uint32_t>(frameNumber.size()));
+
+	frameNumber.push_back(frame);
+	timeMs.push_back(time);
+	timestampUs.push_back(timestamp);
+	bodyId.push_back(body.id);
+	jointMask.push_back(body.jointMask);
+	for (int j = 0; j < ASTRA_MAX_JOINTS; j++) {
+		joints[j * 3 + 0].push_back(body.joints[j][0]);
+		joints[j * 3 + 1].push_back(body.joints[j][1]);
+		joints[j * 3 + 2].push_back(body.joints[j][2]);
+	}
+	shoulderAngle.push_back(body.shoulderAngle);
+	hipAngle.push_back(body.hipAngle);
+}
+
+template<typename T>
+static char* put(char* p, const T& value)
+{
+	memcpy(p, &value, sizeof(value));
+	return p + sizeof(value);
+}
+
+template<typename T>
+static const char* get(const char* p, T& value)
+{
+	memcpy(&value, p, sizeof(value));
+	return p + sizeof(value);
+}
+
+// Appends row r of columns in the journal layout
+static void append_journal_row(std::vector<char>& out, const SessionColumns& columns, size_t r)
+{
+	size_t offset = out.size();
+	out.resize(offset + SESSION_JOURNAL_ROW_SIZE);
+
+	char* p = &out[offset];
+	p = put(p, columns.frameNumber[r]);
+	p = put(p, columns.timeMs[r]);
+	p = put(p, columns.timestampUs[r]);
+	p = put(p, static_cast<uint32_t>(columns.bodyId[r]));
+	p = put(p, columns.jointMask[r]);
+	for (const std::vector<float>& column : columns.joints)
+		p = put(p, column[r]);
+	p = put(p, columns.shoulderAngle[r]);
+	put(p, columns.hipAngle[r]);
+}
+
+SessionFileSink::~SessionFileSink()
+{
+	close();
+}
+
+bool SessionFileSink::open_journal(const std::string& path)
+{
+	if (journal_)
+		fclose(journal_);
+	journal_ = fopen(path.c_str(), "wb");
+	if (!journal_)
+		return false;
+
+	journalRows_.reserve(64 * ASTRA_MAX_BODIES * SESSION_JOURNAL_ROW_SIZE);
+	journalRows_.resize(8);
+	char* p = put(&journalRows_[0], SESSION_JOURNAL_MAGIC);
+	put(p, static_cast<uint32_t>(ASTRA_MAX_JOINTS));
+	flush();
+	return journal_ != nullptr;
+}
+
+bool SessionFileSink::open_summaries(const std::string& path)
+{
+	if (summaries_)
+		fclose(summaries_);
+	summaries_ = fopen(path.c_str(), "wb");
+	summaryLines_.clear();
+	return summaries_ != nullptr;
+}
+
+void SessionFileSink::close()
+{
+	flush();
+	if (journal_)
+		fclose(journal_);
+	if (summaries_)
+		fclose(summaries_);
+	journal_ = nullptr;
+	summaries_ = nullptr;
+}
+
+void SessionFileSink::consume(const FrameRecord& record)
+{
+	// Mirrors encode_json, which writes one line per body with joints
+	for (uint32_t i = 0; i < record.bodyCount; i++) {
+		const BodyRecord& body = record.bodies[i];
+		if (!body.jointsEnabled)
+			continue;
+		columns_.add_row(record.frameNumber, record.elapsedMs, static_cast<double>(record.timestampUs), body);
+		if (journal_)
+			append_journal_row(journalRows_, columns_, columns_.rows() - 1);
+	}
+}
+
+void SessionFileSink::consume_summary(const BodySummary& summary)
+{
+	if (summaries_)
+		encode_summary_json(summary, summaryLines_);
+}
+
+void SessionFileSink::flush()
+{
+	if (summaries_ && !summaryLines_.empty()) {
+		// Only the results screen reads these, so a failed write just loses them
+		fwrite(summaryLines_.data(), 1, summaryLines_.size(), summaries_);
+		fflush(summaries_);
+		summaryLines_.clear();
+	}
+
+	if (!journal_ || journalRows_.empty())
+		return;
+
+	// Handed to the OS every batch, which is all a crash of the tracker needs
+	bool written = fwrite(journalRows_.data(), 1, journalRows_.size(), journal_) == journalRows_.size();
+	journalRows_.clear();
+	if (!written || fflush(journal_) != 0) {
+		// The session file is still written at exit from the rows in memory
+		fclose(journal_);
+		journal_ = nullptr;
+		journalFailed_ = true;
+	}
+}
+
+std::string patient_file(const std::string& patientDir, const char* name)
+{
+	if (patientDir.empty())
+		return name;
+
+	char last = patientDir.back();
+	if (last == '/' || last == '\\')
+		return patientDir + name;
+	return patientDir + "/" + name;
+}
+
+static size_t padded(size_t bytes)
+{
+	return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+// Byte size of every section for n rows and f frames, before padding
+static void section_sizes(size_t n, size_t f, size_t sizes[SECTION_COUNT])
+{
+	sizes[SECTION_FRAME_NUMBER] = n * sizeof(uint32_t);
+	sizes[SECTION_TIME_MS] = n * sizeof(uint32_t);
+	sizes[SECTION_TIMESTAMP_US] = n * sizeof(double);
+	sizes[SECTION_BODY_ID] = n * sizeof(uint8_t);
+	sizes[SECTION_JOINT_MASK] = n * sizeof(uint32_t);
+	sizes[SECTION_JOINTS] = n * ASTRA_MAX_JOINTS * 3 * sizeof(float);
+	sizes[SECTION_SHOULDER_ANGLE] = n * sizeof(float);
+	sizes[SECTION_HIP_ANGLE] = n * sizeof(float);
+	sizes[SECTION_FRAME_OFFSETS] = (f + 1) * sizeof(uint32_t);
+}
+
+struct SessionWriter
+{
+	FILE* file;
+	bool ok;
+	size_t written;
+
+	void write(const void* data, size_t bytes)
+	{
+		if (ok && bytes > 0 && fwrite(data, 1, bytes, file) != bytes)
+			ok = false;
+		written += bytes;
+	}
+
+	void pad()
+	{
+		static const char zeros[8] = { 0 };
+		write(zeros, padded(written) - written);
+	}
+};
+
+bool write_session_file(const std::string& path, const SessionColumns& columns)
+{
+	size_t n = columns.rows();
+	size_t f = columns.frameOffsets.size();
+
+	size_t sizes[SECTION_COUNT];
+	section_sizes(n, f, sizes);
+
+	uint32_t header[SESSION_HEADER_SIZE / 4] = { 0 };
+	memcpy(&header[0], SESSION_FILE_MAGIC, sizeof(SESSION_FILE_MAGIC));
+	header[1] = SESSION_FILE_VERSION;
+	header[2] = static_cast<uint32_t>(n);
+	header[3] = static_cast<uint32_t>(f);
+	header[4] = ASTRA_MAX_JOINTS;
+	header[5] = SECTION_COUNT;
+	size_t offset = SESSION_HEADER_SIZE;
+	for (int s = 0; s < SECTION_COUNT; s++) {
+		header[6 + s] = static_cast<uint32_t>(offset);
+		offset += padded(sizes[s]);
+	}
+
+	// Written to a temporary name first so a reader never maps half a file
+	std::string temporary = path + ".tmp";
+	SessionWriter out = { fopen(temporary.c_str(), "wb"), true, 0 };
+	if (!out.file)
+		return false;
+
+	out.write(header, sizeof(header));
+	out.write(columns.frameNumber.data(), sizes[SECTION_FRAME_NUMBER]);
+	out.pad();
+	out.write(columns.timeMs.data(), sizes[SECTION_TIME_MS]);
+	out.pad();
+	out.write(columns.timestampUs.data(), sizes[SECTION_TIMESTAMP_US]);
+	out.pad();
+	out.write(columns.bodyId.data(), sizes[SECTION_BODY_ID]);
+	out.pad();
+	out.write(columns.jointMask.data(), sizes[SECTION_JOINT_MASK]);
+	out.pad();
+	for (const std::vector<float>& column : columns.joints)
+		out.write(column.data(), n * sizeof(float));
+	out.pad();
+	out.write(columns.shoulderAngle.data(), sizes[SECTION_SHOULDER_ANGLE]);
+	out.pad();
+	out.write(columns.hipAngle.data(), sizes[SECTION_HIP_ANGLE]);
+	out.pad();
+	out.write(columns.frameOffsets.data(), f * sizeof(uint32_t));
+	uint32_t end = static_cast<uint32_t>(n);
+	out.write(&end, sizeof(end));
+	out.pad();
+
+	if (fclose(out.file) != 0)
+		out.ok = false;
+
+	remove(path.c_str());
+	if (!out.ok || rename(temporary.c_str(), path.c_str()) != 0) {
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Number after "key" on a JSON line, searching from pos; NAN when missing or null
+static double json_number(const std::string& line, const char* key, size_t pos = 0)
+{
+	pos = line.find(key, pos);
+	if (pos == std::string::npos)
+		return NAN;
+
+	const char* p = line.c_str() + pos + strlen(key);
+	while (*p == ' ' || *p == ':')
+		p++;
+
+	char* end;
+	double value = strtod(p, &end);
+	return end == p ? NAN : value;
+}
+
+bool read_raw_data(const std::string& path, SessionColumns& columns)
+{
+	std::ifstream in(path);
+	if (!in)
+		return false;
+
+	// The Electron app writes JSON.stringify output, so keys have no spaces around them
+	std::string jointKeys[ASTRA_MAX_JOINTS];
+	for (int j = 0; j < ASTRA_MAX_JOINTS; j++)
+		jointKeys[j] = std::string("\"") + JOINT_SCHEMA[j].name + "\":{";
+
+	double timestampUs = 0;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || line.find("\"summary\"") != std::string::npos)
+			continue;
+
+		// A line cut short, such as the last one of a killed capture, is skipped,
+		// and so is one missing a key. The negated comparisons also reject NaN,
+		// which cannot be cast.
+		size_t last = line.find_last_not_of(" \r");
+		if (last == std::string::npos || line[last] != '}')
+			continue;
+		double id = json_number(line, "\"body_id\"");
+		double frame = json_number(line, "\"frame_number\"");
+		double time = json_number(line, "\"time\"");
+		if (!(id >= 0 && id <= UINT8_MAX) || !(frame >= 0 && frame <= UINT32_MAX) ||
+			!(time >= 0 && time <= UINT32_MAX))
+			continue;
+
+		BodyRecord body;
+		memset(&body, 0, sizeof(body));
+		body.jointsEnabled = true;
+		clear_orientations(body);
+		body.id = static_cast<uint8_t>(id);
+		body.shoulderAngle = static_cast<float>(json_number(line, "\"shoulder_angle\""));
+		body.hipAngle = static_cast<float>(json_number(line, "\"hip_angle\""));
+
+		size_t jointsStart = line.find("\"joints\"");
+		for (int j = 0; jointsStart != std::string::npos && j < ASTRA_MAX_JOINTS; j++) {
+			size_t pos = line.find(jointKeys[j], jointsStart);
+			if (pos == std::string::npos)
+				continue;
+			double x = json_number(line, "\"x\"", pos);
+			double y = json_number(line, "\"y\"", pos);
+			double z = json_number(line, "\"z\"", pos);
+			if (!isfinite(x) || !isfinite(y) || !isfinite(z))
+				continue;
+			body.joints[j][0] = static_cast<float>(x);
+			body.joints[j][1] = static_cast<float>(y);
+			body.joints[j][2] = static_cast<float>(z);
+			body.jointMask |= 1u << j;
+		}
+
+		uint32_t frameNumber = static_cast<uint32_t>(frame);
+		uint32_t timeMs = static_cast<uint32_t>(time);
+		if (columns.frameNumber.empty() || columns.frameNumber.back() != frameNumber)
+			timestampUs += timeMs * 1000.0;
+		columns.add_row(frameNumber, timeMs, timestampUs, body);
+	}
+	return true;
+}
+
+bool read_session_journal(const std::string& path, SessionColumns& columns)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	char header[8];
+	uint32_t jointCount = 0;
+	bool ok = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+		memcmp(header, SESSION_JOURNAL_MAGIC, sizeof(SESSION_JOURNAL_MAGIC)) == 0;
+	if (ok)
+		get(header + 4, jointCount);
+	ok = ok && jointCount == ASTRA_MAX_JOINTS;
+
+	char row[SESSION_JOURNAL_ROW_SIZE];
+	while (ok && fread(row, 1, sizeof(row), file) == sizeof(row)) {
+		BodyRecord body;
+		memset(&body, 0, sizeof(body));
+		body.jointsEnabled = true;
+		clear_orientations(body);
+
+		uint32_t frame, time, id;
+		double timestampUs;
+		const char* p = row;
+		p = get(p, frame);
+		p = get(p, time);
+		p = get(p, timestampUs);
+		p = get(p, id);
+		p = get(p, body.jointMask);
+		for (int j = 0; j < ASTRA_MAX_JOINTS; j++) {
+			for (int axis = 0; axis < 3; axis++)
+				p = get(p, body.joints[j][axis]);
+		}
+		p = get(p, body.shoulderAngle);
+		get(p, body.hipAngle);
+		body.id = static_cast<uint8_t>(id);
+
+		columns.add_row(frame, time, timestampUs, body);
+	}
+
+	fclose(file);
+	return ok;
+}
+
+MappedSession::~MappedSession()
+{
+	close();
+}
+
+bool MappedSession::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	file_ = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart < SESSION_HEADER_SIZE) {
+		close();
+		return false;
+	}
+	size_ = static_cast<size_t>(size.QuadPart);
+
+	mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_) {
+		close();
+		return false;
+	}
+	data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < SESSION_HEADER_SIZE) {
+		::close(fd);
+		return false;
+	}
+	size_ = static_cast<size_t>(st.st_size);
+
+	void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	data_ = data == MAP_FAILED ? nullptr : static_cast<const char*>(data);
+#endif
+
+	if (!data_ || !validate()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedSession::close()
+{
+#ifdef _WIN32
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_)
+		CloseHandle(mapping_);
+	if (file_)
+		CloseHandle(file_);
+	mapping_ = nullptr;
+	file_ = nullptr;
+#else
+	if (data_)
+		munmap(const_cast<char*>(data_), size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+	rows_ = 0;
+	frames_ = 0;
+}
+
+bool MappedSession::validate()
+{
+	uint32_t header[SESSION_HEADER_SIZE / 4];
+	memcpy(header, data_, sizeof(header));
+
+	if (memcmp(data_, SESSION_FILE_MAGIC, sizeof(SESSION_FILE_MAGIC)) != 0 ||
+		header[1] != SESSION_FILE_VERSION ||
+		header[4] != ASTRA_MAX_JOINTS ||
+		header[5] != SECTION_COUNT)
+		return false;
+
+	rows_ = header[2];
+	frames_ = header[3];
+
+	size_t sizes[SECTION_COUNT];
+	section_sizes(rows_, frames_, sizes);
+	for (int s = 0; s < SECTION_COUNT; s++) {
+		offsets_[s] = header[6 + s];
+		if (offsets_[s] % 8 != 0 || offsets_[s] > size_ || sizes[s] > size_ - offsets_[s])
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,196 @@
+#ifndef SESSIONFILE_H
+#define SESSIONFILE_H
+
+#include "FrameSink.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+	Columnar session file, written into the patient directory when a capture
+	ends (see the session journal below for one that does not) and laid out
+	so it can be used straight from a memory mapping. There is one row per
+	complete body line of raw_data.txt, in the same order, so row i is also
+	entry i of the session index. All fields are little-endian.
+
+	header      char[4] "ASES", uint32 version, uint32 rowCount n,
+	            uint32 frameCount f, uint32 jointCount, uint32 sectionCount,
+	            uint32 sectionOffset[sectionCount] in SessionSection order,
+	            zero padded to SESSION_HEADER_SIZE
+	sections, each starting on an 8-byte boundary:
+	frameNumber     uint32[n]
+	timeMs          uint32[n], milliseconds since the previous frame ("time")
+	timestampUs     float64[n], microseconds since the capture started
+	bodyId          uint8[n]
+	jointMask       uint32[n], bit j set when joint j (astra::JointType) is valid
+	joints          float32[jointCount * 3][n], one column per joint axis:
+	                column (j * 3 + axis) holds x, y or z of joint j in mm
+	shoulderAngle   float32[n], NaN when missing
+	hipAngle        float32[n], NaN when missing
+	frameOffsets    uint32[f + 1], frame k owns rows frameOffsets[k] .. frameOffsets[k + 1] - 1
+*/
+const char SESSION_FILE_MAGIC[4] = { 'A', 'S', 'E', 'S' };
+const uint32_t SESSION_FILE_VERSION = 1;
+const uint32_t SESSION_HEADER_SIZE = 64;
+
+const char* const SESSION_FILE = "session.col";
+
+/*
+	Journal of the rows appended while a capture runs, so a crash, a forced
+	kill or a slow shutdown loses at most the batch being written. A clean exit
+	writes the session file and removes the journal; --convert rebuilds the
+	session file from a journal left behind. Little-endian:
+
+	header      char[4] "ASRJ", uint32 jointCount
+	rows        SESSION_JOURNAL_ROW_SIZE bytes each:
+	            uint32 frameNumber, uint32 timeMs, float64 timestampUs,
+	            uint32 bodyId, uint32 jointMask, float32 joints[jointCount * 3],
+	            float32 shoulderAngle, float32 hipAngle
+
+	A row cut short by the crash is ignored.
+*/
+const char SESSION_JOURNAL_MAGIC[4] = { 'A', 'S', 'R', 'J' };
+const size_t SESSION_JOURNAL_ROW_SIZE = 24 + ASTRA_MAX_JOINTS * 3 * sizeof(float) + 8;
+
+const char* const SESSION_JOURNAL_FILE = "session.rows";
+
+// Shoulder angle summaries of the session as JSON lines, the same lines the
+// tracker writes to stdout; the last one of every body covers the whole session
+const char* const SESSION_SUMMARY_FILE = "summaries.txt";
+
+enum SessionSection
+{
+	SECTION_FRAME_NUMBER,
+	SECTION_TIME_MS,
+	SECTION_TIMESTAMP_US,
+	SECTION_BODY_ID,
+	SECTION_JOINT_MASK,
+	SECTION_JOINTS,
+	SECTION_SHOULDER_ANGLE,
+	SECTION_HIP_ANGLE,
+	SECTION_FRAME_OFFSETS,
+	SECTION_COUNT
+};
+
+// The session held in memory while it is captured or converted
+struct SessionColumns
+{
+	std::vector<uint32_t> frameNumber;
+	std::vector<uint32_t> timeMs;
+	std::vector<double> timestampUs;
+	std::vector<uint8_t> bodyId;
+	std::vector<uint32_t> jointMask;
+	std::vector<float> joints[ASTRA_MAX_JOINTS * 3];
+	std::vector<float> shoulderAngle;
+	std::vector<float> hipAngle;
+
+	// First row of every frame; the closing offset is added when the file is written
+	std::vector<uint32_t> frameOffsets;
+
+	size_t rows() const { return frameNumber.size(); }
+
+	void add_row(uint32_t frame, uint32_t time, double timestamp, const BodyRecord& body);
+};
+
+// Collects the rows as frames are written, one per JSON frame line, and
+// appends them to the session journal at the end of every batch. Summaries
+// are appended to the summary file the same way.
+class SessionFileSink : public FrameSink
+{
+public:
+	~SessionFileSink();
+
+	// Both truncate any file left at path
+	bool open_journal(const std::string& path);
+	bool open_summaries(const std::string& path);
+
+	// Writes what is pending and closes both files
+	void close();
+
+	virtual void consume(const FrameRecord& record) override;
+	virtual void consume_summary(const BodySummary& summary) override;
+	virtual void flush() override;
+
+	const SessionColumns& columns() const { return columns_; }
+
+	// Set when a write failed and the journal was closed
+	bool journal_failed() const { return journalFailed_; }
+
+private:
+	SessionColumns columns_;
+
+	FILE* journal_ = nullptr;
+	std::vector<char> journalRows_;
+	bool journalFailed_ = false;
+
+	FILE* summaries_ = nullptr;
+	std::vector<char> summaryLines_;
+};
+
+// Joins a file name onto the patient directory passed by the Electron app
+std::string patient_file(const std::string& patientDir, const char* name);
+
+bool write_session_file(const std::string& path, const SessionColumns& columns);
+
+// Converts a raw_data.txt written by the Electron app. Lines cut short or
+// without a valid body_id, frame_number or time are skipped, and so are joints
+// without x, y and z.
+bool read_raw_data(const std::string& path, SessionColumns& columns);
+
+// Reads back the journal of a capture that did not write its session file
+bool read_session_journal(const std::string& path, SessionColumns& columns);
+
+// Read-only view of a session file mapped into memory. Nothing is parsed or
+// copied: the accessors point into the mapping and stay valid until close().
+class MappedSession
+{
+public:
+	MappedSession() { }
+	~MappedSession();
+
+	MappedSession(const MappedSession&) = delete;
+	MappedSession& operator=(const MappedSession&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	uint32_t rows() const { return rows_; }
+	uint32_t frames() const { return frames_; }
+
+	const uint32_t* frame_numbers() const { return section<uint32_t>(SECTION_FRAME_NUMBER); }
+	const uint32_t* time_ms() const { return section<uint32_t>(SECTION_TIME_MS); }
+	const double* timestamps_us() const { return section<double>(SECTION_TIMESTAMP_US); }
+	const uint8_t* body_ids() const { return section<uint8_t>(SECTION_BODY_ID); }
+	const uint32_t* joint_masks() const { return section<uint32_t>(SECTION_JOINT_MASK); }
+	const float* shoulder_angles() const { return section<float>(SECTION_SHOULDER_ANGLE); }
+	const float* hip_angles() const { return section<float>(SECTION_HIP_ANGLE); }
+	const uint32_t* frame_offsets() const { return section<uint32_t>(SECTION_FRAME_OFFSETS); }
+
+	// axis 0, 1, 2 for x, y, z
+	const float* joint_axis(int joint, int axis) const
+	{
+		return section<float>(SECTION_JOINTS) + static_cast<size_t>(joint * 3 + axis) * rows_;
+	}
+
+private:
+	template<typename T>
+	const T* section(SessionSection s) const
+	{
+		return reinterpret_cast<const T*>(data_ + offsets_[s]);
+	}
+
+	bool validate();
+
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+	uint32_t rows_ = 0;
+	uint32_t frames_ = 0;
+	uint32_t offsets_[SECTION_COUNT];
+
+#ifdef _WIN32
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+#endif
+};
+
+#endif /* SESSIONFILE_H */
@@ -0,0 +1,130 @@
+#include "SessionIndex.h"
+#include <cstdio>
+#include <cstring>
+#include <math.h>
+#include <vector>
+
+struct IndexWriter
+{
+	FILE* file;
+	bool ok;
+
+	void write(const void* data, size_t size, size_t count)
+	{
+		if (ok && count > 0 && fwrite(data, size, count, file) != count)
+			ok = false;
+	}
+
+	void pad(size_t written)
+	{
+		static const char zeros[8] = { 0 };
+		if (written % 8 != 0)
+			write(zeros, 1, 8 - written % 8);
+	}
+};
+
+static void write_series(IndexWriter& out, const char* name, const float* values, size_t n,
+	uint32_t blockCount, uint32_t levelCount)
+{
+	char paddedName[SESSION_INDEX_NAME_SIZE] = { 0 };
+	strncpy(paddedName, name, SESSION_INDEX_NAME_SIZE - 1);
+	out.write(paddedName, 1, sizeof(paddedName));
+
+	double offset = 0;
+	size_t valid = 0;
+	for (size_t i = 0; i < n; i++) {
+		float v = values[i];
+		if (!isnan(v)) {
+			offset += v;
+			valid++;
+		}
+	}
+	offset = valid ? offset / valid : 0;
+	out.write(&offset, sizeof(offset), 1);
+
+	std::vector<double> count(n + 1), sum(n + 1), sumSquares(n + 1);
+	count[0] = sum[0] = sumSquares[0] = 0;
+	for (size_t i = 0; i < n; i++) {
+		double d = isnan(values[i]) ? 0 : values[i] - offset;
+		count[i + 1] = count[i] + (isnan(values[i]) ? 0 : 1);
+		sum[i + 1] = sum[i] + d;
+		sumSquares[i + 1] = sumSquares[i] + d * d;
+	}
+	out.write(count.data(), sizeof(double), n + 1);
+	out.write(sum.data(), sizeof(double), n + 1);
+	out.write(sumSquares.data(), sizeof(double), n + 1);
+
+	out.write(values, sizeof(float), n);
+	out.pad(n * sizeof(float));
+
+	std::vector<float> blockMin(static_cast<size_t>(levelCount) * blockCount, INFINITY);
+	std::vector<float> blockMax(static_cast<size_t>(levelCount) * blockCount, -INFINITY);
+	for (size_t i = 0; i < n; i++) {
+		if (isnan(values[i]))
+			continue;
+		size_t block = i / SESSION_INDEX_BLOCK_SIZE;
+		if (values[i] < blockMin[block])
+			blockMin[block] = values[i];
+		if (values[i] > blockMax[block])
+			blockMax[block] = values[i];
+	}
+	for (uint32_t k = 1; k < levelCount; k++) {
+		size_t half = size_t(1) << (k - 1);
+		float* minRow = &blockMin[k * blockCount];
+		float* maxRow = &blockMax[k * blockCount];
+		const float* minPrev = minRow - blockCount;
+		const float* maxPrev = maxRow - blockCount;
+		for (size_t j = 0; j + 2 * half <= blockCount; j++) {
+			minRow[j] = minPrev[j] < minPrev[j + half] ? minPrev[j] : minPrev[j + half];
+			maxRow[j] = maxPrev[j] > maxPrev[j + half] ? maxPrev[j] : maxPrev[j + half];
+		}
+	}
+	size_t tableSize = static_cast<size_t>(levelCount) * blockCount;
+	out.write(blockMin.data(), sizeof(float), tableSize);
+	out.pad(tableSize * sizeof(float));
+	out.write(blockMax.data(), sizeof(float), tableSize);
+	out.pad(tableSize * sizeof(float));
+}
+
+bool write_session_index(const std::string& path, const float* shoulderAngle, const float* hipAngle, size_t count)
+{
+	std::vector<float> absShoulder(count), absHip(count);
+	for (size_t i = 0; i < count; i++) {
+		absShoulder[i] = fabsf(shoulderAngle[i]);
+		absHip[i] = fabsf(hipAngle[i]);
+	}
+
+	uint32_t frameCount = static_cast<uint32_t>(count);
+	uint32_t blockCount = (frameCount + SESSION_INDEX_BLOCK_SIZE - 1) / SESSION_INDEX_BLOCK_SIZE;
+	uint32_t levelCount = 0;
+	while ((uint64_t(1) << levelCount) <= blockCount)
+		levelCount++;
+
+	// Written to a temporary name first so a reader never sees half an index
+	std::string temporary = path + ".tmp";
+	IndexWriter out = { fopen(temporary.c_str(), "wb"), true };
+	if (!out.file)
+		return false;
+
+	uint32_t header[8] = {
+		0, SESSION_INDEX_VERSION, frameCount, 4,
+		SESSION_INDEX_BLOCK_SIZE, blockCount, levelCount, 0
+	};
+	memcpy(&header[0], SESSION_INDEX_MAGIC, sizeof(SESSION_INDEX_MAGIC));
+	out.write(header, sizeof(uint32_t), 8);
+
+	write_series(out, "shoulder_angle", shoulderAngle, count, blockCount, levelCount);
+	write_series(out, "abs_shoulder_angle", absShoulder.data(), count, blockCount, levelCount);
+	write_series(out, "hip_angle", hipAngle, count, blockCount, levelCount);
+	write_series(out, "abs_hip_angle", absHip.data(), count, blockCount, levelCount);
+
+	if (fclose(out.file) != 0)
+		out.ok = false;
+
+	remove(path.c_str());
+	if (!out.ok || rename(temporary.c_str(), path.c_str()) != 0) {
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,47 @@
+#ifndef SESSIONINDEX_H
+#define SESSIONINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+	Sidecar index over the angle series of a session, written next to
+	raw_data.txt so the results screen can answer range queries without
+	scanning frames. Entry i of every series belongs to line i of raw_data.txt,
+	counting complete frame lines only. All fields are little-endian and every
+	section starts on an 8-byte boundary. Rows line up with those of the
+	session file.
+
+	header      char[4] "AIDX", uint32 version, uint32 frameCount n,
+	            uint32 seriesCount, uint32 blockSize B, uint32 blockCount m,
+	            uint32 levelCount L, uint32 reserved
+	per series:
+	name        char[32], NUL padded
+	offset      float64 subtracted from every value before summing, which keeps
+	            sum-of-squares variances well conditioned
+	prefixes    float64 count[n + 1], sum[n + 1], sumSquares[n + 1] over the
+	            values that are not NaN, so a range [a, b] is prefix[b + 1] - prefix[a]
+	values      float32[n], NaN where the angle was missing, padded to 8 bytes
+	blockMin    float32[L][m] sparse table over per-block minimums: entry [k][j]
+	            covers blocks j .. j + 2^k - 1, padded to 8 bytes
+	blockMax    float32[L][m] the same for maximums, padded to 8 bytes
+
+	A min/max query takes two sparse table lookups for the whole blocks inside
+	the range plus at most 2B values at its ends. Tables over single frames
+	would need n log n entries, hundreds of megabytes for a long session.
+*/
+const char SESSION_INDEX_MAGIC[4] = { 'A', 'I', 'D', 'X' };
+const uint32_t SESSION_INDEX_VERSION = 1;
+const uint32_t SESSION_INDEX_BLOCK_SIZE = 32;
+const size_t SESSION_INDEX_NAME_SIZE = 32;
+
+// File names inside the patient directory
+const char* const RAW_DATA_FILE = "raw_data.txt";
+const char* const SESSION_INDEX_FILE = "raw_data.idx";
+
+// Indexes shoulder_angle, abs_shoulder_angle, hip_angle and abs_hip_angle from
+// the count angles of each series, NAN where the angle was missing
+bool write_session_index(const std::string& path, const float* shoulderAngle, const float* hipAngle, size_t count);
+
+#endif /* SESSIONINDEX_H */
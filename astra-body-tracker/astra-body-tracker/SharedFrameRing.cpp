@@ -0,0 +1,207 @@
+#include "SharedFrameRing.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+// Local\ keeps the name inside the login session, so no privilege is needed
+static std::string segment_name(const std::string& name)
+{
+	return "Local\\" + name;
+}
+#else
+static std::string segment_name(const std::string& name)
+{
+	return "/" + name;
+}
+#endif
+
+SharedMemory::~SharedMemory()
+{
+	close();
+}
+
+bool SharedMemory::create(const std::string& name, size_t size)
+{
+	close();
+
+#ifdef _WIN32
+	// An existing mapping keeps the size it was created with, which
+	// MapViewOfFile then refuses to exceed
+	mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		0, static_cast<DWORD>(size), segment_name(name).c_str());
+	if (!mapping_)
+		return false;
+	data_ = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+	int fd = shm_open(segment_name(name).c_str(), O_CREAT | O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	data_ = data == MAP_FAILED ? nullptr : data;
+#endif
+
+	if (!data_) {
+		close();
+		return false;
+	}
+	size_ = size;
+	return true;
+}
+
+bool SharedMemory::open(const std::string& name)
+{
+	close();
+
+#ifdef _WIN32
+	mapping_ = OpenFileMappingA(FILE_MAP_READ, FALSE, segment_name(name).c_str());
+	if (!mapping_)
+		return false;
+	data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+
+	MEMORY_BASIC_INFORMATION info;
+	if (data_ && VirtualQuery(data_, &info, sizeof(info)) == sizeof(info))
+		size_ = info.RegionSize;
+#else
+	int fd = shm_open(segment_name(name).c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+	size_ = static_cast<size_t>(st.st_size);
+
+	void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	data_ = data == MAP_FAILED ? nullptr : data;
+#endif
+
+	if (!data_ || size_ == 0) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void SharedMemory::close()
+{
+#ifdef _WIN32
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_)
+		CloseHandle(mapping_);
+	mapping_ = nullptr;
+#else
+	// Not unlinked: the next tracker maps the same segment, so a reader that
+	// stays open follows it the way it does on Windows
+	if (data_)
+		munmap(data_, size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
+
+bool SharedFrameReader::open(const std::string& name)
+{
+	close();
+	if (!memory_.open(name))
+		return false;
+
+	const SharedRingHeader* header = static_cast<const SharedRingHeader*>(memory_.data());
+	if (memory_.size() < SHARED_RING_SIZE
+		|| memcmp(header->magic, SHARED_RING_MAGIC, sizeof(SHARED_RING_MAGIC)) != 0
+		|| header->version != SHARED_RING_VERSION
+		|| header->slotCount != SHARED_RING_SLOTS
+		|| header->slotSize != sizeof(SharedFrameSlot)) {
+		close();
+		return false;
+	}
+
+	header_ = header;
+	slots_ = reinterpret_cast<const SharedFrameSlot*>(header + 1);
+	return true;
+}
+
+void SharedFrameReader::close()
+{
+	memory_.close();
+	header_ = nullptr;
+	slots_ = nullptr;
+}
+
+uint64_t SharedFrameReader::published() const
+{
+	return header_ ? header_->published.load(std::memory_order_acquire) : 0;
+}
+
+uint32_t SharedFrameReader::session() const
+{
+	return header_ ? header_->session.load(std::memory_order_acquire) : 0;
+}
+
+const SharedFrame* SharedFrameReader::latest(SharedReadTicket& ticket) const
+{
+	if (!header_)
+		return nullptr;
+
+	for (int attempt = 0; attempt < 4; attempt++) {
+		uint64_t published = header_->published.load(std::memory_order_acquire);
+		if (published == 0)
+			return nullptr;
+
+		const SharedFrameSlot& slot = slots_[(published - 1) % SHARED_RING_SLOTS];
+		uint32_t version = slot.version.load(std::memory_order_acquire);
+
+		// Odd while the writer is inside the slot, which it only reaches
+		// again after a whole ring of newer frames
+		if ((version & 1) != 0 || slot.sequence.load(std::memory_order_relaxed) != published - 1)
+			continue;
+
+		ticket.slot = &slot;
+		ticket.version = version;
+		ticket.sequence = published - 1;
+		return &slot.frame;
+	}
+	return nullptr;
+}
+
+bool SharedFrameReader::still_valid(const SharedReadTicket& ticket) const
+{
+	// Orders the caller's reads of the frame before the second version check
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return ticket.slot->version.load(std::memory_order_relaxed) == ticket.version;
+}
+
+bool SharedFrameReader::copy_latest(SharedFrame& out, uint64_t* sequence) const
+{
+	for (int attempt = 0; attempt < 4; attempt++) {
+		SharedReadTicket ticket;
+		const SharedFrame* frame = latest(ticket);
+		if (!frame)
+			return false;
+
+		memcpy(&out, frame, sizeof(out));
+		if (still_valid(ticket)) {
+			if (sequence)
+				*sequence = ticket.sequence;
+			return true;
+		}
+	}
+	return false;
+}
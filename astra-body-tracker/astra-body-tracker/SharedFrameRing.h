@@ -0,0 +1,158 @@
+#ifndef SHAREDFRAMERING_H
+#define SHAREDFRAMERING_H
+
+#include <astra/capi/streams/body_types.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+	Frames shared with a viewer on the same machine through a named
+	shared-memory segment (a file mapping in the Local\ namespace on Windows,
+	a POSIX shared-memory object elsewhere), so nothing is encoded, piped or
+	parsed on the way.
+
+	The segment is a header followed by SHARED_RING_SLOTS slots. Frame n goes
+	to slot n % SHARED_RING_SLOTS and header.published becomes n + 1 once it is
+	complete. Every slot is a seqlock: the writer makes its version odd, fills
+	the slot and makes it even again, and a reader keeps what it read only if
+	the version was even and unchanged around the read. With one writer at
+	the frame rate, a reader has a whole ring of frames before the slot it
+	reads is reused, so retries are rare.
+
+	Everything is in the writer's native layout; both ends run on one machine
+	and are built from this header.
+*/
+const char SHARED_RING_MAGIC[4] = { 'A', 'S', 'H', 'R' };
+const uint32_t SHARED_RING_VERSION = 1;
+const uint32_t SHARED_RING_SLOTS = 8;
+const char* const SHARED_RING_DEFAULT_NAME = "astra-body-tracker";
+
+struct SharedBody
+{
+	uint8_t id;
+	uint8_t status;
+	uint16_t reserved;
+
+	// Bit n is set when joint n has a usable world position
+	uint32_t jointMask;
+	float joints[ASTRA_MAX_JOINTS][3];
+
+	// Degrees, NAN when unavailable
+	float shoulderAngle;
+	float hipAngle;
+};
+
+struct SharedFrame
+{
+	uint64_t timestampUs;
+	uint32_t frameNumber;
+
+	// 0 for replayed frames
+	uint32_t sensorFrameIndex;
+
+	uint32_t bodyCount;
+	uint32_t reserved;
+	SharedBody bodies[ASTRA_MAX_BODIES];
+};
+
+struct alignas(64) SharedFrameSlot
+{
+	std::atomic<uint32_t> version;
+	uint32_t reserved;
+	std::atomic<uint64_t> sequence;
+	SharedFrame frame;
+};
+
+struct alignas(64) SharedRingHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t slotSize;
+
+	// Changes whenever a tracker (re)initialises the segment
+	std::atomic<uint32_t> session;
+	uint32_t reserved;
+
+	// Frames written so far; the newest is published - 1
+	std::atomic<uint64_t> published;
+};
+
+const size_t SHARED_RING_SIZE = sizeof(SharedRingHeader) + SHARED_RING_SLOTS * sizeof(SharedFrameSlot);
+
+// Named segment mapped into this process, unmapped by close()
+class SharedMemory
+{
+public:
+	SharedMemory() = default;
+	~SharedMemory();
+
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	// Creates the segment, or maps an existing one of the same size left by
+	// an earlier tracker that a reader still holds open
+	bool create(const std::string& name, size_t size);
+
+	// Maps an existing segment read-only
+	bool open(const std::string& name);
+
+	void close();
+
+	void* data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	void* data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void* mapping_ = nullptr;
+#endif
+};
+
+// Where a reader found a frame, to check after reading it
+struct SharedReadTicket
+{
+	const SharedFrameSlot* slot;
+	uint32_t version;
+	uint64_t sequence;
+};
+
+/*
+	Reader side, with no dependencies beyond this header so a native Node
+	addon can build it on its own. Readers poll; nothing signals new frames.
+
+	latest() points straight into the segment. The frame may be overwritten
+	while the caller reads it, so whatever was read only counts if
+	still_valid() returns true afterwards. copy_latest() does the same into a
+	copy and retries a few times until the copy is consistent.
+*/
+class SharedFrameReader
+{
+public:
+	// Returns false until a tracker has created the segment
+	bool open(const std::string& name = SHARED_RING_DEFAULT_NAME);
+	void close();
+	bool is_open() const { return header_ != nullptr; }
+
+	// Frames written by the current tracker so far, and a number that changes
+	// when another tracker takes the segment over
+	uint64_t published() const;
+	uint32_t session() const;
+
+	// The newest frame, or nullptr when there is none or the writer kept
+	// overtaking the reader
+	const SharedFrame* latest(SharedReadTicket& ticket) const;
+	bool still_valid(const SharedReadTicket& ticket) const;
+
+	bool copy_latest(SharedFrame& out, uint64_t* sequence = nullptr) const;
+
+private:
+	SharedMemory memory_;
+	const SharedRingHeader* header_ = nullptr;
+	const SharedFrameSlot* slots_ = nullptr;
+};
+
+#endif /* SHAREDFRAMERING_H */
@@ -0,0 +1,64 @@
+#include "SharedFrameSink.h"
+#include <cstring>
+#include <random>
+
+bool SharedFrameSink::open(const std::string& name)
+{
+	if (!memory_.create(name, SHARED_RING_SIZE))
+		return false;
+
+	header_ = static_cast<SharedRingHeader*>(memory_.data());
+	slots_ = reinterpret_cast<SharedFrameSlot*>(header_ + 1);
+
+	// A segment left by an earlier tracker keeps its slot versions, so a
+	// reader still inside an old frame sees it change when the slot is reused
+	bool reused = memcmp(header_->magic, SHARED_RING_MAGIC, sizeof(SHARED_RING_MAGIC)) == 0
+		&& header_->version == SHARED_RING_VERSION
+		&& header_->slotCount == SHARED_RING_SLOTS
+		&& header_->slotSize == sizeof(SharedFrameSlot);
+	if (!reused) {
+		memset(memory_.data(), 0, SHARED_RING_SIZE);
+		header_->version = SHARED_RING_VERSION;
+		header_->slotCount = SHARED_RING_SLOTS;
+		header_->slotSize = sizeof(SharedFrameSlot);
+	}
+
+	header_->published.store(0, std::memory_order_relaxed);
+	header_->session.store(std::random_device()(), std::memory_order_relaxed);
+
+	// The magic goes last so a reader never accepts a half-initialised header
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(header_->magic, SHARED_RING_MAGIC, sizeof(SHARED_RING_MAGIC));
+	next_ = 0;
+	return true;
+}
+
+void SharedFrameSink::consume(const FrameRecord& record)
+{
+	uint64_t sequence = next_++;
+	SharedFrameSlot& slot = slots_[sequence % SHARED_RING_SLOTS];
+
+	uint32_t version = slot.version.load(std::memory_order_relaxed);
+	slot.version.store(version + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.sequence.store(sequence, std::memory_order_relaxed);
+	SharedFrame& frame = slot.frame;
+	frame.timestampUs = record.timestampUs;
+	frame.frameNumber = record.frameNumber;
+	frame.sensorFrameIndex = record.timing.sdkFrameIndex;
+	frame.bodyCount = record.bodyCount;
+	for (uint32_t i = 0; i < record.bodyCount; i++) {
+		const BodyRecord& body = record.bodies[i];
+		SharedBody& out = frame.bodies[i];
+		out.id = body.id;
+		out.status = body.status;
+		out.jointMask = body.jointsEnabled ? body.jointMask : 0;
+		memcpy(out.joints, body.joints, sizeof(out.joints));
+		out.shoulderAngle = body.shoulderAngle;
+		out.hipAngle = body.hipAngle;
+	}
+
+	slot.version.store(version + 2, std::memory_order_release);
+	header_->published.store(sequence + 1, std::memory_order_release);
+}
@@ -0,0 +1,25 @@
+#ifndef SHAREDFRAMESINK_H
+#define SHAREDFRAMESINK_H
+
+#include "FrameSink.h"
+#include "SharedFrameRing.h"
+#include <string>
+
+// Writes the skeletons of every frame straight into the shared-memory ring
+// of SharedFrameRing.h for viewers on the same machine
+class SharedFrameSink : public FrameSink
+{
+public:
+	// Creates or takes over the segment; returns false when it cannot be mapped
+	bool open(const std::string& name);
+
+	virtual void consume(const FrameRecord& record) override;
+
+private:
+	SharedMemory memory_;
+	SharedRingHeader* header_ = nullptr;
+	SharedFrameSlot* slots_ = nullptr;
+	uint64_t next_ = 0;
+};
+
+#endif /* SHAREDFRAMESINK_H */
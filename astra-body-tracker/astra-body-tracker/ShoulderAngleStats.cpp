@@ -0,0 +1,77 @@
+#include "ShoulderAngleStats.h"
+#include <math.h>
+
+ShoulderAngleStats::ShoulderAngleStats(FrameSink& output, uint32_t intervalFrames)
+	: intervalFrames_(intervalFrames),
+	  entries_(256)
+{
+	outputs_.push_back(&output);
+	for (Entry& entry : entries_) {
+		entry.seen = false;
+		entry.updated = false;
+		entry.angle.reset();
+		entry.absAngle.reset();
+	}
+}
+
+void ShoulderAngleStats::add_output(FrameSink& output)
+{
+	outputs_.push_back(&output);
+}
+
+void ShoulderAngleStats::consume(const FrameRecord& record)
+{
+	lastFrame_ = record.frameNumber;
+
+	for (uint32_t i = 0; i < record.bodyCount; i++) {
+		const BodyRecord& body = record.bodies[i];
+		if (!body.jointsEnabled || isnan(body.shoulderAngle))
+			continue;
+
+		Entry& entry = entries_[body.id];
+		entry.seen = true;
+		entry.updated = true;
+		entry.angle.add(body.shoulderAngle);
+		entry.absAngle.add(fabs(body.shoulderAngle));
+	}
+
+	if (intervalFrames_ == 0 || ++framesSinceSummary_ < intervalFrames_)
+		return;
+
+	framesSinceSummary_ = 0;
+	for (size_t id = 0; id < entries_.size(); id++) {
+		Entry& entry = entries_[id];
+		if (entry.updated) {
+			emit(static_cast<uint8_t>(id), entry, false);
+			entry.updated = false;
+		}
+	}
+}
+
+void ShoulderAngleStats::finish()
+{
+	for (size_t id = 0; id < entries_.size(); id++) {
+		if (entries_[id].seen)
+			emit(static_cast<uint8_t>(id), entries_[id], true);
+	}
+	for (FrameSink* output : outputs_)
+		output->flush();
+}
+
+void ShoulderAngleStats::emit(uint8_t id, const Entry& entry, bool final)
+{
+	BodySummary summary;
+	summary.frameNumber = lastFrame_;
+	summary.bodyId = id;
+	summary.final = final;
+	summary.shoulderAngle = entry.angle;
+	summary.absShoulderAngle = entry.absAngle;
+
+	const BodyState* state = states_ ? states_->find(id) : nullptr;
+	summary.trackedFrames = state ? state->framesSeen : 0;
+	summary.recentShoulderAngle = state ? state->shoulderAngle.mean() : NAN;
+	summary.recentHipAngle = state ? state->hipAngle.mean() : NAN;
+	summary.spinePathMm = state ? static_cast<float>(state->spinePathLength) : NAN;
+	for (FrameSink* output : outputs_)
+		output->consume_summary(summary);
+}
@@ -0,0 +1,58 @@
+#ifndef SHOULDERANGLESTATS_H
+#define SHOULDERANGLESTATS_H
+
+#include "FrameSink.h"
+#include "BodyStateTable.h"
+#include <vector>
+
+/*
+	Keeps running shoulder angle statistics for every body over the whole
+	session and passes them to its output sinks as BodySummary records: one per
+	body seen in the last interval every intervalFrames frames, and a final one
+	per body from finish().
+
+	Bodies keep their statistics when the SDK loses them, so a patient who steps
+	out of view and back in under the same id is still summarised as one. The
+	recent angles and the spine path of a summary come from the body state
+	table, which only knows bodies while they are tracked.
+*/
+class ShoulderAngleStats : public FrameSink
+{
+public:
+	// intervalFrames of 0 leaves only the final summaries
+	ShoulderAngleStats(FrameSink& output, uint32_t intervalFrames);
+
+	// Another sink that receives every summary, such as the session file
+	void add_output(FrameSink& output);
+
+	// Table the per-body aggregates of the summaries are read from. Register
+	// it with the writer before this sink so it includes the current frame.
+	void set_body_states(const BodyStateTable& states) { states_ = &states; }
+
+	virtual void consume(const FrameRecord& record) override;
+
+	// Writes the final summaries. Call once the writer thread has stopped.
+	void finish();
+
+private:
+	struct Entry
+	{
+		bool seen;
+		bool updated;
+		RunningStats angle;
+		RunningStats absAngle;
+	};
+
+	void emit(uint8_t id, const Entry& entry, bool final);
+
+	std::vector<FrameSink*> outputs_;
+	const BodyStateTable* states_ = nullptr;
+	uint32_t intervalFrames_;
+	uint32_t framesSinceSummary_ = 0;
+	uint32_t lastFrame_ = 0;
+
+	// Indexed by astra::BodyId
+	std::vector<Entry> entries_;
+};
+
+#endif /* SHOULDERANGLESTATS_H */
@@ -0,0 +1,239 @@
+#include "SinkChannel.h"
+#include <cstring>
+
+static const size_t NO_SLOT = static_cast<size_t>(-1);
+
+static const char* const POLICY_NAMES[] = { "inline", "block", "drop-oldest", "drop-newest", "keep-latest" };
+
+const char* sink_policy_name(SinkPolicy policy)
+{
+	return POLICY_NAMES[static_cast<int>(policy)];
+}
+
+bool parse_sink_policy(const char* text, SinkPolicy& policy)
+{
+	for (int i = 0; i < 5; i++) {
+		if (strcmp(text, POLICY_NAMES[i]) == 0) {
+			policy = static_cast<SinkPolicy>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+SinkChannel::SinkChannel(const char* name, FrameSink& sink, SinkPolicy policy, size_t capacity)
+	: name_(name),
+	  sink_(sink),
+	  policy_(policy),
+	  capacity_(capacity > 0 ? capacity : 1),
+	  slots_(policy == SinkPolicy::Inline ? 0 : capacity_ + 1)
+{
+	free_.reserve(slots_.size());
+	for (size_t i = slots_.size(); i > 0; i--)
+		free_.push_back(i - 1);
+
+	size_t size = 1;
+	while (policy_ != SinkPolicy::Inline && size < capacity_)
+		size <<= 1;
+	queue_.resize(size);
+	queueMask_ = size - 1;
+}
+
+SinkChannel::~SinkChannel()
+{
+	stop();
+}
+
+void SinkChannel::start()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (running_ || policy_ == SinkPolicy::Inline)
+		return;
+	running_ = true;
+	thread_ = std::thread(&SinkChannel::run, this);
+}
+
+void SinkChannel::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_)
+			return;
+		running_ = false;
+	}
+	wake_.notify_one();
+	thread_.join();
+}
+
+void SinkChannel::consume(const FrameRecord& record)
+{
+	produced_.fetch_add(1, std::memory_order_relaxed);
+	if (policy_ == SinkPolicy::Inline) {
+		deliver(record);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (policy_ == SinkPolicy::KeepLatest) {
+		while (drop_queued_frame()) {
+		}
+	}
+
+	size_t slot = acquire_slot(lock, true);
+	if (slot == NO_SLOT) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	slots_[slot].summary = false;
+	slots_[slot].record = record;
+	push_queued(slot);
+	lock.unlock();
+	wake_.notify_one();
+}
+
+void SinkChannel::consume_summary(const BodySummary& summary)
+{
+	if (policy_ == SinkPolicy::Inline) {
+		sink_.consume_summary(summary);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	size_t slot = acquire_slot(lock, false);
+	slots_[slot].summary = true;
+	slots_[slot].bodySummary = summary;
+	push_queued(slot);
+	lock.unlock();
+	wake_.notify_one();
+}
+
+void SinkChannel::flush()
+{
+	// Otherwise the channel thread flushes the sink whenever its queue runs empty
+	if (policy_ == SinkPolicy::Inline)
+		flush_sink();
+}
+
+void SinkChannel::report(std::ostream& out) const
+{
+	out << "sink " << name_ << " (" << sink_policy_name(policy_) << "): "
+		<< produced_frames() << " frames produced, " << delivered_frames() << " delivered, "
+		<< dropped_frames() << " dropped" << std::endl;
+}
+
+void SinkChannel::take_latencies(LatencyHistogram& consume, LatencyHistogram& flush)
+{
+	std::lock_guard<std::mutex> lock(latencyMutex_);
+	consume.merge(consumeLatency_);
+	flush.merge(flushLatency_);
+	consumeLatency_.reset();
+	flushLatency_.reset();
+}
+
+size_t SinkChannel::acquire_slot(std::unique_lock<std::mutex>& lock, bool isFrame)
+{
+	while (count_ >= capacity_) {
+		if (policy_ != SinkPolicy::Block) {
+			if (isFrame && policy_ == SinkPolicy::DropNewest)
+				return NO_SLOT;
+			if (drop_queued_frame())
+				continue;
+		}
+
+		// Block, or a queue holding nothing but summaries
+		space_.wait(lock);
+	}
+
+	size_t slot = free_.back();
+	free_.pop_back();
+	return slot;
+}
+
+bool SinkChannel::drop_queued_frame()
+{
+	for (size_t i = 0; i < count_; i++) {
+		size_t slot = queued(i);
+		if (slots_[slot].summary)
+			continue;
+
+		// Only summaries are ahead of the frame, and there are rarely any, so
+		// they move up one place and the head passes the gap
+		for (size_t j = i; j > 0; j--)
+			queued(j) = queued(j - 1);
+		pop_queued();
+
+		free_.push_back(slot);
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void SinkChannel::push_queued(size_t slot)
+{
+	queued(count_) = slot;
+	count_++;
+}
+
+size_t SinkChannel::pop_queued()
+{
+	size_t slot = queued(0);
+	head_++;
+	count_--;
+	return slot;
+}
+
+void SinkChannel::deliver(const FrameRecord& record)
+{
+	uint64_t startUs = timed_ ? pipeline_clock_us() : 0;
+	sink_.consume(record);
+	if (timed_)
+		record_latency(consumeLatency_, startUs);
+	delivered_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SinkChannel::flush_sink()
+{
+	uint64_t startUs = timed_ ? pipeline_clock_us() : 0;
+	sink_.flush();
+	if (timed_)
+		record_latency(flushLatency_, startUs);
+}
+
+void SinkChannel::record_latency(LatencyHistogram& histogram, uint64_t startUs)
+{
+	uint64_t endUs = pipeline_clock_us();
+	std::lock_guard<std::mutex> lock(latencyMutex_);
+	histogram.add(endUs - startUs);
+}
+
+void SinkChannel::run()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;) {
+		wake_.wait(lock, [this] { return count_ > 0 || !running_; });
+		if (count_ == 0)
+			break;
+
+		size_t slot = pop_queued();
+		lock.unlock();
+
+		// The slot is in neither list, so the writer cannot reuse it meanwhile
+		const Entry& entry = slots_[slot];
+		if (entry.summary)
+			sink_.consume_summary(entry.bodySummary);
+		else
+			deliver(entry.record);
+
+		lock.lock();
+		free_.push_back(slot);
+		space_.notify_one();
+
+		if (count_ == 0) {
+			lock.unlock();
+			flush_sink();
+			lock.lock();
+		}
+	}
+}
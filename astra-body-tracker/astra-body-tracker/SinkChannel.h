@@ -0,0 +1,166 @@
+#ifndef SINKCHANNEL_H
+#define SINKCHANNEL_H
+
+#include "FrameSink.h"
+#include "PipelineMetrics.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// What a SinkChannel does with a frame when its queue is full
+enum class SinkPolicy
+{
+	// No queue or thread: the writer thread calls the sink through the
+	// channel, which only counts and times the frames
+	Inline,
+
+	// The writer thread waits for room, so the sink sees every frame that
+	// reached the writer
+	Block,
+
+	// The oldest queued frame makes room for the new one
+	DropOldest,
+
+	// The new frame is discarded
+	DropNewest,
+
+	// At most one frame waits, always the newest
+	KeepLatest
+};
+
+const size_t SINK_CHANNEL_DEFAULT_CAPACITY = 32;
+
+// Policy of every output that can have a channel. The session columns are
+// always filled inline: they are an in-memory append that must see every frame.
+struct SinkPolicies
+{
+	// stdout stalls whenever the Electron app stops reading
+	SinkPolicy output = SinkPolicy::DropOldest;
+	SinkPolicy recording = SinkPolicy::Inline;
+	SinkPolicy server = SinkPolicy::Inline;
+	SinkPolicy udp = SinkPolicy::Inline;
+	SinkPolicy sharedMemory = SinkPolicy::Inline;
+
+	int capacity = static_cast<int>(SINK_CHANNEL_DEFAULT_CAPACITY);
+};
+
+const char* sink_policy_name(SinkPolicy policy);
+
+// Accepts the names sink_policy_name returns
+bool parse_sink_policy(const char* text, SinkPolicy& policy);
+
+/*
+	Puts a queue and a thread of its own between the frame writer and one
+	sink, so a sink that stalls, such as stdout while the Electron renderer is
+	busy, only costs its own frames.
+
+	The writer thread's consume() copies the frame into a preallocated slot
+	and returns; the channel thread hands queued frames to the sink in order
+	and flushes it whenever the queue runs empty. When the queue is full the
+	policy decides which frame is lost. Only Block ever waits, and it waits on
+	the writer thread: the SDK callback is decoupled from that thread by
+	AsyncFrameWriter, so no policy can hold up astra_update().
+
+	Summaries are never dropped. They queue in order with the frames; when the
+	queue is full the dropping policies give up a frame to make room for one,
+	and Block waits as it does for frames.
+
+	An Inline channel has neither queue nor thread and passes every call
+	straight on, so outputs that need no decoupling still report their
+	counters and, with metrics on, their latency.
+*/
+class SinkChannel : public FrameSink
+{
+public:
+	SinkChannel(const char* name, FrameSink& sink, SinkPolicy policy,
+		size_t capacity = SINK_CHANNEL_DEFAULT_CAPACITY);
+	~SinkChannel();
+
+	SinkChannel(const SinkChannel&) = delete;
+	SinkChannel& operator=(const SinkChannel&) = delete;
+
+	void start();
+
+	// Delivers whatever is still queued, then joins the channel thread
+	void stop();
+
+	virtual void consume(const FrameRecord& record) override;
+	virtual void consume_summary(const BodySummary& summary) override;
+	virtual void flush() override;
+
+	const char* name() const { return name_; }
+	SinkPolicy policy() const { return policy_; }
+
+	// Frames offered by the writer, handed to the sink, and lost to the policy
+	uint64_t produced_frames() const { return produced_.load(std::memory_order_relaxed); }
+	uint64_t delivered_frames() const { return delivered_.load(std::memory_order_relaxed); }
+	uint64_t dropped_frames() const { return dropped_.load(std::memory_order_relaxed); }
+
+	// One line with the counters
+	void report(std::ostream& out) const;
+
+	// Times the sink's consume and flush on the channel thread. Before start().
+	void enable_timing() { timed_ = true; }
+
+	// Merges the latencies timed since the previous call into consume and flush
+	void take_latencies(LatencyHistogram& consume, LatencyHistogram& flush);
+
+private:
+	struct Entry
+	{
+		bool summary;
+		FrameRecord record;
+		BodySummary bodySummary;
+	};
+
+	void run();
+
+	// On the channel thread, or the writer thread for Inline
+	void deliver(const FrameRecord& record);
+	void flush_sink();
+	void record_latency(LatencyHistogram& histogram, uint64_t startUs);
+
+	// All called with mutex_ held
+	size_t acquire_slot(std::unique_lock<std::mutex>& lock, bool isFrame);
+	bool drop_queued_frame();
+	void push_queued(size_t slot);
+	size_t pop_queued();
+	size_t& queued(size_t i) { return queue_[(head_ + i) & queueMask_]; }
+
+	const char* name_;
+	FrameSink& sink_;
+	SinkPolicy policy_;
+	size_t capacity_;
+
+	// One slot more than the queue holds, for the entry being delivered
+	std::vector<Entry> slots_;
+	std::vector<size_t> free_;
+
+	// Ring of slot indices, oldest at head_, count_ of them queued; at most
+	// capacity_ and sized to a power of two like SpscRing
+	std::vector<size_t> queue_;
+	size_t queueMask_;
+	size_t head_ = 0;
+	size_t count_ = 0;
+
+	std::thread thread_;
+	bool running_ = false;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable space_;
+
+	std::atomic<uint64_t> produced_{ 0 };
+	std::atomic<uint64_t> delivered_{ 0 };
+	std::atomic<uint64_t> dropped_{ 0 };
+
+	bool timed_ = false;
+	std::mutex latencyMutex_;
+	LatencyHistogram consumeLatency_;
+	LatencyHistogram flushLatency_;
+};
+
+#endif /* SINKCHANNEL_H */
@@ -0,0 +1,80 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+	Fixed-capacity single-producer/single-consumer ring of preallocated slots.
+
+	The producer fills a slot in place between begin_push() and end_push(), the
+	consumer reads it in place between front() and pop(), so nothing is copied
+	or allocated after construction. Neither side ever waits on the other.
+*/
+template<typename T>
+class SpscRing
+{
+public:
+	// Capacity is rounded up to a power of two
+	explicit SpscRing(size_t capacity)
+	{
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		slots_.resize(size);
+		mask_ = size - 1;
+	}
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	size_t capacity() const { return slots_.size(); }
+
+	// Producer: next free slot, or nullptr when the ring is full
+	T* begin_push()
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (head - tail_.load(std::memory_order_acquire) == slots_.size())
+			return nullptr;
+		return &slots_[head & mask_];
+	}
+
+	// Producer: publish the slot returned by begin_push()
+	void end_push()
+	{
+		head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Consumer: oldest published slot, or nullptr when the ring is empty
+	T* front()
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail == head_.load(std::memory_order_acquire))
+			return nullptr;
+		return &slots_[tail & mask_];
+	}
+
+	// Consumer: hand the slot returned by front() back to the producer
+	void pop()
+	{
+		tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	bool empty() const
+	{
+		return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+	}
+
+private:
+	std::vector<T> slots_;
+	size_t mask_;
+
+	// Padded onto separate cache lines so the two threads do not false-share
+	char pad0_[64];
+	std::atomic<size_t> head_{ 0 };
+	char pad1_[64];
+	std::atomic<size_t> tail_{ 0 };
+};
+
+#endif /* SPSCRING_H */
@@ -0,0 +1,203 @@
+#include "StreamServer.h"
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/System/Time.hpp>
+
+StreamServer::StreamServer(OutputFormat format, const DeltaSettings& delta, int queueFrames, std::ostream& report)
+	: format_(format),
+	  report_(report),
+	  ring_(queueFrames > 0 ? queueFrames : 1),
+	  delta_(delta),
+	  discard_(1024)
+{
+}
+
+StreamServer::~StreamServer()
+{
+	stop();
+}
+
+bool StreamServer::start(unsigned short port)
+{
+	if (running_.load())
+		return true;
+
+	// accept() is only called once the selector reports a pending connection,
+	// but a client that gives up in between must not block the loop
+	listener_.setBlocking(false);
+	if (listener_.listen(port) != sf::Socket::Done)
+		return false;
+
+	selector_.add(listener_);
+	running_ = true;
+	thread_ = std::thread(&StreamServer::run, this);
+	return true;
+}
+
+void StreamServer::stop()
+{
+	if (!running_.exchange(false))
+		return;
+	thread_.join();
+}
+
+void StreamServer::consume(const FrameRecord& record)
+{
+	// Encoded outside the lock; swapping hands the overwritten slot's buffer
+	// back for the next frame, so the ring stops allocating once warm
+	encoded_.clear();
+	bool keyframe = true;
+	if (format_ == OutputFormat::Delta) {
+		if (keyframeWanted_.exchange(false, std::memory_order_relaxed))
+			delta_.request_keyframe();
+		keyframe = delta_.encode(record, packet_);
+		append_framed(packet_, encoded_);
+	}
+	else if (format_ == OutputFormat::Binary)
+		encode_binary(record, encoded_);
+	else
+		encode_json(record, encoded_);
+
+	std::lock_guard<std::mutex> lock(ringMutex_);
+	Slot& slot = ring_[published_ % ring_.size()];
+	slot.data.swap(encoded_);
+	slot.keyframe = keyframe;
+	published_++;
+}
+
+void StreamServer::run()
+{
+	while (running_.load()) {
+		bool blocked = false;
+		for (size_t i = 0; i < clients_.size();) {
+			if (send_pending(clients_[i], blocked))
+				i++;
+			else
+				disconnect(i, "connection lost");
+		}
+
+		// A full socket buffer is retried sooner than new frames are looked for
+		if (!selector_.wait(sf::milliseconds(blocked ? 1 : 5)))
+			continue;
+
+		if (selector_.isReady(listener_))
+			accept_clients();
+		for (size_t i = 0; i < clients_.size();) {
+			if (!selector_.isReady(*clients_[i].socket) || receive(clients_[i]))
+				i++;
+			else
+				disconnect(i, "closed by client");
+		}
+	}
+
+	while (!clients_.empty())
+		disconnect(clients_.size() - 1, "server stopped");
+	selector_.clear();
+	listener_.close();
+}
+
+void StreamServer::accept_clients()
+{
+	for (;;) {
+		std::unique_ptr<sf::TcpSocket> socket(new sf::TcpSocket);
+		if (listener_.accept(*socket) != sf::Socket::Done)
+			return;
+
+		std::string address = socket->getRemoteAddress().toString() + ":" + std::to_string(socket->getRemotePort());
+		if (clients_.size() >= STREAM_SERVER_MAX_CLIENTS) {
+			report_ << "stream client " << address << " refused: "
+				<< STREAM_SERVER_MAX_CLIENTS << " clients connected" << std::endl;
+			continue;
+		}
+
+		socket->setBlocking(false);
+		selector_.add(*socket);
+
+		Client client;
+		client.socket = std::move(socket);
+		client.address = address;
+		client.offset = 0;
+		client.synced = false;
+		client.sent = 0;
+		client.dropped = 0;
+		{
+			std::lock_guard<std::mutex> lock(ringMutex_);
+			client.next = published_;
+		}
+		clients_.push_back(std::move(client));
+		keyframeWanted_ = true;
+		report_ << "stream client " << address << " connected" << std::endl;
+	}
+}
+
+bool StreamServer::receive(Client& client)
+{
+	// Clients have nothing to say; reading only detects when they hang up
+	size_t received;
+	sf::Socket::Status status = client.socket->receive(discard_.data(), discard_.size(), received);
+	return status == sf::Socket::Done || status == sf::Socket::NotReady;
+}
+
+bool StreamServer::send_pending(Client& client, bool& blocked)
+{
+	if (client.offset == client.pending.size()) {
+		client.pending.clear();
+		client.offset = 0;
+
+		std::lock_guard<std::mutex> lock(ringMutex_);
+		uint64_t oldest = published_ > ring_.size() ? published_ - ring_.size() : 0;
+		if (client.next < oldest) {
+			client.dropped += oldest - client.next;
+			dropped_.fetch_add(oldest - client.next, std::memory_order_relaxed);
+			client.next = oldest;
+			client.synced = false;
+			keyframeWanted_ = true;
+		}
+
+		// Everything the client is missing goes out in one write
+		for (; client.next < published_; client.next++) {
+			const Slot& slot = ring_[client.next % ring_.size()];
+			client.synced = client.synced || slot.keyframe;
+			if (!client.synced) {
+				// Lost to a client that already had frames; a new one never had them
+				if (client.sent > 0) {
+					client.dropped++;
+					dropped_.fetch_add(1, std::memory_order_relaxed);
+				}
+				continue;
+			}
+			client.pending.insert(client.pending.end(), slot.data.begin(), slot.data.end());
+			client.sent++;
+		}
+	}
+
+	if (client.offset == client.pending.size())
+		return true;
+
+	size_t written = 0;
+	sf::Socket::Status status = client.socket->send(client.pending.data() + client.offset,
+		client.pending.size() - client.offset, written);
+	client.offset += written;
+
+	switch (status) {
+	case sf::Socket::Done:
+		client.offset = client.pending.size();
+		return true;
+	case sf::Socket::Partial:
+	case sf::Socket::NotReady:
+		blocked = true;
+		return true;
+	default:
+		return false;
+	}
+}
+
+void StreamServer::disconnect(size_t index, const char* reason)
+{
+	Client& client = clients_[index];
+	report_ << "stream client " << client.address << " " << reason << ": "
+		<< client.sent << " frames sent, " << client.dropped << " dropped" << std::endl;
+
+	selector_.remove(*client.socket);
+	client.socket->disconnect();
+	clients_.erase(clients_.begin() + index);
+}
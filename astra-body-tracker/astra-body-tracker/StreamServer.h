@@ -0,0 +1,118 @@
+#ifndef STREAMSERVER_H
+#define STREAMSERVER_H
+
+#include "FrameSink.h"
+#include "FrameEncoder.h"
+#include "DeltaCodec.h"
+#include <SFML/Network/SocketSelector.hpp>
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int STREAM_SERVER_DEFAULT_QUEUE = 8;
+const size_t STREAM_SERVER_MAX_CLIENTS = 8;
+
+/*
+	Serves the body stream over TCP to several subscribers at once, such as
+	the local viewer, a recording service and a remote clinician station. Every
+	client receives frames in the one format of the server, starting with the
+	first frame after it connects.
+
+	consume() encodes each frame once into a ring of the last queueFrames
+	frames, which is all the writer thread does. A server thread accepts
+	clients and sends with non-blocking writes, so a slow or stalled client
+	only holds up itself: once it is more than queueFrames frames behind, its
+	oldest unsent frames are skipped and counted. Records are never cut, so a
+	client always sees whole JSON lines, binary records or packets.
+
+	Delta packets only decode after the frames before them, so a client in
+	that format starts at a keyframe and, after frames were skipped, waits
+	for the next one. Either asks the encoder for a keyframe right away.
+
+	New frames are picked up within 5 ms, the same bound as the frame writer.
+*/
+class StreamServer : public FrameSink
+{
+public:
+	StreamServer(OutputFormat format, const DeltaSettings& delta, int queueFrames, std::ostream& report);
+	~StreamServer();
+
+	StreamServer(const StreamServer&) = delete;
+	StreamServer& operator=(const StreamServer&) = delete;
+
+	// Returns false when the port cannot be bound
+	bool start(unsigned short port);
+
+	// Disconnects every client and joins the server thread
+	void stop();
+
+	virtual void consume(const FrameRecord& record) override;
+
+	// Frames skipped for slow clients, summed over all clients
+	uint64_t dropped_frames() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	struct Client
+	{
+		std::unique_ptr<sf::TcpSocket> socket;
+		std::string address;
+
+		// Frame sequence number the client needs next, and whether frames
+		// from there on decode without the ones before
+		uint64_t next;
+		bool synced;
+
+		// Records taken from the ring, sent up to offset
+		std::vector<char> pending;
+		size_t offset;
+
+		uint64_t sent;
+		uint64_t dropped;
+	};
+
+	void run();
+	void accept_clients();
+	bool receive(Client& client);
+	bool send_pending(Client& client, bool& blocked);
+	void disconnect(size_t index, const char* reason);
+
+	OutputFormat format_;
+	std::ostream& report_;
+
+	struct Slot
+	{
+		std::vector<char> data;
+
+		// Decodes on its own; every JSON and binary frame does
+		bool keyframe;
+	};
+
+	// Encoded frames; frame n lives in slot n % size while n + size > published_
+	std::mutex ringMutex_;
+	std::vector<Slot> ring_;
+	uint64_t published_ = 0;
+	std::vector<char> encoded_;
+
+	DeltaEncoder delta_;
+	sf::Packet packet_;
+	std::atomic<bool> keyframeWanted_{ false };
+
+	// Owned by the server thread
+	sf::TcpListener listener_;
+	sf::SocketSelector selector_;
+	std::vector<Client> clients_;
+	std::vector<char> discard_;
+
+	std::thread thread_;
+	std::atomic<bool> running_{ false };
+	std::atomic<uint64_t> dropped_{ 0 };
+};
+
+#endif /* STREAMSERVER_H */
@@ -0,0 +1,43 @@
+#include "StreamSink.h"
+
+StreamSink::StreamSink(OutputFormat format, std::ostream& out, const DeltaSettings& delta)
+	: format_(format),
+	  out_(out),
+	  delta_(delta)
+{
+	buffer_.reserve(64 * ASTRA_MAX_BODIES * BINARY_RECORD_SIZE);
+	if (format_ == OutputFormat::Delta)
+		packet_.reset(new sf::Packet);
+}
+
+void StreamSink::consume(const FrameRecord& record)
+{
+	if (format_ == OutputFormat::Delta) {
+		delta_.encode(record, *packet_);
+		append_framed(*packet_, buffer_);
+	}
+	else if (format_ == OutputFormat::Binary)
+		encode_binary(record, buffer_);
+	else
+		encode_json(record, buffer_);
+}
+
+void StreamSink::consume_summary(const BodySummary& summary)
+{
+	if (format_ == OutputFormat::Delta)
+		return;
+	if (format_ == OutputFormat::Binary)
+		encode_summary_binary(summary, buffer_);
+	else
+		encode_summary_json(summary, buffer_);
+}
+
+void StreamSink::flush()
+{
+	if (buffer_.empty())
+		return;
+
+	out_.write(buffer_.data(), buffer_.size());
+	out_.flush();
+	buffer_.clear();
+}
@@ -0,0 +1,32 @@
+#ifndef STREAMSINK_H
+#define STREAMSINK_H
+
+#include "FrameSink.h"
+#include "FrameEncoder.h"
+#include "DeltaCodec.h"
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// Encodes frames as JSON, binary records or delta packets and writes each
+// batch with one write
+class StreamSink : public FrameSink
+{
+public:
+	StreamSink(OutputFormat format, std::ostream& out, const DeltaSettings& delta = DeltaSettings());
+
+	virtual void consume(const FrameRecord& record) override;
+	virtual void consume_summary(const BodySummary& summary) override;
+	virtual void flush() override;
+
+private:
+	OutputFormat format_;
+	std::ostream& out_;
+	std::vector<char> buffer_;
+
+	// Only created for the delta format, which is all that needs sfml-network
+	DeltaEncoder delta_;
+	std::unique_ptr<sf::Packet> packet_;
+};
+
+#endif /* STREAMSINK_H */
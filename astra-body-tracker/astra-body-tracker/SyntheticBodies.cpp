@@ -0,0 +1,81 @@
+#include "SyntheticBodies.h"
+#include <cstring>
+#include <math.h>
+
+// Standing pose in millimetres, relative to the base of the spine
+static const float STANDING_POSE[ASTRA_MAX_JOINTS][3] = {
+	{    0,  620, 0 },	// Head
+	{    0,  430, 0 },	// ShoulderSpine
+	{ -180,  410, 0 },	// LeftShoulder
+	{ -210,  150, 0 },	// LeftElbow
+	{ -230, -130, 0 },	// LeftHand
+	{  180,  410, 0 },	// RightShoulder
+	{  210,  150, 0 },	// RightElbow
+	{  230, -130, 0 },	// RightHand
+	{    0,  220, 0 },	// MidSpine
+	{    0,    0, 0 },	// BaseSpine
+	{ -100,  -60, 0 },	// LeftHip
+	{ -110, -480, 0 },	// LeftKnee
+	{ -110, -900, 0 },	// LeftFoot
+	{  100,  -60, 0 },	// RightHip
+	{  110, -480, 0 },	// RightKnee
+	{  110, -900, 0 },	// RightFoot
+	{ -225,  -60, 0 },	// LeftWrist
+	{  225,  -60, 0 },	// RightWrist
+	{    0,  520, 0 },	// Neck
+};
+
+SyntheticBodies::SyntheticBodies(unsigned seed, double untrackedChance)
+	: random_(seed),
+	  untracked_(untrackedChance)
+{
+}
+
+void SyntheticBodies::generate(int count, uint32_t frame, astra_body_t* bodies)
+{
+	double t = frame / 30.0;
+
+	for (int b = 0; b < count; b++) {
+		astra_body_t& body = bodies[b];
+		memset(&body, 0, sizeof(body));
+
+		body.id = static_cast<astra_body_id_t>(b + 1);
+		body.status = ASTRA_BODY_STATUS_TRACKING;
+		body.features = ASTRA_BODY_TRACKING_JOINTS;
+
+		// Spread bodies across the field of view and give each its own rhythm
+		double phase = b * 1.3;
+		float originX = static_cast<float>((b - (count - 1) / 2.0) * 700.0);
+		float originY = 100.0f;
+		float originZ = 2500.0f + 150.0f * (b % 2);
+		float sway = static_cast<float>(40.0 * sin(t * 1.5 + phase));
+		float tilt = static_cast<float>(25.0 * sin(t * 0.7 + phase));
+		float wave = static_cast<float>(120.0 * sin(t * 3.0 + phase));
+
+		for (int n = 0; n < ASTRA_MAX_JOINTS; n++) {
+			astra_joint_t& joint = body.joints[n];
+			joint.type = static_cast<astra_joint_type_t>(n);
+			joint.orientation.m00 = joint.orientation.m11 = joint.orientation.m22 = 1.0f;
+
+			if (untracked_(random_)) {
+				joint.status = ASTRA_JOINT_STATUS_NOT_TRACKED;
+				continue;
+			}
+
+			const float* pose = STANDING_POSE[n];
+			float height = pose[1] / 1000.0f;
+			float x = originX + pose[0] + sway * height;
+			float y = originY + pose[1] + (pose[0] < 0 ? tilt : -tilt) * (fabsf(pose[0]) / 200.0f);
+			float z = originZ + pose[2];
+			if (n == ASTRA_JOINT_RIGHT_HAND || n == ASTRA_JOINT_RIGHT_WRIST)
+				y += wave;
+
+			joint.status = ASTRA_JOINT_STATUS_TRACKED;
+			joint.worldPosition.x = x;
+			joint.worldPosition.y = y;
+			joint.worldPosition.z = z;
+			joint.depthPosition.x = 320.0f + x * 0.2f;
+			joint.depthPosition.y = 240.0f - y * 0.2f;
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef SYNTHETICBODIES_H
+#define SYNTHETICBODIES_H
+
+#include <astra/astra.hpp>
+#include <random>
+
+// Procedural stand-in for the BodyStream: standing skeletons that sway and wave,
+// laid out side by side, with a few joints dropping out of tracking each frame.
+class SyntheticBodies
+{
+public:
+	explicit SyntheticBodies(unsigned seed = 1, double untrackedChance = 0.05);
+
+	// Fills bodies[0..count) for the given frame number
+	void generate(int count, uint32_t frame, astra_body_t* bodies);
+
+	// The same memory viewed through the SDK wrapper log_data works with
+	static const astra::Body* as_bodies(const astra_body_t* bodies)
+	{
+		return reinterpret_cast<const astra::Body*>(bodies);
+	}
+
+private:
+	std::mt19937 random_;
+	std::bernoulli_distribution untracked_;
+};
+
+#endif /* SYNTHETICBODIES_H */
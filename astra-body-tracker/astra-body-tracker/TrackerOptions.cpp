@@ -0,0 +1,278 @@
+#include "TrackerOptions.h"
+#include <cstdlib>
+#include <cstring>
+
+static bool parse_int(const char* text, int min, int max, int& value)
+{
+	char* end;
+	long parsed = strtol(text, &end, 10);
+	if (end == text || *end != '\0' || parsed < min || parsed > max)
+		return false;
+	value = static_cast<int>(parsed);
+	return true;
+}
+
+static bool parse_float(const char* text, float min, float max, float& value)
+{
+	char* end;
+	double parsed = strtod(text, &end);
+	if (end == text || *end != '\0' || !(parsed >= min && parsed <= max))
+		return false;
+	value = static_cast<float>(parsed);
+	return true;
+}
+
+static bool parse_format(const char* text, OutputFormat& format)
+{
+	if (strcmp(text, "json") == 0)
+		format = OutputFormat::Json;
+	else if (strcmp(text, "binary") == 0)
+		format = OutputFormat::Binary;
+	else if (strcmp(text, "delta") == 0)
+		format = OutputFormat::Delta;
+	else
+		return false;
+	return true;
+}
+
+// NAME=POLICY for one of the outputs SinkPolicies covers
+static bool parse_sink_policy_option(const char* text, SinkPolicies& policies)
+{
+	const char* equals = strchr(text, '=');
+	if (!equals)
+		return false;
+
+	std::string name(text, equals);
+	SinkPolicy* policy;
+	if (name == "stdout")
+		policy = &policies.output;
+	else if (name == "record")
+		policy = &policies.recording;
+	else if (name == "serve")
+		policy = &policies.server;
+	else if (name == "udp")
+		policy = &policies.udp;
+	else if (name == "shared-memory")
+		policy = &policies.sharedMemory;
+	else
+		return false;
+	return parse_sink_policy(equals + 1, *policy);
+}
+
+bool parse_options(int argc, const char** argv, TrackerOptions& options)
+{
+	bool serveFormatGiven = false;
+	bool stdinWatchGiven = false;
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+
+		if (strcmp(arg, "--format") == 0) {
+			if (++i >= argc || !parse_format(argv[i], options.format))
+				return false;
+		}
+		else if (strcmp(arg, "--fps") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 1, 60, options.capture.fps))
+				return false;
+		}
+		else if (strcmp(arg, "--cpu-budget") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 1, 100, options.capture.cpuBudget))
+				return false;
+		}
+		else if (strcmp(arg, "--filter") == 0) {
+			if (++i >= argc)
+				return false;
+			if (strcmp(argv[i], "none") == 0)
+				options.filter.type = FilterType::None;
+			else if (strcmp(argv[i], "one-euro") == 0)
+				options.filter.type = FilterType::OneEuro;
+			else if (strcmp(argv[i], "kalman") == 0)
+				options.filter.type = FilterType::Kalman;
+			else
+				return false;
+		}
+		else if (strcmp(arg, "--filter-cutoff") == 0) {
+			if (++i >= argc || !parse_float(argv[i], 0.01f, 100.0f, options.filter.minCutoff))
+				return false;
+		}
+		else if (strcmp(arg, "--filter-beta") == 0) {
+			if (++i >= argc || !parse_float(argv[i], 0.0f, 10.0f, options.filter.beta))
+				return false;
+		}
+		else if (strcmp(arg, "--filter-noise") == 0) {
+			if (++i >= argc || !parse_float(argv[i], 0.01f, 1000.0f, options.filter.measurementNoise))
+				return false;
+		}
+		else if (strcmp(arg, "--filter-accel") == 0) {
+			if (++i >= argc || !parse_float(argv[i], 1.0f, 1.0e6f, options.filter.accelerationNoise))
+				return false;
+		}
+		else if (strcmp(arg, "--back-surface") == 0) {
+			options.backSurface.enabled = true;
+		}
+		else if (strcmp(arg, "--back-cell") == 0) {
+			if (++i >= argc || !parse_float(argv[i], 2.0f, 100.0f, options.backSurface.cellWidth))
+				return false;
+		}
+		else if (strcmp(arg, "--sink-policy") == 0) {
+			if (++i >= argc || !parse_sink_policy_option(argv[i], options.sinkPolicies))
+				return false;
+		}
+		else if (strcmp(arg, "--sink-queue") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 1, 1024, options.sinkPolicies.capacity))
+				return false;
+		}
+		else if (strcmp(arg, "--summary-frames") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 0, 1000000, options.summaryFrames))
+				return false;
+		}
+		else if (strcmp(arg, "--record") == 0) {
+			if (++i >= argc)
+				return false;
+			options.recordPath = argv[i];
+		}
+		else if (strcmp(arg, "--record-depth") == 0) {
+			if (++i >= argc)
+				return false;
+			options.recordDepthPath = argv[i];
+		}
+		else if (strcmp(arg, "--serve") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 1, 65535, options.servePort))
+				return false;
+		}
+		else if (strcmp(arg, "--serve-format") == 0) {
+			if (++i >= argc || !parse_format(argv[i], options.serveFormat))
+				return false;
+			serveFormatGiven = true;
+		}
+		else if (strcmp(arg, "--delta-scale") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 1, DELTA_MAX_SCALE, options.delta.positionScale))
+				return false;
+		}
+		else if (strcmp(arg, "--serve-queue") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 1, 1000, options.serveQueue))
+				return false;
+		}
+		else if (strcmp(arg, "--udp") == 0) {
+			if (++i >= argc)
+				return false;
+			const char* colon = strrchr(argv[i], ':');
+			if (!colon || colon == argv[i] || !parse_int(colon + 1, 1, 65535, options.udpPort))
+				return false;
+			options.udpHost.assign(argv[i], colon);
+		}
+		else if (strcmp(arg, "--shared-memory") == 0) {
+			if (++i >= argc)
+				return false;
+			options.sharedMemoryName = argv[i];
+		}
+		else if (strcmp(arg, "--metrics") == 0) {
+			if (++i >= argc)
+				return false;
+			options.metricsPath = argv[i];
+		}
+		else if (strcmp(arg, "--metrics-interval") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 1, 3600, options.metricsInterval))
+				return false;
+		}
+		else if (strcmp(arg, "--replay") == 0) {
+			if (++i >= argc)
+				return false;
+			options.replayPath = argv[i];
+		}
+		else if (strcmp(arg, "--replay-fast") == 0) {
+			options.replayFast = true;
+		}
+		else if (strcmp(arg, "--index") == 0) {
+			options.buildIndex = true;
+		}
+		else if (strcmp(arg, "--convert") == 0) {
+			options.convert = true;
+		}
+		else if (strcmp(arg, "--analyze") == 0) {
+			options.analyze = true;
+		}
+		else if (strcmp(arg, "--benchmark") == 0) {
+			options.benchmark = true;
+		}
+		else if (strcmp(arg, "--benchmark-frames") == 0) {
+			if (++i >= argc || !parse_int(argv[i], 1, 10000000, options.benchmarkSettings.frames))
+				return false;
+		}
+		else if (strcmp(arg, "--no-stdin-watch") == 0) {
+			options.watchStdin = false;
+			stdinWatchGiven = true;
+		}
+		else if (strcmp(arg, "--stdin-watch") == 0) {
+			options.watchStdin = true;
+			stdinWatchGiven = true;
+		}
+		else if (strncmp(arg, "--", 2) == 0) {
+			return false;
+		}
+		else {
+			options.patientDir = arg;
+		}
+	}
+
+	if (!serveFormatGiven)
+		options.serveFormat = options.format;
+
+	// A replay on CI usually has stdin closed or at /dev/null, which would end it at once
+	if (!stdinWatchGiven && !options.replayPath.empty())
+		options.watchStdin = false;
+
+	if ((options.buildIndex || options.convert || options.analyze) && options.patientDir.empty())
+		return false;
+
+	// Body recordings carry no depth to record or analyse
+	if (!options.replayPath.empty() && (!options.recordDepthPath.empty() || options.backSurface.enabled))
+		return false;
+
+	return true;
+}
+
+void print_usage(std::ostream& out)
+{
+	out << "usage: astra-body-tracker [patient_dir] [options]" << std::endl
+		<< "  --format FORMAT        body output written to stdout: json, binary or delta, the" << std::endl
+		<< "                         compact packets of DeltaCodec.h without summaries (default json)" << std::endl
+		<< "  --fps N                depth stream frame rate (default 30)" << std::endl
+		<< "  --cpu-budget PERCENT   share of one core the capture loop may use (default 100)" << std::endl
+		<< "  --filter TYPE          joint smoothing: none, one-euro or kalman (default none)" << std::endl
+		<< "  --filter-cutoff HZ     one-euro cutoff for joints at rest (default 1.5)" << std::endl
+		<< "  --filter-beta B        one-euro cutoff increase per mm/s of speed (default 0.01)" << std::endl
+		<< "  --filter-noise MM      kalman position noise of the sensor (default 5)" << std::endl
+		<< "  --filter-accel MM/S2   kalman acceleration noise of the joints (default 1000)" << std::endl
+		<< "  --back-surface         measure back-surface asymmetry from depth, written to" << std::endl
+		<< "                         back_asymmetry.json in patient_dir or to stderr" << std::endl
+		<< "  --back-cell MM         width of a back-surface map cell (default 10)" << std::endl
+		<< "  --sink-policy OUT=P    what OUT (stdout, record, serve, udp or shared-memory) loses" << std::endl
+		<< "                         when it falls behind: inline (the writer waits on it), block," << std::endl
+		<< "                         drop-oldest, drop-newest or keep-latest (stdout drop-oldest," << std::endl
+		<< "                         others inline)" << std::endl
+		<< "  --sink-queue N         frames queued per output with a policy (default 32)" << std::endl
+		<< "  --summary-frames N     frames between shoulder angle summaries, 0 for final only (default 150)" << std::endl
+		<< "  --no-stdin-watch       keep running when stdin is closed (default with --replay)" << std::endl
+		<< "  --stdin-watch          stop when stdin is closed (default without --replay)" << std::endl
+		<< "  --record FILE          also record body frames to FILE" << std::endl
+		<< "  --record-depth FILE    also record raw depth frames to FILE" << std::endl
+		<< "  --serve PORT           also stream body frames to TCP clients on PORT" << std::endl
+		<< "  --serve-format FORMAT  format served to TCP clients (default that of --format)" << std::endl
+		<< "  --delta-scale N        delta position units per mm (default 1)" << std::endl
+		<< "  --serve-queue N        frames a slow client may fall behind before its oldest" << std::endl
+		<< "                         are dropped (default 8)" << std::endl
+		<< "  --udp HOST:PORT        also publish one datagram of skeletons per frame to HOST," << std::endl
+		<< "                         a unicast address or a multicast group" << std::endl
+		<< "  --shared-memory NAME   also write skeletons to the shared-memory ring NAME" << std::endl
+		<< "                         for local viewers (astra-body-tracker by convention)" << std::endl
+		<< "  --metrics FILE|-       write per-stage latency summaries to FILE, or stderr for -" << std::endl
+		<< "  --metrics-interval S   seconds between latency summaries (default 5)" << std::endl
+		<< "  --replay FILE          replay recorded body frames instead of using the sensor" << std::endl
+		<< "  --replay-fast          replay as fast as possible instead of at recorded speed" << std::endl
+		<< "  --index                rebuild raw_data.idx from the session in patient_dir and exit" << std::endl
+		<< "  --convert              convert session.rows, or else raw_data.txt, in patient_dir" << std::endl
+		<< "                         to session.col and exit" << std::endl
+		<< "  --analyze              print posture metrics of the session in patient_dir and exit" << std::endl
+		<< "  --benchmark            time the output path on synthetic bodies and exit" << std::endl
+		<< "  --benchmark-frames N   frames timed per body count and format (default 3000)" << std::endl;
+}
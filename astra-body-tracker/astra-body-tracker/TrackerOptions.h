@@ -0,0 +1,88 @@
+#ifndef TRACKEROPTIONS_H
+#define TRACKEROPTIONS_H
+
+#include "FrameEncoder.h"
+#include "DeltaCodec.h"
+#include "CaptureLoop.h"
+#include "JointFilter.h"
+#include "BackSurface.h"
+#include "Benchmark.h"
+#include "StreamServer.h"
+#include "SinkChannel.h"
+#include <ostream>
+#include <string>
+
+struct TrackerOptions
+{
+	// Directory of the current patient, passed by the Electron app
+	std::string patientDir;
+
+	OutputFormat format = OutputFormat::Json;
+
+	// Quantization and keyframes of the delta format
+	DeltaSettings delta;
+
+	CaptureLoopSettings capture;
+
+	// Smoothing applied to joint positions before the angles are derived
+	FilterSettings filter;
+
+	// Back-surface asymmetry from the depth stream
+	BackSurfaceSettings backSurface;
+
+	// Backpressure between the frame writer and each output
+	SinkPolicies sinkPolicies;
+
+	// Frames between shoulder angle summaries, 0 for the final one only
+	int summaryFrames = 150;
+
+	// Stop when stdin reaches end of input; off by default for replays
+	bool watchStdin = true;
+
+	// Body frames are also recorded to this file when set
+	std::string recordPath;
+
+	// Body frames are also served to TCP clients on this port when not 0
+	int servePort = 0;
+	OutputFormat serveFormat = OutputFormat::Json;
+	int serveQueue = STREAM_SERVER_DEFAULT_QUEUE;
+
+	// Skeletons are also published as one UDP datagram per frame when udpPort is not 0
+	std::string udpHost;
+	int udpPort = 0;
+
+	// Skeletons are also written to this shared-memory segment when set
+	std::string sharedMemoryName;
+
+	// Raw depth frames are recorded to this chunked file when set
+	std::string recordDepthPath;
+
+	// Per-stage latency summaries go to this file, or stderr for "-"
+	std::string metricsPath;
+	int metricsInterval = 5;
+
+	// Replay a recorded file instead of reading the sensor
+	std::string replayPath;
+	bool replayFast = false;
+
+	// Index the session in patientDir and exit
+	bool buildIndex = false;
+
+	// Convert the session journal, or else the raw_data.txt, in patientDir to a
+	// session file and exit
+	bool convert = false;
+
+	// Print posture metrics of the session in patientDir and exit
+	bool analyze = false;
+
+	// Run the output benchmark on synthetic bodies and exit
+	bool benchmark = false;
+	BenchmarkSettings benchmarkSettings;
+};
+
+// Returns false when the command line could not be understood
+bool parse_options(int argc, const char** argv, TrackerOptions& options);
+
+void print_usage(std::ostream& out);
+
+#endif /* TRACKEROPTIONS_H */
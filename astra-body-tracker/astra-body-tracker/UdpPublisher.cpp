@@ -0,0 +1,67 @@
+#include "UdpPublisher.h"
+#include <cstring>
+#include <random>
+
+UdpPublisher::UdpPublisher(std::ostream& report)
+	: report_(report)
+{
+	frame_.session = std::random_device()();
+	frame_.sequence = 0;
+}
+
+bool UdpPublisher::open(const std::string& host, unsigned short port)
+{
+	address_ = sf::IpAddress(host);
+	// A failed lookup leaves 0; this SFML also returns it for 255.255.255.255,
+	// so broadcast is out. sf::IpAddress::None is DLL data and cannot be
+	// delay-loaded.
+	if (address_.toInteger() == 0)
+		return false;
+
+	port_ = port;
+	socket_.setBlocking(false);
+	return true;
+}
+
+void UdpPublisher::consume(const FrameRecord& record)
+{
+	if (pending_)
+		superseded_++;
+	pending_ = true;
+
+	frame_.timestampUs = record.timestampUs;
+	frame_.frameNumber = record.frameNumber;
+	frame_.sensorFrameIndex = record.timing.sdkFrameIndex;
+	frame_.bodyCount = record.bodyCount;
+	for (uint32_t i = 0; i < record.bodyCount; i++) {
+		const BodyRecord& body = record.bodies[i];
+		JointFrameBody& out = frame_.bodies[i];
+		out.id = body.id;
+		out.status = body.status;
+		out.jointMask = body.jointsEnabled ? body.jointMask : 0;
+		memcpy(out.joints, body.joints, sizeof(out.joints));
+		out.shoulderAngle = body.shoulderAngle;
+		out.hipAngle = body.hipAngle;
+	}
+}
+
+void UdpPublisher::flush()
+{
+	if (!pending_)
+		return;
+	pending_ = false;
+
+	size_t size = encode_joint_datagram(frame_, datagram_);
+	frame_.sequence++;
+
+	if (socket_.send(datagram_, size, address_, port_) == sf::Socket::Done) {
+		sent_++;
+		return;
+	}
+
+	failed_++;
+	if (!reportedFailure_) {
+		report_ << "cannot send joint datagrams to " << address_.toString() << ":" << port_ << std::endl;
+		reportedFailure_ = true;
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef UDPPUBLISHER_H
+#define UDPPUBLISHER_H
+
+#include "FrameSink.h"
+#include "JointDatagram.h"
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/UdpSocket.hpp>
+#include <ostream>
+#include <string>
+
+/*
+	Publishes the skeletons of every frame as one joint datagram (see
+	JointDatagram.h) to a unicast address or a multicast group, for live
+	displays where a late frame is worth less than a lost one.
+
+	Only the newest frame of each writer batch is sent: when the writer falls
+	behind, the frames it catches up on are already stale and are counted as
+	superseded instead. Sends never block; a datagram the socket cannot take
+	is counted and dropped. Multicast datagrams keep the default time to live
+	of one, so they stay on the local network.
+*/
+class UdpPublisher : public FrameSink
+{
+public:
+	explicit UdpPublisher(std::ostream& report);
+
+	// Returns false when host does not resolve
+	bool open(const std::string& host, unsigned short port);
+
+	virtual void consume(const FrameRecord& record) override;
+	virtual void flush() override;
+
+	uint64_t sent_datagrams() const { return sent_; }
+	uint64_t superseded_frames() const { return superseded_; }
+	uint64_t failed_datagrams() const { return failed_; }
+
+private:
+	std::ostream& report_;
+	sf::UdpSocket socket_;
+	sf::IpAddress address_;
+	unsigned short port_ = 0;
+
+	JointFrame frame_;
+	bool pending_ = false;
+	char datagram_[JOINT_DATAGRAM_MAX_SIZE];
+
+	uint64_t sent_ = 0;
+	uint64_t superseded_ = 0;
+	uint64_t failed_ = 0;
+	bool reportedFailure_ = false;
+};
+
+#endif /* UDPPUBLISHER_H */
@@ -0,0 +1,219 @@
+#include "VoxelGrid.h"
+#include <algorithm>
+#include <math.h>
+
+// Cube coordinates are packed into 21 bits each, offset to be non-negative
+static const int COORDINATE_BITS = 21;
+static const int32_t COORDINATE_LIMIT = 1 << (COORDINATE_BITS - 1);
+static const uint64_t COORDINATE_MASK = (uint64_t(1) << COORDINATE_BITS) - 1;
+
+// Table size the first frame starts from; it doubles whenever it is half full
+static const int INITIAL_TABLE_BITS = 12;
+
+// floor(v) offset into the packed range. Truncating and correcting is several
+// times faster than floorf, which is a library call without SSE4.1.
+static inline uint64_t cube_coordinate(float v)
+{
+	int32_t i = static_cast<int32_t>(v);
+	i -= v < static_cast<float>(i);
+	return static_cast<uint64_t>(i + COORDINATE_LIMIT) & COORDINATE_MASK;
+}
+
+VoxelDownsampler::VoxelDownsampler(float leafSize)
+{
+	set_leaf_size(leafSize);
+
+	size_t size = size_t(1) << INITIAL_TABLE_BITS;
+	keys_.resize(size);
+	voxels_.resize(size);
+	generations_.assign(size, 0);
+	shift_ = 64 - INITIAL_TABLE_BITS;
+}
+
+void VoxelDownsampler::set_leaf_size(float leafSize)
+{
+	leafSize_ = leafSize > VOXEL_MIN_LEAF_SIZE ? leafSize : VOXEL_MIN_LEAF_SIZE;
+	inverseLeaf_ = 1.0f / leafSize_;
+}
+
+void VoxelDownsampler::begin_frame()
+{
+	// Generation 0 marks never-written slots, so a wrap clears the table once
+	if (++generation_ == 0) {
+		std::fill(generations_.begin(), generations_.end(), 0);
+		generation_ = 1;
+	}
+	voxelCount_ = 0;
+	pointsAdded_ = 0;
+	pointsSkipped_ = 0;
+}
+
+// The two layouts add() accepts
+struct ColumnPoints
+{
+	const float* px;
+	const float* py;
+	const float* pz;
+
+	float x(size_t i) const { return px[i]; }
+	float y(size_t i) const { return py[i]; }
+	float z(size_t i) const { return pz[i]; }
+};
+
+struct VectorPoints
+{
+	const astra::Vector3f* points;
+
+	float x(size_t i) const { return points[i].x; }
+	float y(size_t i) const { return points[i].y; }
+	float z(size_t i) const { return points[i].z; }
+};
+
+void VoxelDownsampler::add(const float* x, const float* y, const float* z, size_t count)
+{
+	ColumnPoints points = { x, y, z };
+	add_points(points, count);
+}
+
+void VoxelDownsampler::add(const astra::Vector3f* points, size_t count)
+{
+	VectorPoints vectors = { points };
+	add_points(vectors, count);
+}
+
+template<typename Points>
+void VoxelDownsampler::add_points(const Points& points, size_t count)
+{
+	const float limit = static_cast<float>(COORDINATE_LIMIT - 1);
+
+	// Neighbouring pixels of a depth frame mostly share a voxel, so a run of
+	// points in one voxel is summed in registers and added to it when the run ends
+	Accumulator run = { 0, 0, 0, 0 };
+	uint64_t runKey = 0;
+	uint64_t skipped = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		float x = points.x(i), y = points.y(i), z = points.z(i);
+		float fx = x * inverseLeaf_;
+		float fy = y * inverseLeaf_;
+		float fz = z * inverseLeaf_;
+
+		// Written so NaN coordinates fail too
+		if (!(z > 0 && fabsf(fx) < limit && fabsf(fy) < limit && fz < limit)) {
+			skipped++;
+			continue;
+		}
+
+		uint64_t key = cube_coordinate(fx) | cube_coordinate(fy) << COORDINATE_BITS
+			| cube_coordinate(fz) << (2 * COORDINATE_BITS);
+
+		if (key != runKey || run.count == 0) {
+			flush_run(runKey, run);
+			runKey = key;
+			run.x = run.y = run.z = 0;
+			run.count = 0;
+		}
+		run.x += x;
+		run.y += y;
+		run.z += z;
+		run.count++;
+	}
+	flush_run(runKey, run);
+
+	pointsAdded_ += count;
+	pointsSkipped_ += skipped;
+}
+
+void VoxelDownsampler::flush_run(uint64_t key, const Accumulator& run)
+{
+	if (run.count == 0)
+		return;
+
+	Accumulator& sum = voxelSums_[find_or_insert(key)];
+	sum.x += run.x;
+	sum.y += run.y;
+	sum.z += run.z;
+	sum.count += run.count;
+}
+
+uint32_t VoxelDownsampler::find_or_insert(uint64_t key)
+{
+	size_t mask = keys_.size() - 1;
+
+	// Fibonacci hashing spreads neighbouring cubes, whose keys differ in few bits
+	size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+	while (generations_[slot] == generation_) {
+		if (keys_[slot] == key)
+			return voxels_[slot];
+		slot = (slot + 1) & mask;
+	}
+
+	if (2 * (voxelCount_ + 1) > keys_.size()) {
+		grow();
+		return find_or_insert(key);
+	}
+
+	uint32_t voxel = voxelCount_++;
+	if (voxel >= voxelSums_.size())
+		voxelSums_.resize(voxelSums_.size() < 1024 ? 1024 : voxelSums_.size() * 2);
+	Accumulator empty = { 0, 0, 0, 0 };
+	voxelSums_[voxel] = empty;
+
+	keys_[slot] = key;
+	voxels_[slot] = voxel;
+	generations_[slot] = generation_;
+	return voxel;
+}
+
+void VoxelDownsampler::grow()
+{
+	std::vector<uint64_t> keys(keys_.size() * 2);
+	std::vector<uint32_t> voxels(keys.size());
+	std::vector<uint32_t> generations(keys.size(), 0);
+	shift_--;
+
+	size_t mask = keys.size() - 1;
+	for (size_t i = 0; i < keys_.size(); i++) {
+		if (generations_[i] != generation_)
+			continue;
+
+		size_t slot = static_cast<size_t>((keys_[i] * 0x9E3779B97F4A7C15ull) >> shift_);
+		while (generations[slot] == generation_)
+			slot = (slot + 1) & mask;
+		keys[slot] = keys_[i];
+		voxels[slot] = voxels_[i];
+		generations[slot] = generation_;
+	}
+
+	keys_.swap(keys);
+	voxels_.swap(voxels);
+	generations_.swap(generations);
+}
+
+size_t VoxelDownsampler::finish()
+{
+	// Only grows; later frames with as many voxels reuse the space
+	if (x_.size() < voxelCount_) {
+		x_.resize(voxelCount_);
+		y_.resize(voxelCount_);
+		z_.resize(voxelCount_);
+		counts_.resize(voxelCount_);
+	}
+
+	for (uint32_t i = 0; i < voxelCount_; i++) {
+		const Accumulator& sum = voxelSums_[i];
+		x_[i] = static_cast<float>(sum.x / sum.count);
+		y_[i] = static_cast<float>(sum.y / sum.count);
+		z_[i] = static_cast<float>(sum.z / sum.count);
+		counts_[i] = sum.count;
+	}
+	centroidCount_ = voxelCount_;
+	return centroidCount_;
+}
+
+size_t VoxelDownsampler::downsample(const astra::Vector3f* points, size_t count)
+{
+	begin_frame();
+	add(points, count);
+	return finish();
+}
@@ -0,0 +1,101 @@
+#ifndef VOXELGRID_H
+#define VOXELGRID_H
+
+#include <astra/astra.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const float VOXEL_DEFAULT_LEAF_SIZE = 20.0f;
+const float VOXEL_MIN_LEAF_SIZE = 1.0f;
+
+/*
+	Voxel-grid downsampling of point clouds in mm, such as a PointFrame's
+	points or the output of DepthToWorld. Space is cut into cubes of the leaf
+	size and every occupied cube becomes one point at the centroid of the
+	points inside it, together with how many there were.
+
+	Cubes are found through a flat open-addressed table keyed on the packed
+	cube coordinates. Slots are invalidated per frame by a generation number
+	instead of being cleared, and every buffer is kept between frames, so
+	once the table has grown to fit a scene a frame allocates nothing.
+
+	Points without depth (z <= 0) and points more than about a million leaves
+	from the origin are skipped. Voxels come out in the order they were first
+	seen, so the output only depends on the input.
+*/
+class VoxelDownsampler
+{
+public:
+	explicit VoxelDownsampler(float leafSize = VOXEL_DEFAULT_LEAF_SIZE);
+
+	float leaf_size() const { return leafSize_; }
+	void set_leaf_size(float leafSize);
+
+	// Starts a new cloud; the previous results stay readable until finish()
+	void begin_frame();
+
+	void add(const float* x, const float* y, const float* z, size_t count);
+	void add(const astra::Vector3f* points, size_t count);
+
+	// Computes the centroids of everything added since begin_frame()
+	size_t finish();
+
+	// begin_frame(), add() and finish() in one call
+	size_t downsample(const astra::Vector3f* points, size_t count);
+
+	// Results of the last finish(), size() entries each
+	size_t size() const { return centroidCount_; }
+	const float* x() const { return x_.data(); }
+	const float* y() const { return y_.data(); }
+	const float* z() const { return z_.data(); }
+	const uint32_t* counts() const { return counts_.data(); }
+
+	// Points added to the current frame and how many of them were skipped
+	uint64_t points_added() const { return pointsAdded_; }
+	uint64_t points_skipped() const { return pointsSkipped_; }
+
+private:
+	// Sums in double: a float loses millimetres once a few thousand points
+	// at several metres land in one voxel
+	struct Accumulator
+	{
+		double x;
+		double y;
+		double z;
+		uint32_t count;
+	};
+
+	template<typename Points>
+	void add_points(const Points& points, size_t count);
+	void flush_run(uint64_t key, const Accumulator& run);
+	uint32_t find_or_insert(uint64_t key);
+	void grow();
+
+	float leafSize_;
+	float inverseLeaf_;
+
+	// Table slots: the packed key, the voxel it maps to and the generation that
+	// wrote it. A slot from an older generation is empty.
+	std::vector<uint64_t> keys_;
+	std::vector<uint32_t> voxels_;
+	std::vector<uint32_t> generations_;
+	uint32_t generation_ = 1;
+	int shift_ = 0;
+
+	// Per voxel of the current frame, in first-seen order
+	std::vector<Accumulator> voxelSums_;
+	uint32_t voxelCount_ = 0;
+
+
+	std::vector<float> x_;
+	std::vector<float> y_;
+	std::vector<float> z_;
+	std::vector<uint32_t> counts_;
+	size_t centroidCount_ = 0;
+
+	uint64_t pointsAdded_ = 0;
+	uint64_t pointsSkipped_ = 0;
+};
+
+#endif /* VOXELGRID_H */
@@ -0,0 +1,215 @@
+#include <common/clock/Stopwatch.h>
+#include <chrono>
+
+using std::map;
+using std::string;
+using std::ostream;
+using std::endl;
+
+Stopwatch::Stopwatch() : mode(REAL_TIME), active(true) {
+	records_of = new map<string, PerformanceData>();
+}
+
+Stopwatch::~Stopwatch() {
+	delete records_of;
+}
+
+bool Stopwatch::performance_exists(string perf_name) {
+	return (records_of->find(perf_name) != records_of->end());
+}
+
+void Stopwatch::set_mode(StopwatchMode new_mode) {
+	mode = new_mode;
+}
+
+long double Stopwatch::take_time() {
+	if (mode == CPU_TIME) {
+		// Use ctime
+		return static_cast<long double>(clock()) / CLOCKS_PER_SEC;
+	}
+	else if (mode == REAL_TIME) {
+		// Monotonic wall clock, in seconds
+		auto now = std::chrono::steady_clock::now().time_since_epoch();
+		return std::chrono::duration_cast<std::chrono::duration<long double>>(now).count();
+	}
+
+	return 0;
+}
+
+void Stopwatch::start(string perf_name) {
+	if (!active) return;
+
+	if (!performance_exists(perf_name)) {
+		(*records_of)[perf_name] = PerformanceData();
+	}
+
+	PerformanceData& perf_info = records_of->find(perf_name)->second;
+	perf_info.clock_start = take_time();
+}
+
+void Stopwatch::stop(string perf_name) {
+	if (!active) return;
+
+	long double clock_end = take_time();
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	PerformanceData& perf_info = records_of->find(perf_name)->second;
+
+	perf_info.stops++;
+	long double lapse = clock_end - perf_info.clock_start;
+
+	// Time measured before a pause counts towards this lapse
+	if (perf_info.paused) {
+		lapse += perf_info.last_time;
+		perf_info.paused = false;
+	}
+
+	// Update last time
+	perf_info.last_time = lapse;
+
+	// Update min/max time
+	if (lapse >= perf_info.max_time)
+		perf_info.max_time = lapse;
+	if (lapse <= perf_info.min_time || perf_info.min_time == 0)
+		perf_info.min_time = lapse;
+
+	// Update total time
+	perf_info.total_time += lapse;
+}
+
+void Stopwatch::pause(string perf_name) {
+	if (!active) return;
+
+	long double clock_end = take_time();
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	PerformanceData& perf_info = records_of->find(perf_name)->second;
+
+	long double lapse = clock_end - perf_info.clock_start;
+
+	// Accumulate until the next stop
+	if (!perf_info.paused) {
+		perf_info.last_time = 0;
+		perf_info.paused = true;
+	}
+	perf_info.last_time += lapse;
+}
+
+void Stopwatch::reset(string perf_name) {
+	if (!active) return;
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	records_of->find(perf_name)->second = PerformanceData();
+}
+
+void Stopwatch::reset_all() {
+	if (!active) return;
+
+	records_of->clear();
+}
+
+void Stopwatch::report(string perf_name, ostream& output) {
+	if (!active) return;
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	PerformanceData& perf_info = records_of->find(perf_name)->second;
+
+	output << "Performance: " << perf_name << endl;
+	output << "  Total time: " << perf_info.total_time << " s" << endl;
+	output << "  Average time: " << get_average_time(perf_name) << " s" << endl;
+	output << "  Min time: " << perf_info.min_time << " s" << endl;
+	output << "  Max time: " << perf_info.max_time << " s" << endl;
+	output << "  Last time: " << perf_info.last_time << " s" << endl;
+	output << "  Stops: " << perf_info.stops << endl;
+}
+
+void Stopwatch::report_all(ostream& output) {
+	if (!active) return;
+
+	for (auto it = records_of->begin(); it != records_of->end(); ++it)
+		report(it->first, output);
+}
+
+long double Stopwatch::get_total_time(string perf_name) {
+	if (!active) return 0;
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	return records_of->find(perf_name)->second.total_time;
+}
+
+long double Stopwatch::get_average_time(string perf_name) {
+	if (!active) return 0;
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	PerformanceData& perf_info = records_of->find(perf_name)->second;
+	if (perf_info.stops == 0)
+		return 0;
+
+	return perf_info.total_time / perf_info.stops;
+}
+
+long double Stopwatch::get_min_time(string perf_name) {
+	if (!active) return 0;
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	return records_of->find(perf_name)->second.min_time;
+}
+
+long double Stopwatch::get_max_time(string perf_name) {
+	if (!active) return 0;
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	return records_of->find(perf_name)->second.max_time;
+}
+
+long double Stopwatch::get_last_time(string perf_name) {
+	if (!active) return 0;
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	return records_of->find(perf_name)->second.last_time;
+}
+
+long double Stopwatch::get_time_so_far(string perf_name) {
+	if (!active) return 0;
+
+	// Try to recover performance data
+	if (!performance_exists(perf_name))
+		throw StopwatchException("Performance not initialized.");
+
+	return take_time() - records_of->find(perf_name)->second.clock_start;
+}
+
+void Stopwatch::turn_off() {
+	active = false;
+}
+
+void Stopwatch::turn_on() {
+	active = true;
+}
@@ -0,0 +1,268 @@
+#include "ChunkedFrameOutputStream.h"
+#include "StreamFileFormat.h"
+#include <common/serialization/FrameStreamWriter.h>
+#include <cstring>
+
+namespace astra { namespace serialization {
+
+    static_assert(sizeof(int32_t) * 2 == CHUNK_INDEX_ENTRY_SIZE, "chunk index entries are two 32-bit fields");
+
+    FrameOutputStream* open_chunked_frame_output_stream(FILE* file)
+    {
+        if (file == nullptr)
+        {
+            return nullptr;
+        }
+
+        uint32_t version = STREAM_FILE_CHUNKED_VERSION;
+        if (fwrite(STREAM_FILE_MAGIC, 1, sizeof(STREAM_FILE_MAGIC), file) != sizeof(STREAM_FILE_MAGIC) ||
+            fwrite(&version, sizeof(version), 1, file) != 1)
+        {
+            fclose(file);
+            return nullptr;
+        }
+
+        return new ChunkedFrameOutputStream(file);
+    }
+
+    ChunkedFrameOutputStream::ChunkedFrameOutputStream(FILE* file,
+                                                       size_t chunkCount,
+                                                       size_t chunkBytes,
+                                                       double flushInterval)
+        : m_file(file),
+          m_chunkBytes(chunkBytes),
+          m_flushInterval(std::chrono::duration_cast<clock_type::duration>(
+              std::chrono::duration<double>(flushInterval)))
+    {
+        // Everything the producer touches is allocated here, none of it later
+        m_free.reserve(chunkCount);
+        m_full.reserve(chunkCount);
+        for (size_t i = 0; i < chunkCount; i++)
+        {
+            std::unique_ptr<Chunk> chunk(new Chunk());
+            chunk->payload.resize(chunkBytes);
+            chunk->index.resize(CHUNK_MAX_FRAMES);
+            m_free.push_back(chunk.get());
+            m_chunks.push_back(std::move(chunk));
+        }
+
+        m_thread = std::thread(&ChunkedFrameOutputStream::run, this);
+    }
+
+    ChunkedFrameOutputStream::~ChunkedFrameOutputStream()
+    {
+        close();
+    }
+
+    void ChunkedFrameOutputStream::close()
+    {
+        if (m_file == nullptr)
+        {
+            return;
+        }
+
+        seal_current();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+
+        fclose(m_file);
+        m_file = nullptr;
+    }
+
+    void ChunkedFrameOutputStream::stage_frame(Frame& frame)
+    {
+        m_frame = &frame;
+    }
+
+    void ChunkedFrameOutputStream::stage_frame_description(FrameDescription& frameDesc)
+    {
+        m_frameDescription = &frameDesc;
+    }
+
+    void ChunkedFrameOutputStream::stage_stream_header(StreamHeader& streamHeader)
+    {
+        m_streamHeader = &streamHeader;
+    }
+
+    bool ChunkedFrameOutputStream::write_stream_header()
+    {
+        if (m_streamHeader == nullptr || m_file == nullptr)
+        {
+            return false;
+        }
+
+        // No chunk has been handed to the writer thread yet, so the file is still ours
+        int32_t frameType = m_streamHeader->frameType;
+        return fwrite(&frameType, sizeof(frameType), 1, m_file) == 1;
+    }
+
+    bool ChunkedFrameOutputStream::write_frame_description()
+    {
+        m_entryChunk = nullptr;
+        if (m_frameDescription == nullptr || m_file == nullptr || m_hasFailed)
+        {
+            return false;
+        }
+
+        int32_t bufferLength = m_frameDescription->bufferLength;
+        if (bufferLength < 0)
+        {
+            return false;
+        }
+
+        Chunk* chunk = reserve_entry(FRAME_DESCRIPTION_SIZE + FRAME_HEADER_SIZE + static_cast<size_t>(bufferLength));
+        if (chunk == nullptr)
+        {
+            return false;
+        }
+
+        double framePeriod = m_frameDescription->framePeriod;
+        m_entryChunk = chunk;
+        m_entryOffset = chunk->length;
+        append(*chunk, &framePeriod, sizeof(framePeriod));
+        append(*chunk, &bufferLength, sizeof(bufferLength));
+        return true;
+    }
+
+    bool ChunkedFrameOutputStream::write_frame()
+    {
+        Chunk* chunk = m_entryChunk;
+        m_entryChunk = nullptr;
+        if (chunk == nullptr || m_frame == nullptr)
+        {
+            return false;
+        }
+
+        // The description reserved room for bufferLength bytes; anything else is rolled back
+        int32_t byteLength = m_frame->byteLength;
+        if (byteLength < 0 || chunk->length + FRAME_HEADER_SIZE + byteLength > chunk->payload.size())
+        {
+            chunk->length = m_entryOffset;
+            return false;
+        }
+
+        int32_t frameIndex = m_frame->frameIndex;
+        append(*chunk, &byteLength, sizeof(byteLength));
+        append(*chunk, &frameIndex, sizeof(frameIndex));
+        append(*chunk, m_frame->rawFrameWrapper, byteLength);
+
+        IndexEntry& entry = chunk->index[chunk->frameCount++];
+        entry.frameIndex = frameIndex;
+        entry.offset = static_cast<uint32_t>(m_entryOffset);
+
+        if (chunk->frameCount == chunk->index.size())
+        {
+            seal_current();
+        }
+        return true;
+    }
+
+    ChunkedFrameOutputStream::Chunk* ChunkedFrameOutputStream::reserve_entry(size_t entryLength)
+    {
+        if (entryLength > m_chunkBytes)
+        {
+            return nullptr;
+        }
+
+        clock_type::time_point now = clock_type::now();
+        if (m_current != nullptr &&
+            (m_current->length + entryLength > m_current->payload.size() ||
+             now - m_current->opened >= m_flushInterval))
+        {
+            seal_current();
+        }
+
+        if (m_current == nullptr)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_free.empty())
+                {
+                    return nullptr;
+                }
+                m_current = m_free.back();
+                m_free.pop_back();
+            }
+
+            m_current->length = 0;
+            m_current->frameCount = 0;
+            m_current->opened = now;
+        }
+        return m_current;
+    }
+
+    void ChunkedFrameOutputStream::seal_current()
+    {
+        // An empty chunk stays open rather than costing a buffer and a chunk header
+        if (m_current == nullptr || m_current->frameCount == 0)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_full.push_back(m_current);
+        }
+        m_current = nullptr;
+        m_wake.notify_one();
+    }
+
+    void ChunkedFrameOutputStream::append(Chunk& chunk, const void* data, size_t length)
+    {
+        memcpy(chunk.payload.data() + chunk.length, data, length);
+        chunk.length += length;
+    }
+
+    void ChunkedFrameOutputStream::run()
+    {
+        std::vector<Chunk*> writing;
+        writing.reserve(m_chunks.size());
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return !m_full.empty() || m_isStopping; });
+                if (m_full.empty())
+                {
+                    break;
+                }
+                writing.swap(m_full);
+            }
+
+            for (Chunk* chunk : writing)
+            {
+                if (!m_hasFailed && !write_chunk(*chunk))
+                {
+                    m_hasFailed = true;
+                }
+            }
+            if (!m_hasFailed && fflush(m_file) != 0)
+            {
+                m_hasFailed = true;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_free.insert(m_free.end(), writing.begin(), writing.end());
+            }
+            writing.clear();
+        }
+    }
+
+    bool ChunkedFrameOutputStream::write_chunk(const Chunk& chunk)
+    {
+        uint32_t frameCount = chunk.frameCount;
+        uint32_t payloadLength = static_cast<uint32_t>(chunk.length);
+
+        return fwrite(CHUNK_MAGIC, 1, sizeof(CHUNK_MAGIC), m_file) == sizeof(CHUNK_MAGIC) &&
+            fwrite(&frameCount, sizeof(frameCount), 1, m_file) == 1 &&
+            fwrite(&payloadLength, sizeof(payloadLength), 1, m_file) == 1 &&
+            fwrite(chunk.index.data(), sizeof(IndexEntry), frameCount, m_file) == frameCount &&
+            fwrite(chunk.payload.data(), 1, chunk.length, m_file) == chunk.length;
+    }
+}}
@@ -0,0 +1,106 @@
+#ifndef CHUNKEDFRAMEOUTPUTSTREAM_H
+#define CHUNKEDFRAMEOUTPUTSTREAM_H
+
+#include <common/serialization/FrameOutputStream.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace astra { namespace serialization {
+
+    // 13 frames of 640x480 depth per chunk, so about 3.4 s of buffering at 30 fps
+    const size_t CHUNK_DEFAULT_COUNT = 8;
+    const size_t CHUNK_DEFAULT_BYTES = 8 * 1024 * 1024;
+    const double CHUNK_DEFAULT_FLUSH_INTERVAL = 1.0;
+    const uint32_t CHUNK_MAX_FRAMES = 1024;
+
+    /*
+        Writes version 2 (chunked) stream files without ever blocking the thread
+        that produces the frames.
+
+        Frames are copied into one of a fixed set of chunk buffers allocated up
+        front. A chunk is handed to a background thread once it is full or has been
+        open for flushInterval seconds, and that thread writes it out together with
+        its frame index and flushes the file. When every buffer is still waiting for
+        the disk the frame is dropped and write_frame() returns false.
+
+        The producer side (stage_*, write_*) must stay on one thread. The stream
+        header has to be written before the first frame.
+    */
+    class ChunkedFrameOutputStream : public FrameOutputStream
+    {
+    public:
+        ChunkedFrameOutputStream(FILE* file,
+                                 size_t chunkCount = CHUNK_DEFAULT_COUNT,
+                                 size_t chunkBytes = CHUNK_DEFAULT_BYTES,
+                                 double flushInterval = CHUNK_DEFAULT_FLUSH_INTERVAL);
+        virtual ~ChunkedFrameOutputStream();
+
+        virtual void stage_frame(Frame& frame) override;
+        virtual void stage_frame_description(FrameDescription& frameDesc) override;
+        virtual void stage_stream_header(StreamHeader& streamHeader) override;
+        virtual bool write_frame() override;
+        virtual bool write_frame_description() override;
+        virtual bool write_stream_header() override;
+
+        // Hands over the open chunk, waits until everything is on disk and closes the file
+        void close();
+
+    private:
+        using clock_type = std::chrono::steady_clock;
+
+        struct IndexEntry
+        {
+            int32_t frameIndex;
+            uint32_t offset;
+        };
+
+        struct Chunk
+        {
+            std::vector<char> payload;
+            size_t length{ 0 };
+            std::vector<IndexEntry> index;
+            uint32_t frameCount{ 0 };
+            clock_type::time_point opened;
+        };
+
+        Chunk* reserve_entry(size_t entryLength);
+        void seal_current();
+        void append(Chunk& chunk, const void* data, size_t length);
+
+        void run();
+        bool write_chunk(const Chunk& chunk);
+
+        FILE* m_file;
+        size_t m_chunkBytes;
+        clock_type::duration m_flushInterval;
+
+        Frame* m_frame{ nullptr };
+        FrameDescription* m_frameDescription{ nullptr };
+        StreamHeader* m_streamHeader{ nullptr };
+
+        std::vector<std::unique_ptr<Chunk>> m_chunks;
+
+        // Producer only: chunk being filled, and where the staged entry starts in it
+        Chunk* m_current{ nullptr };
+        Chunk* m_entryChunk{ nullptr };
+        size_t m_entryOffset{ 0 };
+
+        // Guarded by m_mutex, which is only ever held to move chunk pointers around
+        std::vector<Chunk*> m_free;
+        std::vector<Chunk*> m_full;
+        bool m_isStopping{ false };
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+        std::atomic<bool> m_hasFailed{ false };
+    };
+}}
+
+#endif /* CHUNKEDFRAMEOUTPUTSTREAM_H */
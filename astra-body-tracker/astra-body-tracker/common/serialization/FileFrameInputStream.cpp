@@ -0,0 +1,201 @@
+#include "FileFrameInputStream.h"
+#include "StreamFileFormat.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define fseek64 _fseeki64
+#define ftell64 _ftelli64
+#else
+#define fseek64 fseeko
+#define ftell64 ftello
+#endif
+
+namespace astra { namespace serialization {
+
+    FrameInputStream* open_frame_input_stream(const char* path)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr)
+        {
+            throw ResourceNotFoundException(path);
+        }
+
+        char magic[4];
+        uint32_t version = 0;
+        if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+            fread(&version, sizeof(version), 1, file) != 1 ||
+            memcmp(magic, STREAM_FILE_MAGIC, sizeof(magic)) != 0 ||
+            (version != STREAM_FILE_VERSION && version != STREAM_FILE_CHUNKED_VERSION))
+        {
+            fclose(file);
+            throw ResourceNotFoundException(path);
+        }
+
+        return new FileFrameInputStream(file, version);
+    }
+
+    FileFrameInputStream::FileFrameInputStream(FILE* file, uint32_t version)
+        : m_file(file),
+          m_isChunked(version == STREAM_FILE_CHUNKED_VERSION)
+    {
+        m_frame.byteLength = 0;
+        m_frame.frameIndex = 0;
+        m_frame.rawFrameWrapper = nullptr;
+    }
+
+    FileFrameInputStream::~FileFrameInputStream()
+    {
+        close();
+    }
+
+    void FileFrameInputStream::close()
+    {
+        if (m_file != nullptr)
+        {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    bool FileFrameInputStream::read_bytes(void* data, size_t length)
+    {
+        return m_file != nullptr && fread(data, 1, length, m_file) == length;
+    }
+
+    bool FileFrameInputStream::read_chunk_header()
+    {
+        do
+        {
+            char magic[4];
+            uint32_t frameCount;
+            uint32_t payloadLength;
+            if (!read_bytes(magic, sizeof(magic)) ||
+                !read_bytes(&frameCount, sizeof(frameCount)) ||
+                !read_bytes(&payloadLength, sizeof(payloadLength)) ||
+                memcmp(magic, CHUNK_MAGIC, sizeof(magic)) != 0)
+            {
+                return false;
+            }
+
+            int64_t indexLength = static_cast<int64_t>(frameCount) * CHUNK_INDEX_ENTRY_SIZE;
+            int64_t skip = frameCount > 0 ? indexLength : indexLength + payloadLength;
+            if (fseek64(m_file, skip, SEEK_CUR) != 0)
+            {
+                return false;
+            }
+            m_chunkFramesLeft = frameCount;
+        } while (m_chunkFramesLeft == 0);
+
+        return true;
+    }
+
+    bool FileFrameInputStream::read_stream_header(StreamHeader*& streamHeader)
+    {
+        int32_t frameType;
+        if (!read_bytes(&frameType, sizeof(frameType)))
+        {
+            return false;
+        }
+
+        m_streamHeader.frameType = frameType;
+        streamHeader = &m_streamHeader;
+        return true;
+    }
+
+    bool FileFrameInputStream::read_frame_description(FrameDescription*& frameDescription)
+    {
+        if (m_isChunked && m_chunkFramesLeft == 0 && !read_chunk_header())
+        {
+            return false;
+        }
+
+        double framePeriod;
+        int32_t bufferLength;
+        if (!read_bytes(&framePeriod, sizeof(framePeriod)) ||
+            !read_bytes(&bufferLength, sizeof(bufferLength)))
+        {
+            return false;
+        }
+
+        if (m_isChunked)
+        {
+            m_chunkFramesLeft--;
+        }
+
+        m_frameDescription.framePeriod = framePeriod;
+        m_frameDescription.bufferLength = bufferLength;
+        frameDescription = &m_frameDescription;
+        return true;
+    }
+
+    bool FileFrameInputStream::read_frame(Frame*& frame)
+    {
+        int32_t byteLength;
+        int32_t frameIndex;
+        if (!read_bytes(&byteLength, sizeof(byteLength)) ||
+            !read_bytes(&frameIndex, sizeof(frameIndex)) ||
+            byteLength < 0)
+        {
+            return false;
+        }
+
+        if (m_buffer.size() < static_cast<size_t>(byteLength))
+        {
+            m_buffer.resize(byteLength);
+        }
+        if (byteLength > 0 && !read_bytes(m_buffer.data(), byteLength))
+        {
+            return false;
+        }
+
+        m_frame.byteLength = byteLength;
+        m_frame.frameIndex = frameIndex;
+        m_frame.rawFrameWrapper = m_buffer.data();
+        frame = &m_frame;
+        return true;
+    }
+
+    bool FileFrameInputStream::seek(int offset)
+    {
+        return m_file != nullptr && fseek64(m_file, offset, SEEK_CUR) == 0;
+    }
+
+    bool FileFrameInputStream::seek_to_first_frame()
+    {
+        m_chunkFramesLeft = 0;
+        return m_file != nullptr &&
+            fseek64(m_file, STREAM_FILE_HEADER_SIZE + STREAM_HEADER_SIZE, SEEK_SET) == 0;
+    }
+
+    int64_t FileFrameInputStream::get_position()
+    {
+        return m_file != nullptr ? static_cast<int64_t>(ftell64(m_file)) : -1;
+    }
+
+    bool FileFrameInputStream::is_end_of_file()
+    {
+        if (m_file == nullptr)
+        {
+            return true;
+        }
+
+        // feof only trips after a failed read, so peek one byte ahead
+        int c = fgetc(m_file);
+        if (c == EOF)
+        {
+            return true;
+        }
+        ungetc(c, m_file);
+        return false;
+    }
+
+    int FileFrameInputStream::get_frame_description_size()
+    {
+        return FRAME_DESCRIPTION_SIZE;
+    }
+
+    int FileFrameInputStream::get_stream_header_size()
+    {
+        return STREAM_HEADER_SIZE;
+    }
+}}
@@ -0,0 +1,47 @@
+#ifndef FILEFRAMEINPUTSTREAM_H
+#define FILEFRAMEINPUTSTREAM_H
+
+#include <common/serialization/FrameInputStream.h>
+#include <cstdio>
+#include <vector>
+
+namespace astra { namespace serialization {
+
+    class FileFrameInputStream : public FrameInputStream
+    {
+    public:
+        // version is the file format version read from the file header
+        FileFrameInputStream(FILE* file, uint32_t version);
+        virtual ~FileFrameInputStream();
+
+        virtual void close() override;
+        virtual bool read_frame(Frame*& frame) override;
+        virtual bool read_frame_description(FrameDescription*& frameDescription) override;
+        virtual bool read_stream_header(StreamHeader*& streamHeader) override;
+        virtual bool seek(int offset) override;
+        virtual bool seek_to_first_frame() override;
+        virtual int64_t get_position() override;
+        virtual bool is_end_of_file() override;
+        virtual int get_frame_description_size() override;
+        virtual int get_stream_header_size() override;
+
+    private:
+        bool read_bytes(void* data, size_t length);
+        bool read_chunk_header();
+
+        FILE* m_file;
+
+        // Chunked files are read frame by frame; the chunk headers and indexes are skipped
+        bool m_isChunked;
+        uint32_t m_chunkFramesLeft{ 0 };
+
+        StreamHeader m_streamHeader;
+        FrameDescription m_frameDescription;
+        Frame m_frame;
+
+        // Reused for every frame, grows to the largest payload seen
+        std::vector<char> m_buffer;
+    };
+}}
+
+#endif /* FILEFRAMEINPUTSTREAM_H */
@@ -0,0 +1,107 @@
+#include "FileFrameOutputStream.h"
+#include "StreamFileFormat.h"
+#include <common/serialization/FrameStreamWriter.h>
+
+namespace astra { namespace serialization {
+
+    FrameOutputStream* open_frame_output_stream(FILE* file)
+    {
+        if (file == nullptr)
+        {
+            return nullptr;
+        }
+
+        uint32_t version = STREAM_FILE_VERSION;
+        if (fwrite(STREAM_FILE_MAGIC, 1, sizeof(STREAM_FILE_MAGIC), file) != sizeof(STREAM_FILE_MAGIC) ||
+            fwrite(&version, sizeof(version), 1, file) != 1)
+        {
+            fclose(file);
+            return nullptr;
+        }
+
+        return new FileFrameOutputStream(file);
+    }
+
+    void close_frame_output_stream(FrameOutputStream*& stream)
+    {
+        delete stream;
+        stream = nullptr;
+    }
+
+    FileFrameOutputStream::FileFrameOutputStream(FILE* file)
+        : m_file(file)
+    {
+    }
+
+    FileFrameOutputStream::~FileFrameOutputStream()
+    {
+        close();
+    }
+
+    void FileFrameOutputStream::close()
+    {
+        if (m_file != nullptr)
+        {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    bool FileFrameOutputStream::write_bytes(const void* data, size_t length)
+    {
+        return m_file != nullptr && fwrite(data, 1, length, m_file) == length;
+    }
+
+    void FileFrameOutputStream::stage_frame(Frame& frame)
+    {
+        m_frame = &frame;
+    }
+
+    void FileFrameOutputStream::stage_frame_description(FrameDescription& frameDesc)
+    {
+        m_frameDescription = &frameDesc;
+    }
+
+    void FileFrameOutputStream::stage_stream_header(StreamHeader& streamHeader)
+    {
+        m_streamHeader = &streamHeader;
+    }
+
+    bool FileFrameOutputStream::write_stream_header()
+    {
+        if (m_streamHeader == nullptr)
+        {
+            return false;
+        }
+
+        int32_t frameType = m_streamHeader->frameType;
+        return write_bytes(&frameType, sizeof(frameType));
+    }
+
+    bool FileFrameOutputStream::write_frame_description()
+    {
+        if (m_frameDescription == nullptr)
+        {
+            return false;
+        }
+
+        double framePeriod = m_frameDescription->framePeriod;
+        int32_t bufferLength = m_frameDescription->bufferLength;
+        return write_bytes(&framePeriod, sizeof(framePeriod)) &&
+            write_bytes(&bufferLength, sizeof(bufferLength));
+    }
+
+    bool FileFrameOutputStream::write_frame()
+    {
+        if (m_frame == nullptr)
+        {
+            return false;
+        }
+
+        int32_t byteLength = m_frame->byteLength;
+        int32_t frameIndex = m_frame->frameIndex;
+        return write_bytes(&byteLength, sizeof(byteLength)) &&
+            write_bytes(&frameIndex, sizeof(frameIndex)) &&
+            write_bytes(m_frame->rawFrameWrapper, byteLength);
+    }
+}}
@@ -0,0 +1,35 @@
+#ifndef FILEFRAMEOUTPUTSTREAM_H
+#define FILEFRAMEOUTPUTSTREAM_H
+
+#include <common/serialization/FrameOutputStream.h>
+#include <cstdio>
+
+namespace astra { namespace serialization {
+
+    class FileFrameOutputStream : public FrameOutputStream
+    {
+    public:
+        FileFrameOutputStream(FILE* file);
+        virtual ~FileFrameOutputStream();
+
+        virtual void stage_frame(Frame& frame) override;
+        virtual void stage_frame_description(FrameDescription& frameDesc) override;
+        virtual void stage_stream_header(StreamHeader& streamHeader) override;
+        virtual bool write_frame() override;
+        virtual bool write_frame_description() override;
+        virtual bool write_stream_header() override;
+
+        void close();
+
+    private:
+        bool write_bytes(const void* data, size_t length);
+
+        FILE* m_file;
+
+        Frame* m_frame{ nullptr };
+        FrameDescription* m_frameDescription{ nullptr };
+        StreamHeader* m_streamHeader{ nullptr };
+    };
+}}
+
+#endif /* FILEFRAMEOUTPUTSTREAM_H */
@@ -0,0 +1,134 @@
+#include <common/serialization/FrameStreamReader.h>
+
+namespace astra { namespace serialization {
+
+    FrameStreamReader::FrameStreamReader(FrameInputStream* frameStream)
+        : m_inputStream(frameStream),
+          m_frameDescription(nullptr),
+          m_streamHeader(nullptr),
+          m_frame(nullptr)
+    {
+        if (!m_inputStream->read_stream_header(m_streamHeader))
+        {
+            m_streamHeader = nullptr;
+            m_isEndOfFile = true;
+        }
+
+        m_pulser.start();
+    }
+
+    FrameStreamReader::~FrameStreamReader()
+    {
+        close();
+    }
+
+    void FrameStreamReader::close()
+    {
+        if (m_inputStream != nullptr)
+        {
+            m_inputStream->close();
+            delete m_inputStream;
+            m_inputStream = nullptr;
+        }
+        m_isEndOfFile = true;
+    }
+
+    void FrameStreamReader::set_paced(bool paced)
+    {
+        m_isPaced = paced;
+    }
+
+    bool FrameStreamReader::read()
+    {
+        if (m_isEndOfFile)
+        {
+            return false;
+        }
+
+        // Hold the next frame back until the recorded frame period has passed
+        if (m_isPaced && m_frameDescription != nullptr && !m_pulser.is_pulse())
+        {
+            return false;
+        }
+
+        if (!m_inputStream->read_frame_description(m_frameDescription) ||
+            !m_inputStream->read_frame(m_frame))
+        {
+            m_isEndOfFile = true;
+            return false;
+        }
+
+        m_pulser.set_period(m_frameDescription->framePeriod);
+        m_position++;
+        return true;
+    }
+
+    bool FrameStreamReader::seek(int numberOfFrames)
+    {
+        if (m_inputStream == nullptr)
+        {
+            return false;
+        }
+
+        int target = m_position + numberOfFrames;
+        if (target < 0)
+        {
+            target = 0;
+        }
+
+        // Frames differ in size, so going backwards means starting over from the first one
+        if (target < m_position)
+        {
+            if (!m_inputStream->seek_to_first_frame())
+            {
+                return false;
+            }
+            m_position = 0;
+            m_isEndOfFile = false;
+            m_frameDescription = nullptr;
+        }
+
+        while (m_position < target)
+        {
+            FrameDescription* frameDescription;
+            Frame* frame;
+            if (!m_inputStream->read_frame_description(frameDescription) ||
+                !m_inputStream->read_frame(frame))
+            {
+                m_isEndOfFile = true;
+                return false;
+            }
+            m_position++;
+        }
+        return true;
+    }
+
+    int FrameStreamReader::get_stream_type()
+    {
+        return m_streamHeader != nullptr ? m_streamHeader->frameType : -1;
+    }
+
+    int FrameStreamReader::get_buffer_length()
+    {
+        return m_frameDescription != nullptr ? m_frameDescription->bufferLength : 0;
+    }
+
+    bool FrameStreamReader::is_end_of_file()
+    {
+        if (!m_isEndOfFile && (m_inputStream == nullptr || m_inputStream->is_end_of_file()))
+        {
+            m_isEndOfFile = true;
+        }
+        return m_isEndOfFile;
+    }
+
+    Frame& FrameStreamReader::peek()
+    {
+        return *m_frame;
+    }
+
+    FrameInputStream* FrameStreamReader::get_frame_input_stream()
+    {
+        return m_inputStream;
+    }
+}}
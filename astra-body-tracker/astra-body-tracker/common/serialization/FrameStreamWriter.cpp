@@ -0,0 +1,99 @@
+#include <common/serialization/FrameStreamWriter.h>
+
+namespace astra { namespace serialization {
+
+    FrameStreamWriter::FrameStreamWriter(FrameOutputStream& frameOutputStream, double fps)
+        : m_outputStream(frameOutputStream),
+          m_fps(fps)
+    {
+        m_streamHeader.frameType = ASTRA_STREAM_DEPTH;
+    }
+
+    FrameStreamWriter::~FrameStreamWriter()
+    {
+        end_write();
+    }
+
+    bool FrameStreamWriter::begin_write()
+    {
+        if (m_shouldWrite)
+        {
+            return false;
+        }
+
+        m_outputStream.stage_stream_header(m_streamHeader);
+        if (!m_outputStream.write_stream_header())
+        {
+            return false;
+        }
+
+        m_shouldWrite = true;
+        return true;
+    }
+
+    bool FrameStreamWriter::end_write()
+    {
+        if (!m_shouldWrite)
+        {
+            return false;
+        }
+
+        m_shouldWrite = false;
+        return true;
+    }
+
+    bool FrameStreamWriter::write(const DepthFrame& depthFrame)
+    {
+        if (!m_shouldWrite || !depthFrame.is_valid())
+        {
+            return false;
+        }
+
+        // Only the pixels are kept: width x height int16 depth values in millimetres
+        astra_frame_t astraFrame;
+        astraFrame.byteLength = static_cast<uint32_t>(depthFrame.byte_length());
+        astraFrame.frameIndex = depthFrame.frame_index();
+        astraFrame.data = const_cast<int16_t*>(depthFrame.data());
+
+        stage_frame_description(astraFrame, m_fps);
+        stage_frame(astraFrame);
+
+        if (!m_outputStream.write_frame_description() || !m_outputStream.write_frame())
+        {
+            m_droppedFrames++;
+            return false;
+        }
+
+        // The next period is measured from the last frame that made it into the file
+        m_lastWriteTime = std::chrono::steady_clock::now();
+        m_writtenFrames++;
+        return true;
+    }
+
+    void FrameStreamWriter::stage_frame(astra_frame_t& astraFrame)
+    {
+        populate_frame(astraFrame, m_frame);
+        m_outputStream.stage_frame(m_frame);
+    }
+
+    void FrameStreamWriter::stage_frame_description(astra_frame_t& astraFrame, double fps)
+    {
+        populate_frame_description(astraFrame, m_frameDescription, fps);
+        m_outputStream.stage_frame_description(m_frameDescription);
+    }
+
+    void FrameStreamWriter::populate_frame(astra_frame_t& astraFrame, Frame& frame)
+    {
+        frame.byteLength = static_cast<int>(astraFrame.byteLength);
+        frame.frameIndex = astraFrame.frameIndex;
+        frame.rawFrameWrapper = astraFrame.data;
+    }
+
+    void FrameStreamWriter::populate_frame_description(astra_frame_t& astraFrame, FrameDescription& frameDescription, double fps)
+    {
+        frameDescription.framePeriod = m_writtenFrames == 0
+            ? 1.0 / fps
+            : std::chrono::duration<double>(std::chrono::steady_clock::now() - m_lastWriteTime).count();
+        frameDescription.bufferLength = static_cast<int>(astraFrame.byteLength);
+    }
+}}
@@ -0,0 +1,40 @@
+#ifndef STREAMFILEFORMAT_H
+#define STREAMFILEFORMAT_H
+
+#include <cstdint>
+
+namespace astra { namespace serialization {
+
+    /*
+        Layout of a recorded stream file. All fields are little-endian.
+
+        file header      char[4] "ASTR", uint32 version
+        stream header    int32 frameType (astra_stream_type_t)
+        then per frame:
+        description      float64 framePeriod (seconds), int32 bufferLength
+        frame            int32 byteLength, int32 frameIndex, byteLength bytes of payload
+
+        Version 2 files, written by ChunkedFrameOutputStream, group the frames into
+        chunks after the stream header:
+
+        chunk header     char[4] "CHNK", uint32 frameCount, uint32 payloadLength
+        chunk index      per frame: int32 frameIndex, uint32 offset of its description
+                         from the start of the payload
+        payload          frameCount description + frame entries laid out as above
+    */
+    const char STREAM_FILE_MAGIC[4] = { 'A', 'S', 'T', 'R' };
+    const uint32_t STREAM_FILE_VERSION = 1;
+    const uint32_t STREAM_FILE_CHUNKED_VERSION = 2;
+
+    const char CHUNK_MAGIC[4] = { 'C', 'H', 'N', 'K' };
+
+    const int STREAM_FILE_HEADER_SIZE = 8;
+    const int STREAM_HEADER_SIZE = 4;
+    const int FRAME_DESCRIPTION_SIZE = 12;
+    const int FRAME_HEADER_SIZE = 8;
+    const int CHUNK_HEADER_SIZE = 12;
+    const int CHUNK_INDEX_ENTRY_SIZE = 8;
+
+}}
+
+#endif /* STREAMFILEFORMAT_H */
@@ -6,10 +6,6 @@
 #define BOTTOM_OFFSET 0
 #define FOV_H 60
 #define FOV_V 49.5
-#define PI 3.14159265
-#define ASTRA_X 0
-#define ASTRA_Y 3349.3
-#define ASTRA_Z 0
 
 #include <astra/astra.hpp>
 #include <iostream>
@@ -18,78 +14,49 @@
 #include <Windows.h>
 #include <math.h>
 #include <chrono>
-
-char* get_joint_name(astra::Joint joint) {
-
-	char* joint_name;
-	switch (joint.type()) {
-	case astra::JointType::Head:
-		joint_name = "Head";
-		break;
-	case astra::JointType::Neck:
-		joint_name = "Neck";
-		break;
-	case astra::JointType::ShoulderSpine:
-		joint_name = "Spine Top";
-		break;
-	case astra::JointType::LeftShoulder:
-		joint_name = "Left Shoulder";
-		break;
-	case astra::JointType::LeftElbow:
-		joint_name = "Left Elbow";
-		break;
-	case astra::JointType::LeftWrist:
-		joint_name = "Left Wrist";
-		break;
-	case astra::JointType::LeftHand:
-		joint_name = "Left Hand";
-		break;
-	case astra::JointType::RightShoulder:
-		joint_name = "Right Shoulder";
-		break;
-	case astra::JointType::RightElbow:
-		joint_name = "Right Elbow";
-		break;
-	case astra::JointType::RightWrist:
-		joint_name = "Right Wrist";
-		break;
-	case astra::JointType::RightHand:
-		joint_name = "Right Hand";
-		break;
-	case astra::JointType::MidSpine:
-		joint_name = "Spine Middle";
-		break;
-	case astra::JointType::BaseSpine:
-		joint_name = "Spine Base";
-		break;
-	case astra::JointType::LeftHip:
-		joint_name = "Left Hip";
-		break;
-	case astra::JointType::LeftKnee:
-		joint_name = "Left Knee";
-		break;
-	case astra::JointType::LeftFoot:
-		joint_name = "Left Foot";
-		break;
-	case astra::JointType::RightHip:
-		joint_name = "Right Hip";
-		break;
-	case astra::JointType::RightKnee:
-		joint_name = "Right Knee";
-		break;
-	case astra::JointType::RightFoot:
-		joint_name = "Right Foot";
-		break;
-	default:
-		joint_name = "Unknown Joint";
-		break;
-	}
-	return joint_name;
-}
+#include <io.h>
+#include <fcntl.h>
+
+#include <common/serialization/FrameStreamReader.h>
+#include <common/serialization/FrameStreamWriter.h>
+#include <memory>
+#include <vector>
+#include <thread>
+
+#include "FrameRecord.h"
+#include "FrameEncoder.h"
+#include "AsyncFrameWriter.h"
+#include "BodyStateTable.h"
+#include "ShoulderAngleStats.h"
+#include "SessionFile.h"
+#include "SessionIndex.h"
+#include "PostureAnalysis.h"
+#include "StreamSink.h"
+#include "RecordingSink.h"
+#include "StreamServer.h"
+#include "UdpPublisher.h"
+#include "NetworkLibrary.h"
+#include "SharedFrameSink.h"
+#include "SinkChannel.h"
+#include "CaptureLoop.h"
+#include "JointFilter.h"
+#include "DepthWorker.h"
+#include "BodySegmentation.h"
+#include "BackSurface.h"
+#include "PipelineMetrics.h"
+#include "Benchmark.h"
+#include "TrackerOptions.h"
 
 class BodyVisualizer : public astra::FrameListener
 {
 public:
+	BodyVisualizer(AsyncFrameWriter& writer, astra::serialization::FrameStreamWriter* depthWriter = nullptr,
+		JointFilterBank* filter = nullptr)
+		: writer_(writer),
+		depthWriter_(depthWriter),
+		filter_(filter)
+	{
+	}
 
 	void processBodies(astra::Frame& frame)
 	{
@@ -105,89 +72,119 @@ public:
 		}
 	}
 
-	void log_data(astra::StreamReader& reader, astra::Frame& frame) {
+	// Returns the record queued for the writer, or nullptr when the frame was
+	// dropped. Only this thread reuses ring slots, so the record can be read
+	// until the next begin_frame().
+	const FrameRecord* log_data(astra::StreamReader& reader, astra::Frame& frame, uint64_t callbackUs) {
 
 		using namespace std;
 
 		frameNumber_++;
 		current_time_ = chrono::high_resolution_clock::now();
 		auto duration = chrono::duration_cast<chrono::milliseconds>(current_time_ - last_time_);
+		auto timestamp = chrono::duration_cast<chrono::microseconds>(current_time_ - start_time_);
 		last_time_ = current_time_;
 
-		// Get body data
+		// Only copy the body data here; encoding and writing happen on the writer thread
+		FrameRecord* record = writer_.begin_frame();
+		if (!record)
+			return nullptr;
+
 		astra::BodyFrame bodyFrame = frame.get<astra::BodyFrame>();
 		const auto& bodies = bodyFrame.bodies();
 
-		// Output position (pixel_x, pixel_y, depth) of each joint
-		double x, y, z;
-		double deg_shoulders;
-		double x_L = 10000, y_L, z_L;
-		double x_R = 10000, y_R, z_R;
-		for (auto& body : bodies)
-		{
-			if (body.joints_enabled()) {
-				cout << "{";
-				cout << "\"frame_number\": " << frameNumber_ << ",";
-				cout << "\"time\": " << duration.count() << ",";
-				cout << "\"body_id\": " << to_string(body.id()) << ",";
-				cout << "\"joints\": {";
-				bool first_joint = TRUE;
-				for (auto& joint : body.joints()) {
-					if (first_joint)
-						first_joint = FALSE;
-					else
-						cout << ",";
-					x = joint.world_position().x;
-					y = joint.world_position().y;
-					z = joint.world_position().z;
-
-					if (!(x == ASTRA_X && y == ASTRA_Y && z == ASTRA_Z)) {
-						cout << "\"" << get_joint_name(joint) << "\": {";
-						cout << "\"x\": " << x << ",";
-						cout << "\"y\": " << y << ",";
-						cout << "\"z\": " << z;
-						cout << "}";
-
-						if (get_joint_name(joint) == "Left Shoulder") {
-							x_L = x;
-							y_L = y;
-							z_L = z;
-						}
-						if (get_joint_name(joint) == "Right Shoulder") {
-							x_R = x;
-							y_R = y;
-							z_R = z;
-						}
-					}
-				}
-				cout << "}";
-				if (x_L != 10000 && x_R != 10000) {
-					deg_shoulders = asin((y_R - y_L) / (sqrt(pow((x_R - x_L), 2) + pow((y_R - y_L), 2) + pow((z_R - z_L), 2)))) * 180 / PI;
-					if (!isnan(deg_shoulders)) 
-						cout << ",\"shoulder_angle\": " << deg_shoulders;
-				}
-				x_L = 10000;
-				x_R = 10000;
-				cout << "}" << endl;
-			}
+		record->frameNumber = frameNumber_;
+		record->elapsedMs = static_cast<uint32_t>(duration.count());
+		record->timestampUs = static_cast<uint64_t>(timestamp.count());
+		extract_frame_record(bodies.data(), bodies.size(), *record, filter_);
+
+		record->timing.sdkFrameIndex = static_cast<uint32_t>(bodyFrame.frame_index());
+		record->timing.updateUs = capture_update_started_us();
+		record->timing.callbackUs = callbackUs;
+		record->timing.extractedUs = pipeline_clock_us();
+
+		writer_.commit_frame();
+		return record;
+	}
+
+	// Depth frames are retained into the pool only while something consumes them
+	void set_depth_consumer(DepthFramePool& pool, DepthConsumer& consumer) {
+
+		depthPool_ = &pool;
+		depthConsumer_ = &consumer;
+	}
+
+	// Copies the depth pixels into the recording and, once, into the pool for
+	// the depth consumer together with the body mask and the bodies of record;
+	// never waits for the disk or the analysis
+	void process_depth(astra::Frame& frame, const FrameRecord* record, uint64_t callbackUs) {
+
+		if (!depthWriter_ && !depthConsumer_)
+			return;
+
+		astra::DepthFrame depthFrame = frame.get<astra::DepthFrame>();
+		if (!depthFrame.is_valid())
+			return;
+
+		if (depthWriter_)
+			depthWriter_->write(depthFrame);
+
+		if (depthConsumer_) {
+			astra::BodyFrame bodyFrame = frame.get<astra::BodyFrame>();
+			const astra::BodyMask* mask = bodyFrame.is_valid() ? &bodyFrame.body_mask() : nullptr;
+			DepthFrameRef retained = depthPool_->retain(depthFrame, mask, record, callbackUs);
+			if (retained)
+				depthConsumer_->consume(retained);
 		}
 	}
 
+	// Feeds a frame recorded by RecordingSink through the same output path
+	void replay_frame(const astra::serialization::Frame& frame, bool wait) {
+
+		uint64_t callbackUs = pipeline_clock_us();
+		FrameRecord* record = writer_.begin_frame(wait);
+		if (!record)
+			return;
+
+		record->frameNumber = static_cast<uint32_t>(frame.frameIndex);
+		record->elapsedMs = 0;
+		record->timestampUs = 0;
+		if (!decode_binary(static_cast<const char*>(frame.rawFrameWrapper), frame.byteLength, *record))
+			record->bodyCount = 0;
+
+		record->timing.sdkFrameIndex = 0;
+		record->timing.updateUs = 0;
+		record->timing.callbackUs = callbackUs;
+		record->timing.extractedUs = pipeline_clock_us();
+
+		writer_.commit_frame();
+	}
+
 	virtual void on_frame_ready(astra::StreamReader& reader,
 		astra::Frame& frame) override
 	{
+		uint64_t callbackUs = pipeline_clock_us();
+
 		processBodies(frame);
-		log_data(reader, frame);
+		const FrameRecord* record = log_data(reader, frame, callbackUs);
+		process_depth(frame, record, callbackUs);
 	}
 
 private:
 	std::chrono::high_resolution_clock::time_point current_time_;
-	std::chrono::high_resolution_clock::time_point last_time_ = std::chrono::high_resolution_clock::now();
+	std::chrono::high_resolution_clock::time_point start_time_ = std::chrono::high_resolution_clock::now();
+	std::chrono::high_resolution_clock::time_point last_time_ = start_time_;
 
 	int frameNumber_ = 0;
+
+	AsyncFrameWriter& writer_;
+	astra::serialization::FrameStreamWriter* depthWriter_;
+	JointFilterBank* filter_;
+	DepthFramePool* depthPool_ = nullptr;
+	DepthConsumer* depthConsumer_ = nullptr;
 };
 
-astra::DepthStream configure_depth(astra::StreamReader& reader)
+astra::DepthStream configure_depth(astra::StreamReader& reader, int fps)
 {
 	auto depthStream = reader.stream<astra::DepthStream>();
 
@@ -197,35 +194,340 @@ astra::DepthStream configure_depth(astra::StreamReader& reader)
 	depthMode.set_width(640);
 	depthMode.set_height(480);
 	depthMode.set_pixel_format(astra_pixel_formats::ASTRA_PIXEL_FORMAT_DEPTH_MM);
-	depthMode.set_fps(30);
+	depthMode.set_fps(fps);
 
 	depthStream.set_mode(depthMode);
 
 	return depthStream;
 }
 
-int main(int argc, const char** argv) {
+int run_sensor(const TrackerOptions& options, BodyVisualizer& listener, BodySegmenter& segmenter) {
 
 	astra::initialize();
 
 	const char* licenseString = "<INSERT LICENSE KEY HERE>";
 	orbbec_body_tracking_set_license(licenseString);
 
-	BodyVisualizer listener;
-
 	astra::StreamSet sensor;
 	astra::StreamReader reader = sensor.create_reader();
 
-	reader.stream<astra::DepthStream>().start();
+	astra::DepthStream depthStream = configure_depth(reader, options.capture.fps);
+	depthStream.start();
 	reader.stream<astra::BodyStream>().start();
 
+	// Before the listener is added, so the first segmented frame already has it
+	segmenter.set_conversion_cache(depthStream.depth_to_world_data());
+
 	reader.add_listener(listener);
 
-	while (TRUE) {
-		astra_update();
-	}
+	run_capture_loop(options.capture);
+
+	// No more callbacks after this, so the writer can flush what is still queued
+	reader.remove_listener(listener);
 
 	astra::terminate();
 
 	return 0;
 }
+
+int run_replay(const TrackerOptions& options, BodyVisualizer& listener) {
+
+	using namespace astra::serialization;
+
+	FrameInputStream* stream;
+	try {
+		stream = open_frame_input_stream(options.replayPath.c_str());
+	}
+	catch (const ResourceNotFoundException& e) {
+		std::cerr << "cannot replay " << e.what() << std::endl;
+		return 1;
+	}
+
+	FrameStreamReader reader(stream);
+	if (reader.get_stream_type() != ASTRA_STREAM_BODY) {
+		std::cerr << "cannot replay " << options.replayPath << ": not a body recording" << std::endl;
+		return 1;
+	}
+	reader.set_paced(!options.replayFast);
+
+	while (!shutdown_requested() && !reader.is_end_of_file()) {
+		if (reader.read())
+			listener.replay_frame(reader.peek(), options.replayFast);
+		else if (!options.replayFast)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return 0;
+}
+
+// A channel in front of the sink, owned by channels; an Inline one only counts
+FrameSink& apply_policy(std::vector<std::unique_ptr<SinkChannel>>& channels, const char* name,
+	FrameSink& sink, SinkPolicy policy, int capacity) {
+
+	channels.emplace_back(new SinkChannel(name, sink, policy, capacity));
+	return *channels.back();
+}
+
+int main(int argc, const char** argv) {
+
+	TrackerOptions options;
+	if (!parse_options(argc, argv, options)) {
+		print_usage(std::cerr);
+		return 1;
+	}
+
+	if (options.benchmark) {
+		run_benchmark(options.benchmarkSettings, std::cout);
+		return 0;
+	}
+
+	if (options.analyze) {
+		std::string path = patient_file(options.patientDir, SESSION_FILE);
+		if (!analyze_session(path, std::cout)) {
+			std::cerr << "cannot read " << path << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	if (options.buildIndex && !options.convert) {
+		// The session file is indexed straight from the mapping
+		MappedSession session;
+		if (session.open(patient_file(options.patientDir, SESSION_FILE))) {
+			if (!write_session_index(patient_file(options.patientDir, SESSION_INDEX_FILE),
+				session.shoulder_angles(), session.hip_angles(), session.rows())) {
+				std::cerr << "cannot write the session index" << std::endl;
+				return 1;
+			}
+			return 0;
+		}
+	}
+
+	if (options.buildIndex || options.convert) {
+		// A capture cut short leaves its journal; older sessions have raw_data.txt
+		SessionColumns columns;
+		std::string journal = patient_file(options.patientDir, SESSION_JOURNAL_FILE);
+		std::string rawData = patient_file(options.patientDir, RAW_DATA_FILE);
+		bool fromJournal = read_session_journal(journal, columns);
+		if (!fromJournal && !read_raw_data(rawData, columns)) {
+			std::cerr << "cannot read " << journal << " or " << rawData << std::endl;
+			return 1;
+		}
+		if (options.convert && !write_session_file(patient_file(options.patientDir, SESSION_FILE), columns)) {
+			std::cerr << "cannot write the session file" << std::endl;
+			return 1;
+		}
+		if (!write_session_index(patient_file(options.patientDir, SESSION_INDEX_FILE),
+			columns.shoulderAngle.data(), columns.hipAngle.data(), columns.rows())) {
+			std::cerr << "cannot write the session index" << std::endl;
+			return 1;
+		}
+		if (options.convert && fromJournal)
+			remove(journal.c_str());
+		return 0;
+	}
+
+	bool needsNetwork = options.servePort != 0 || options.udpPort != 0 || options.format == OutputFormat::Delta;
+	if (needsNetwork && !network_library_available()) {
+		std::cerr << "--serve, --udp and --format delta need " << network_library_name() << std::endl;
+		return 1;
+	}
+
+	// Binary records and delta packets must reach the pipe without newline translation
+	if (options.format != OutputFormat::Json)
+		_setmode(_fileno(stdout), _O_BINARY);
+
+	AsyncFrameWriter writer;
+
+	// Outputs that may stall get a queue and thread of their own; every output
+	// counts its frames
+	const SinkPolicies& policies = options.sinkPolicies;
+	std::vector<std::unique_ptr<SinkChannel>> channels;
+
+	// Updated first so every sink after it sees the state including the current frame
+	BodyStateTable bodyStates;
+	writer.add_sink(bodyStates);
+
+	StreamSink output(options.format, std::cout, options.delta);
+	FrameSink& outputSink = apply_policy(channels, "stdout", output, policies.output, policies.capacity);
+	ShoulderAngleStats shoulderStats(outputSink, options.summaryFrames);
+	shoulderStats.set_body_states(bodyStates);
+	writer.add_sink(shoulderStats);
+	writer.add_sink(outputSink);
+
+	// The Electron app reads the session file and index back for the results screen
+	SessionFileSink session;
+	bool writeSession = !options.patientDir.empty();
+	std::string journalPath = patient_file(options.patientDir, SESSION_JOURNAL_FILE);
+	if (writeSession) {
+		if (!session.open_journal(journalPath)) {
+			std::cerr << "cannot write " << journalPath << std::endl;
+			return 1;
+		}
+		if (!session.open_summaries(patient_file(options.patientDir, SESSION_SUMMARY_FILE)))
+			std::cerr << "cannot write " << SESSION_SUMMARY_FILE << ", the results screen will average the frames itself" << std::endl;
+		writer.add_sink(apply_policy(channels, "session", session, SinkPolicy::Inline, policies.capacity));
+		shoulderStats.add_output(session);
+	}
+
+	astra::serialization::FrameOutputStream* recording = nullptr;
+	std::unique_ptr<RecordingSink> recordingSink;
+	if (!options.recordPath.empty()) {
+		recording = astra::serialization::open_frame_output_stream(fopen(options.recordPath.c_str(), "wb"));
+		if (!recording) {
+			std::cerr << "cannot record to " << options.recordPath << std::endl;
+			return 1;
+		}
+		recordingSink.reset(new RecordingSink(*recording, options.capture.fps));
+		writer.add_sink(apply_policy(channels, "record", *recordingSink, policies.recording, policies.capacity));
+	}
+
+	// Same records as stdout for the viewer, recorders and remote stations
+	std::unique_ptr<StreamServer> server;
+	if (options.servePort != 0) {
+		server.reset(new StreamServer(options.serveFormat, options.delta, options.serveQueue, std::cerr));
+		if (!server->start(static_cast<unsigned short>(options.servePort))) {
+			std::cerr << "cannot listen on port " << options.servePort << std::endl;
+			return 1;
+		}
+		writer.add_sink(apply_policy(channels, "serve", *server, policies.server, policies.capacity));
+	}
+
+	// Live displays that would rather lose a frame than wait for it
+	std::unique_ptr<UdpPublisher> publisher;
+	if (options.udpPort != 0) {
+		publisher.reset(new UdpPublisher(std::cerr));
+		if (!publisher->open(options.udpHost, static_cast<unsigned short>(options.udpPort))) {
+			std::cerr << "cannot resolve " << options.udpHost << std::endl;
+			return 1;
+		}
+		writer.add_sink(apply_policy(channels, "udp", *publisher, policies.udp, policies.capacity));
+	}
+
+	// Local viewers read the newest frame in place instead of parsing stdout
+	SharedFrameSink sharedFrames;
+	if (!options.sharedMemoryName.empty()) {
+		if (!sharedFrames.open(options.sharedMemoryName)) {
+			std::cerr << "cannot create shared memory " << options.sharedMemoryName << std::endl;
+			return 1;
+		}
+		writer.add_sink(apply_policy(channels, "shared-memory", sharedFrames, policies.sharedMemory, policies.capacity));
+	}
+
+	astra::serialization::FrameOutputStream* depthRecording = nullptr;
+	std::unique_ptr<astra::serialization::FrameStreamWriter> depthWriter;
+	if (!options.recordDepthPath.empty()) {
+		depthRecording = astra::serialization::open_chunked_frame_output_stream(fopen(options.recordDepthPath.c_str(), "wb"));
+		if (depthRecording)
+			depthWriter.reset(new astra::serialization::FrameStreamWriter(*depthRecording, options.capture.fps));
+		if (!depthWriter || !depthWriter->begin_write()) {
+			std::cerr << "cannot record depth to " << options.recordDepthPath << std::endl;
+			return 1;
+		}
+	}
+
+	std::ofstream metricsFile;
+	std::unique_ptr<PipelineMetrics> metrics;
+	if (!options.metricsPath.empty()) {
+		std::ostream* metricsOut = &std::cerr;
+		if (options.metricsPath != "-") {
+			metricsFile.open(options.metricsPath, std::ios::app);
+			if (!metricsFile) {
+				std::cerr << "cannot write metrics to " << options.metricsPath << std::endl;
+				return 1;
+			}
+			metricsOut = &metricsFile;
+		}
+		metrics.reset(new PipelineMetrics(*metricsOut, options.metricsInterval));
+		writer.set_metrics(metrics.get());
+		for (auto& channel : channels)
+			metrics->add_channel(*channel);
+	}
+
+	for (auto& channel : channels)
+		channel->start();
+	writer.start();
+
+	// Only sensor frames are filtered; replayed ones were filtered, if at all, when recorded
+	JointFilterBank filter(options.filter);
+	BodyVisualizer listener(writer, depthWriter.get(), &filter);
+
+	// Depth analyzers share pooled frames instead of each copying the pixels
+	DepthFramePool depthPool(DEPTH_POOL_DEFAULT_FRAMES, DEPTH_STREAM_WIDTH, DEPTH_STREAM_HEIGHT);
+	DepthWorker depthWorker;
+	BodySegmenter segmenter;
+	std::string backSurfacePath = options.patientDir.empty() ? "" : patient_file(options.patientDir, BACK_SURFACE_FILE);
+	BackSurfaceAnalyzer backSurface(options.backSurface, backSurfacePath, std::cerr);
+	if (options.backSurface.enabled)
+		segmenter.add_consumer(backSurface);
+	if (segmenter.has_consumers())
+		depthWorker.add_analyzer(segmenter);
+	if (depthWorker.has_analyzers()) {
+		depthWorker.start();
+		listener.set_depth_consumer(depthPool, depthWorker);
+	}
+
+	install_shutdown_handlers(options.watchStdin);
+
+	int result;
+	if (options.replayPath.empty())
+		result = run_sensor(options, listener, segmenter);
+	else
+		result = run_replay(options, listener);
+
+	writer.stop();
+	shoulderStats.finish();
+
+	// After the final summaries, which go through the stdout channel
+	for (auto& channel : channels) {
+		channel->stop();
+		if (channel->dropped_frames() > 0)
+			channel->report(std::cerr);
+	}
+	if (metrics)
+		metrics->report_final();
+
+	if (server) {
+		server->stop();
+		if (server->dropped_frames() > 0)
+			std::cerr << "stream server: " << server->dropped_frames() << " frames dropped for slow clients" << std::endl;
+	}
+	if (publisher && publisher->failed_datagrams() > 0)
+		std::cerr << "udp publisher: " << publisher->sent_datagrams() << " datagrams sent, "
+			<< publisher->failed_datagrams() << " failed" << std::endl;
+
+	depthWorker.stop();
+	if (depthPool.dropped_frames() > 0 || depthWorker.dropped_frames() > 0)
+		std::cerr << "depth analysis: " << depthWorker.analyzed_frames() << " frames analyzed, "
+			<< depthPool.dropped_frames() + depthWorker.dropped_frames() << " dropped" << std::endl;
+
+	if (writeSession) {
+		session.close();
+		if (session.journal_failed())
+			std::cerr << "cannot write " << journalPath << ", the session was only kept in memory" << std::endl;
+
+		const SessionColumns& columns = session.columns();
+		bool written = write_session_file(patient_file(options.patientDir, SESSION_FILE), columns);
+		if (!written)
+			std::cerr << "cannot write the session file" << std::endl;
+		if (!write_session_index(patient_file(options.patientDir, SESSION_INDEX_FILE),
+			columns.shoulderAngle.data(), columns.hipAngle.data(), columns.rows()))
+			std::cerr << "cannot write the session index" << std::endl;
+
+		// Kept for --convert until the session file is complete
+		if (written)
+			remove(journalPath.c_str());
+	}
+	astra::serialization::close_frame_output_stream(recording);
+
+	if (depthWriter) {
+		depthWriter->end_write();
+		astra::serialization::close_frame_output_stream(depthRecording);
+		if (depthWriter->dropped_frames() > 0)
+			std::cerr << "depth recording: " << depthWriter->written_frames() << " frames written, "
+				<< depthWriter->dropped_frames() << " dropped" << std::endl;
+	}
+	shutdown_complete();
+
+	return result;
+}
@@ -32,6 +32,11 @@ namespace astra { namespace serialization {
         ~FrameStreamReader();
 
         void close();
+
+        // When paced (the default) read() releases frames at the recorded frame period,
+        // otherwise as fast as they are asked for
+        void set_paced(bool paced);
+
         bool read();
         bool seek(int numberOfFrames);
         int get_stream_type();
@@ -49,6 +54,8 @@ namespace astra { namespace serialization {
         clock::Pulser m_pulser;
 
         bool m_isEndOfFile{ false };
+        bool m_isPaced{ true };
+        int m_position{ 0 };
     };
 }}
 
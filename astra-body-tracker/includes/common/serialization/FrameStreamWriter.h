@@ -22,26 +22,35 @@
 #include <astra_core/capi/plugins/astra_plugin.h>
 
 #include "StreamFileModels.h"
-#include "../clock/Stopwatch.h"
 #include "FrameOutputStream.h"
 
+#include <chrono>
 #include <memory>
 
 namespace astra { namespace serialization {
 
     FrameOutputStream* open_frame_output_stream(FILE* file);
+
+    // Chunked container meant for large frames such as depth; see ChunkedFrameOutputStream
+    FrameOutputStream* open_chunked_frame_output_stream(FILE* file);
     void close_frame_output_stream(FrameOutputStream*& stream);
 
     class FrameStreamWriter
     {
     public:
-        FrameStreamWriter(FrameOutputStream& frameOutputStream);
+        // fps only sets the period recorded for the first frame, later ones use the measured interval
+        FrameStreamWriter(FrameOutputStream& frameOutputStream, double fps = 30.0);
         ~FrameStreamWriter();
 
         bool begin_write();
         bool end_write();
+
+        // Returns false when the frame was not written, e.g. dropped by the output stream
         bool write(const DepthFrame& depthFrame);
 
+        uint64_t written_frames() const { return m_writtenFrames; }
+        uint64_t dropped_frames() const { return m_droppedFrames; }
+
     private:
         void stage_frame(astra_frame_t& astraFrame);
         void stage_frame_description(astra_frame_t& astraFrame, double fps);
@@ -50,9 +59,17 @@ namespace astra { namespace serialization {
 
         FrameOutputStream& m_outputStream;
         bool m_shouldWrite{ false };
+        double m_fps;
+
+        StreamHeader m_streamHeader;
+        FrameDescription m_frameDescription;
+        Frame m_frame;
+
+        uint64_t m_writtenFrames{ 0 };
+        uint64_t m_droppedFrames{ 0 };
 
-        Stopwatch m_swatch;
-        std::string m_swatchName;
+        // write() runs on the SDK callback, so no map lookup or string here
+        std::chrono::steady_clock::time_point m_lastWriteTime;
     };
 
 }}
@@ -10,6 +10,7 @@ var Chart = require('chart.js')
 
 var state = 'start'
 var dir = './patients'
+var tracker_path = ".\\astra-body-tracker\\x64\\Debug\\astra-body-tracker.exe"
 var patient_dirs, current_patient
 // DEV ONLY
 //var {state, current_patient} = skip()
@@ -109,8 +110,10 @@ function start(){
             "dir": dir + '/' + patient + '/'
         }
 
-        if (fs.existsSync(current_patient.dir + 'raw_data.txt')){
-            fs.unlinkSync(current_patient.dir + 'raw_data.txt')
+        for (var file of ['raw_data.txt', 'session.col', 'session.rows', 'summaries.txt', 'raw_data.idx', 'back_asymmetry.json']){
+            if (fs.existsSync(current_patient.dir + file)){
+                fs.unlinkSync(current_patient.dir + file)
+            }
         }
         state = 'astra-running'
         update()
@@ -151,7 +154,7 @@ function waiting(){
         fs.mkdirSync(current_patient.dir)
     }
 
-    const body_tracker = spawn(".\\astra-body-tracker\\x64\\Debug\\astra-body-tracker.exe", [current_patient.dir])
+    const body_tracker = spawn(tracker_path, [current_patient.dir])
 
     var display = $('#main-display')
     display.height(display.width() * 3 / 4)
@@ -167,20 +170,25 @@ function waiting(){
     display.append('<button type="button" class="btn btn-primary btn-lg btn-block" id="astra-exit">Done</button>');
     resultsAnimate()
 
+    // The tracker writes frames in batches, so a chunk can end part way through a line.
+    // Keep the unfinished tail and prepend it to the next chunk.
+    var pending = ''
     body_tracker.stdout.on('data', (data) => {
 		
-		var last_i = 0
-		for (var i = 0; i < data.length; i++){
-			if (String.fromCharCode(data[i]) == "\n"){
-				//console.log("endline")
-				frame = JSON.parse(data.slice(last_i, i))
-				last_i = i
+		var lines = (pending + data).split("\n")
+		pending = lines.pop()
+		for (var i = 0; i < lines.length; i++){
+			if (lines[i].length > 0){
+				frame = JSON.parse(lines[i])
+				// The tracker saves the session itself when it exits; summaries are not drawn
+				if (frame.summary){
+					continue
+				}
 				for (joint in frame.joints){
 					if (frame.joints[joint].z <= 400){
 						delete frame.joints[joint]
 					}
 				}
-				fs.appendFileSync(current_patient.dir + "raw_data.txt", JSON.stringify(frame) + "\n")
 				scene = addJoints(scene, frame)
 				scene = addBones(scene, frame)
 			}
@@ -188,7 +196,15 @@ function waiting(){
     })
 
     $('#astra-exit').on('click', () => {
-        body_tracker.kill()
+        // Closing stdin lets the tracker flush its output and shut the sensor down.
+        // Fall back to killing it if it has not exited after a few seconds; the rows it
+        // journalled so far are converted when the results load.
+        body_tracker.stdin.end()
+        setTimeout(() => {
+            if (body_tracker.exitCode === null){
+                body_tracker.kill()
+            }
+        }, 3000)
     })
 
     body_tracker.on('close', (code) => {
@@ -275,7 +291,9 @@ function results(){
         ></div>`);
 
         slider = new DoubleSlider(document.getElementById('frame-slider'));
-		var avg_shoulder_angle = await getAverage(frames, slider.value.min, slider.value.max)
+        // The tracker's summary already covers the whole session, which is the initial slider range
+        var totals = summaryTotals(frames.summaries)
+		var avg_shoulder_angle = totals ? totals.mean : await getAverage(frames, slider.value.min, slider.value.max)
         var avg_shoulder_result = "Average Shoulder Angle: " + avg_shoulder_angle
         var setAverage = (async () => {
             var avg_shoulder_angle = await getAverage(frames, slider.value.min, slider.value.max) 
@@ -309,7 +327,7 @@ function results(){
         var ctx = document.getElementById('shoulder_chart').getContext('2d');
         var chart_data = await getChartData(frames, slider.range);
         var chart_y = await getChartY(frames, slider.range);
-		var max_cur_frame = (await get_max_angle(frames)).toString()
+		var max_cur_frame = (totals ? Math.ceil(totals.max / 10) * 10 : await get_max_angle(frames)).toString()
 		var data1_value = await getHorizontalChart(frames, slider.range, shoulder_cutoff.toString())
 //		data1_value.push({x:0, y:shoulder_cutoff.toString()})		
 //		data1_value.push({x:(frames.length - 1).toString(), y:shoulder_cutoff.toString()})
@@ -431,6 +449,12 @@ function getChartData(frames, max){
 }
 function get_max_angle(frames){
   return new Promise((resolve) => {
+    if (frames.index){
+      // 0 like the scan below when no frame has an angle
+      var max = rangeMax(frames.index.abs_shoulder_angle, 0, frames.length - 1)
+      resolve(isNaN(max) ? 0 : Math.ceil(max / 10) * 10)
+      return
+    }
     var max_cur_frame = 0
     for (var i=0; i<=frames.length-1; ++i){
       if (Math.abs(frames[i]["shoulder_angle"]) > max_cur_frame){
@@ -467,8 +491,31 @@ function getHorizontalChart(frames, max, cutoff){
   })
 }
 
+// Combines the latest summary of every body into the session mean and max of |shoulder_angle|
+function summaryTotals(summaries){
+    var count = 0
+    var sum = 0
+    var max = 0
+    for (var id in summaries){
+        var summary = summaries[id]
+        if (summary.count > 0){
+            count += summary.count
+            sum += summary.count * summary.abs_shoulder_angle.mean
+            max = Math.max(max, summary.abs_shoulder_angle.max)
+        }
+    }
+    if (count == 0){
+        return null
+    }
+    return {"count": count, "mean": sum / count, "max": max}
+}
+
 function getAverage(frames, min, max){
   return new Promise((resolve) => {
+    if (frames.index){
+      resolve(rangeMean(frames.index.abs_shoulder_angle, Number(min), Number(max)))
+      return
+    }
 	var sum = 0
 	var range = 0
 	var cur_angle = 0
@@ -485,6 +532,210 @@ function getAverage(frames, min, max){
 	
 }
 
+// Reads the raw_data.idx sidecar the tracker writes next to the session (layout in
+// SessionIndex.h). Returns null when it is missing or does not match the frames.
+function loadSessionIndex(path, frame_count){
+    if (!fs.existsSync(path)){
+        return null
+    }
+    var file = fs.readFileSync(path)
+    if (file.length < 32 || file.toString('ascii', 0, 4) !== 'AIDX'){
+        return null
+    }
+    var data = file.buffer.slice(file.byteOffset, file.byteOffset + file.length)
+    var header = new Uint32Array(data, 0, 8)
+    var n = header[2], series_count = header[3], block_size = header[4], block_count = header[5], levels = header[6]
+    if (header[1] !== 1 || n !== frame_count){
+        return null
+    }
+
+    var padded = (bytes) => Math.ceil(bytes / 8) * 8
+    var offset = 32
+    var index = {}
+    for (var s = 0; s < series_count; s++){
+        var name = file.toString('ascii', offset, offset + 32).replace(/\0.*$/, '')
+        offset += 32
+        var series = {"block_size": block_size, "block_min": [], "block_max": []}
+        series.offset = new Float64Array(data, offset, 1)[0]
+        offset += 8
+        series.count = new Float64Array(data, offset, n + 1)
+        offset += (n + 1) * 8
+        series.sum = new Float64Array(data, offset, n + 1)
+        offset += (n + 1) * 8
+        series.sum_squares = new Float64Array(data, offset, n + 1)
+        offset += (n + 1) * 8
+        series.values = new Float32Array(data, offset, n)
+        offset += padded(n * 4)
+        for (var k = 0; k < levels; k++){
+            series.block_min.push(new Float32Array(data, offset + k * block_count * 4, block_count))
+        }
+        offset += padded(levels * block_count * 4)
+        for (var k = 0; k < levels; k++){
+            series.block_max.push(new Float32Array(data, offset + k * block_count * 4, block_count))
+        }
+        offset += padded(levels * block_count * 4)
+        index[name] = series
+    }
+    return index
+}
+
+// Mean of the series over frames min..max inclusive, NaN when no frame has a value
+function rangeMean(series, min, max){
+    var count = series.count[max + 1] - series.count[min]
+    if (count == 0){
+        return NaN
+    }
+    return series.offset + (series.sum[max + 1] - series.sum[min]) / count
+}
+
+// Largest value over frames min..max inclusive: whole blocks from the sparse table,
+// the partial blocks at either end from the values themselves. NaN when the range
+// is empty or no frame in it has a value.
+function rangeMax(series, min, max){
+    if (min > max){
+        return NaN
+    }
+    var result = -Infinity
+    var scan = (from, to) => {
+        for (var i = from; i <= to; ++i){
+            if (series.values[i] > result){
+                result = series.values[i]
+            }
+        }
+    }
+    var first_block = Math.floor(min / series.block_size)
+    var last_block = Math.floor(max / series.block_size)
+    if (first_block == last_block){
+        scan(min, max)
+        return result == -Infinity ? NaN : result
+    }
+    scan(min, (first_block + 1) * series.block_size - 1)
+    scan(last_block * series.block_size, max)
+    if (last_block - first_block > 1){
+        var from = first_block + 1, to = last_block - 1
+        var k = Math.floor(Math.log2(to - from + 1))
+        result = Math.max(result, series.block_max[k][from], series.block_max[k][to - (1 << k) + 1])
+    }
+    // Blocks without a single value hold -Infinity in the index
+    return result == -Infinity ? NaN : result
+}
+
+// Joint names in astra::JointType order, as in JointSchema.h
+const JOINT_NAMES = [
+    "Head", "Spine Top", "Left Shoulder", "Left Elbow", "Left Hand",
+    "Right Shoulder", "Right Elbow", "Right Hand", "Spine Middle", "Spine Base",
+    "Left Hip", "Left Knee", "Left Foot", "Right Hip", "Right Knee", "Right Foot",
+    "Left Wrist", "Right Wrist", "Neck"
+]
+
+// Maps the session.col the tracker writes into the patient directory (layout in
+// SessionFile.h) with typed arrays over a single read. Returns null when it is
+// missing or not a session file. Frames are built on access, so frames[i] looks
+// like a line of the old raw_data.txt without holding the session as objects.
+function loadSession(path){
+    if (!fs.existsSync(path)){
+        return null
+    }
+    var file = fs.readFileSync(path)
+    if (file.length < 64 || file.toString('ascii', 0, 4) !== 'ASES'){
+        return null
+    }
+    // Typed arrays need aligned offsets, which a pooled Buffer does not guarantee
+    var data = file.byteOffset % 8 == 0 ? file.buffer : file.buffer.slice(file.byteOffset, file.byteOffset + file.length)
+    var base = data === file.buffer ? file.byteOffset : 0
+    var header = new Uint32Array(data, base, 16)
+    var n = header[2], f = header[3], joint_count = header[4]
+    if (header[1] !== 1 || joint_count !== JOINT_NAMES.length || header[5] !== 9){
+        return null
+    }
+    var section = (s) => base + header[6 + s]
+    var columns = {
+        "frame_number": new Uint32Array(data, section(0), n),
+        "time": new Uint32Array(data, section(1), n),
+        "timestamp_us": new Float64Array(data, section(2), n),
+        "body_id": new Uint8Array(data, section(3), n),
+        "joint_mask": new Uint32Array(data, section(4), n),
+        "joints": [],
+        "shoulder_angle": new Float32Array(data, section(6), n),
+        "hip_angle": new Float32Array(data, section(7), n),
+        "frame_offsets": new Uint32Array(data, section(8), f + 1)
+    }
+    for (var c = 0; c < joint_count * 3; c++){
+        columns.joints.push(new Float32Array(data, section(5) + c * n * 4, n))
+    }
+
+    var frames = {"length": n, "z_offset": 0, "y_offset": 0, "summaries": {}, "columns": columns}
+    var total_joints = 0
+    for (var j = 0; j < joint_count; j++){
+        var ys = columns.joints[j * 3 + 1], zs = columns.joints[j * 3 + 2]
+        var foot = JOINT_NAMES[j] == "Right Foot" || JOINT_NAMES[j] == "Left Foot"
+        for (var i = 0; i < n; i++){
+            if ((columns.joint_mask[i] & (1 << j)) && zs[i] > 400){
+                frames.z_offset += zs[i]
+                total_joints++
+                if (foot && ys[i] < frames.y_offset){
+                    frames.y_offset = ys[i]
+                }
+            }
+        }
+    }
+    frames.z_offset = frames.z_offset / total_joints
+
+    return new Proxy(frames, {
+        get: (target, key) => {
+            if (typeof key === 'string' && /^[0-9]+$/.test(key)){
+                return Number(key) < n ? sessionFrame(columns, Number(key)) : undefined
+            }
+            return target[key]
+        }
+    })
+}
+
+// Latest summary of every body from the summaries.txt the tracker writes next to
+// the session. Later summaries include everything the earlier ones did.
+function loadSummaries(path){
+    var summaries = {}
+    if (!fs.existsSync(path)){
+        return summaries
+    }
+    for (var line of fs.readFileSync(path, 'utf8').split("\n")){
+        if (line.length == 0){
+            continue
+        }
+        try {
+            var summary = JSON.parse(line)
+        }
+        catch (e){
+            // A capture that was killed can leave its last line cut short
+            continue
+        }
+        summaries[summary.body_id] = summary
+    }
+    return summaries
+}
+
+// Row i of the session as a raw_data.txt frame, dropping joints too close to be real
+function sessionFrame(columns, i){
+    var angle = (value) => isNaN(value) ? null : value
+    return {
+        "frame_number": columns.frame_number[i],
+        "time": columns.time[i],
+        "body_id": columns.body_id[i],
+        "shoulder_angle": angle(columns.shoulder_angle[i]),
+        "hip_angle": angle(columns.hip_angle[i]),
+        get joints(){
+            var joints = {}
+            for (var j = 0; j < JOINT_NAMES.length; j++){
+                var z = columns.joints[j * 3 + 2][i]
+                if ((columns.joint_mask[i] & (1 << j)) && z > 400){
+                    joints[JOINT_NAMES[j]] = {"x": columns.joints[j * 3][i], "y": columns.joints[j * 3 + 1][i], "z": z}
+                }
+            }
+            return joints
+        }
+    }
+}
+
 function addJoints(scene, frame){
     var joints = frame.joints
 
@@ -561,8 +812,55 @@ function addBones(scene, frame){
     return scene
 }
 
-function processResults(){
+// Runs the tracker over the patient directory with one of its offline options, such
+// as --convert or --index, without blocking the renderer. Resolves with whether it
+// exited cleanly.
+function runTracker(option){
     return new Promise((resolve) => {
+        const tracker = spawn(tracker_path, [current_patient.dir, option], { stdio: ['ignore', 'ignore', 'pipe'] })
+        var errors = ''
+        tracker.stderr.on('data', (data) => {
+            errors += data
+        })
+        tracker.on('error', (err) => {
+            console.log(`cannot run the tracker with ${option}: ${err}`)
+            resolve(false)
+        })
+        tracker.on('close', (code) => {
+            if (code !== 0){
+                console.log(`tracker ${option} exited with code ${code}: ${errors}`)
+            }
+            resolve(code === 0)
+        })
+    })
+}
+
+async function processResults(){
+    var index_path = current_patient.dir + 'raw_data.idx'
+    var attachIndex = async (frames) => {
+        frames.index = loadSessionIndex(index_path, frames.length)
+        // Older sessions have no index yet; the tracker can build one
+        if (!frames.index && frames.length > 0 && await runTracker('--index')){
+            frames.index = loadSessionIndex(index_path, frames.length)
+        }
+    }
+
+    var session_path = current_patient.dir + 'session.col'
+    var converted = fs.existsSync(session_path)
+    if (!converted &&
+        (fs.existsSync(current_patient.dir + 'session.rows') || fs.existsSync(current_patient.dir + 'raw_data.txt'))){
+        // A capture killed before it wrote session.col leaves its row journal, and sessions
+        // recorded before the tracker wrote session.col have raw_data.txt; either is converted once
+        converted = await runTracker('--convert')
+    }
+    var session = converted ? loadSession(session_path) : null
+    if (session){
+        session.summaries = loadSummaries(current_patient.dir + 'summaries.txt')
+        await attachIndex(session)
+        return session
+    }
+
+    var frames = await new Promise((resolve) => {
         var readStream = readline.createInterface({
             input: fs.createReadStream(current_patient.dir + 'raw_data.txt')
         })
@@ -571,10 +869,16 @@ function processResults(){
         frames.length = 0
         frames.z_offset = 0
         frames.y_offset = 0
+        frames.summaries = {}
         var total_joints = 0
 
         readStream.on('line', (line) => {
             var frame = JSON.parse(line)
+            // Later summaries include everything the earlier ones did
+            if (frame.summary){
+                frames.summaries[frame.body_id] = frame
+                return
+            }
             frames[frames.length] = frame
             for (var joint in frame.joints){
                 frames.z_offset += frame.joints[joint].z
@@ -591,4 +895,6 @@ function processResults(){
             resolve(frames)
         })
     })
+    await attachIndex(frames)
+    return frames
 }